@@ -0,0 +1,86 @@
+#include "Amount.h"
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+Amount amountFromCoins(double coins) {
+    return static_cast<Amount>(std::llround(coins * static_cast<double>(COIN)));
+}
+
+double amountToCoins(Amount amount) {
+    return static_cast<double>(amount) / static_cast<double>(COIN);
+}
+
+std::string formatAmount(Amount amount) {
+    // Unsigned so the most negative value doesn't overflow when negated
+    uint64_t magnitude = amount < 0 ? 0 - static_cast<uint64_t>(amount) : static_cast<uint64_t>(amount);
+    std::string fraction = std::to_string(magnitude % COIN);
+    std::string text = amount < 0 ? "-" : "";
+    text += std::to_string(magnitude / COIN);
+    text += '.';
+    text.append(AMOUNT_DECIMALS - fraction.size(), '0');
+    text += fraction;
+    return text;
+}
+
+bool parseAmount(const std::string& text, Amount& amount) {
+    size_t pos = 0;
+    bool negative = false;
+    if (pos < text.size() && (text[pos] == '-' || text[pos] == '+')) {
+        negative = text[pos] == '-';
+        pos++;
+    }
+    
+    uint64_t whole = 0;
+    uint64_t fraction = 0;
+    int wholeDigits = 0;
+    int fractionDigits = 0;
+    const uint64_t maxWhole = static_cast<uint64_t>(std::numeric_limits<Amount>::max() / COIN);
+    
+    for (; pos < text.size() && text[pos] >= '0' && text[pos] <= '9'; pos++, wholeDigits++) {
+        whole = whole * 10 + static_cast<uint64_t>(text[pos] - '0');
+        if (whole > maxWhole) {
+            return false;
+        }
+    }
+    if (pos < text.size() && text[pos] == '.') {
+        pos++;
+        for (; pos < text.size() && text[pos] >= '0' && text[pos] <= '9'; pos++) {
+            // Digits past the last base unit must be zero to stay exact
+            if (fractionDigits == AMOUNT_DECIMALS) {
+                if (text[pos] != '0') break;
+                continue;
+            }
+            fraction = fraction * 10 + static_cast<uint64_t>(text[pos] - '0');
+            fractionDigits++;
+        }
+    }
+    
+    if (pos == text.size() && wholeDigits + fractionDigits > 0) {
+        for (int i = fractionDigits; i < AMOUNT_DECIMALS; i++) {
+            fraction *= 10;
+        }
+        // whole is at most maxWhole, but the fraction can still push it over
+        const uint64_t maxUnits = static_cast<uint64_t>(std::numeric_limits<Amount>::max());
+        if (fraction > maxUnits - whole * COIN) {
+            return false;
+        }
+        Amount units = static_cast<Amount>(whole * COIN + fraction);
+        amount = negative ? -units : units;
+        return true;
+    }
+    
+    // Exponents, excess precision and the like
+    try {
+        size_t used = 0;
+        double coins = std::stod(text, &used);
+        if (used != text.size() || !std::isfinite(coins) ||
+            std::fabs(coins) >= static_cast<double>(maxWhole)) {
+            return false;
+        }
+        amount = amountFromCoins(coins);
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
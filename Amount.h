@@ -0,0 +1,26 @@
+#ifndef AMOUNT_H
+#define AMOUNT_H
+
+#include <cstdint>
+#include <string>
+
+// Ledger amounts are whole base units, 1 $CLST = COIN units, so balances
+// add up exactly and every node replays the chain to the same numbers.
+// Doubles only appear at the edges: user input and old stored records.
+using Amount = int64_t;
+
+const Amount COIN = 100000000;
+const int AMOUNT_DECIMALS = 8;
+
+// Nearest base-unit amount for a value in coins, and back
+Amount amountFromCoins(double coins);
+double amountToCoins(Amount amount);
+
+// Exact decimal text in coins, e.g. "12.50000000"
+std::string formatAmount(Amount amount);
+
+// Parses decimal text in coins ("12.5", "0.010000", "-3"). Exact up to
+// AMOUNT_DECIMALS places; other forms such as "1e-05" go through a double.
+bool parseAmount(const std::string& text, Amount& amount);
+
+#endif // AMOUNT_H
@@ -0,0 +1,77 @@
+#include "BalanceCache.h"
+#include <functional>
+
+BalanceCache::BalanceCache(size_t capacity)
+    : shardCapacity(capacity / SHARD_COUNT + 1), hits(0), misses(0) {
+}
+
+BalanceCache::Shard& BalanceCache::shardFor(const std::string& address) {
+    return shards[std::hash<std::string>()(address) % SHARD_COUNT];
+}
+
+const BalanceCache::Shard& BalanceCache::shardFor(const std::string& address) const {
+    return shards[std::hash<std::string>()(address) % SHARD_COUNT];
+}
+
+bool BalanceCache::lookup(const std::string& address, Amount& balance) const {
+    const Shard& shard = shardFor(address);
+    
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.entries.find(address);
+    if (found == shard.entries.end()) {
+        misses++;
+        return false;
+    }
+    hits++;
+    balance = found->second;
+    return true;
+}
+
+void BalanceCache::makeRoom(Shard& shard) {
+    // Drop entries until there is space; they reload from disk
+    for (auto it = shard.entries.begin(); it != shard.entries.end() && shard.entries.size() >= shardCapacity;) {
+        it = shard.entries.erase(it);
+    }
+}
+
+void BalanceCache::fill(const std::string& address, Amount balance) {
+    Shard& shard = shardFor(address);
+    
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.entries.count(address)) {
+        return;
+    }
+    makeRoom(shard);
+    shard.entries.emplace(address, balance);
+}
+
+void BalanceCache::markCommitted(const std::map<std::string, Amount>& balances) {
+    for (const auto& [address, balance] : balances) {
+        Shard& shard = shardFor(address);
+        
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto found = shard.entries.find(address);
+        if (found == shard.entries.end()) {
+            makeRoom(shard);
+            shard.entries.emplace(address, balance);
+            continue;
+        }
+        found->second = balance;
+    }
+}
+
+void BalanceCache::clear() {
+    for (Shard& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.entries.clear();
+    }
+}
+
+size_t BalanceCache::size() const {
+    size_t total = 0;
+    for (const Shard& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.entries.size();
+    }
+    return total;
+}
@@ -0,0 +1,55 @@
+#ifndef BALANCECACHE_H
+#define BALANCECACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "Amount.h"
+
+// Balances kept in memory in front of the balance: records, so a lookup is
+// a hash probe instead of a LevelDB Get plus a string parse. Every entry
+// matches what is on disk: values come from reads or from a commit that
+// already reached the database, so any of them may be dropped when a shard
+// fills up.
+class BalanceCache {
+public:
+    explicit BalanceCache(size_t capacity = DEFAULT_CAPACITY);
+
+    BalanceCache(const BalanceCache&) = delete;
+    BalanceCache& operator=(const BalanceCache&) = delete;
+
+    bool lookup(const std::string& address, Amount& balance) const;
+    // Value just read from the database; never overrides a cached entry
+    void fill(const std::string& address, Amount balance);
+    // These balances are now on disk
+    void markCommitted(const std::map<std::string, Amount>& balances);
+    void clear();
+
+    size_t size() const;
+    uint64_t getHits() const { return hits.load(); }
+    uint64_t getMisses() const { return misses.load(); }
+
+    static const size_t DEFAULT_CAPACITY = 262144;
+
+private:
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Amount> entries;
+    };
+
+    static const size_t SHARD_COUNT = 16;
+
+    Shard& shardFor(const std::string& address);
+    const Shard& shardFor(const std::string& address) const;
+    void makeRoom(Shard& shard);
+
+    size_t shardCapacity;
+    Shard shards[SHARD_COUNT];
+    mutable std::atomic<uint64_t> hits;
+    mutable std::atomic<uint64_t> misses;
+};
+
+#endif // BALANCECACHE_H
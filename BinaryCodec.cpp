@@ -0,0 +1,196 @@
+#include "BinaryCodec.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+// Tag byte in front of every hex string
+const uint8_t HEX_ENCODED = 0x01;  // Payload is raw bytes, not text
+const uint8_t HEX_PREFIX = 0x02;   // Text started with "0x"
+const uint8_t HEX_ODD = 0x04;      // Text had an odd digit count; drop the leading '0'
+const uint8_t HEX_UPPER = 0x08;    // Letters were upper case
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
+void BinaryWriter::writeVarint(uint64_t value) {
+    while (value >= 0x80) {
+        writeByte(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    writeByte(static_cast<uint8_t>(value));
+}
+
+void BinaryWriter::writeSignedVarint(int64_t value) {
+    writeVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void BinaryWriter::writeDouble(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 8; i++) {
+        writeByte(static_cast<uint8_t>(bits >> (8 * i)));
+    }
+}
+
+void BinaryWriter::writeString(const std::string& value) {
+    writeVarint(value.size());
+    buffer.append(value);
+}
+
+void BinaryWriter::writeHexString(const std::string& value) {
+    size_t start = (value.compare(0, 2, "0x") == 0) ? 2 : 0;
+    size_t digits = value.size() - start;
+    
+    // Only take the compact path when the text can be rebuilt exactly:
+    // at least one digit, all hex, and letters in a single case
+    bool hasLower = false;
+    bool hasUpper = false;
+    bool clean = digits > 0;
+    for (size_t i = start; i < value.size() && clean; i++) {
+        char c = value[i];
+        if (hexValue(c) < 0) {
+            clean = false;
+        } else if (c >= 'a' && c <= 'f') {
+            hasLower = true;
+        } else if (c >= 'A' && c <= 'F') {
+            hasUpper = true;
+        }
+    }
+    if (!clean || (hasLower && hasUpper)) {
+        writeByte(0);
+        writeString(value);
+        return;
+    }
+    
+    uint8_t tag = HEX_ENCODED;
+    if (start == 2) tag |= HEX_PREFIX;
+    if (digits % 2 != 0) tag |= HEX_ODD;
+    if (hasUpper) tag |= HEX_UPPER;
+    writeByte(tag);
+    
+    size_t byteCount = (digits + 1) / 2;
+    writeVarint(byteCount);
+    size_t pos = start;
+    if (digits % 2 != 0) {
+        writeByte(static_cast<uint8_t>(hexValue(value[pos++])));
+        byteCount--;
+    }
+    for (size_t i = 0; i < byteCount; i++, pos += 2) {
+        writeByte(static_cast<uint8_t>((hexValue(value[pos]) << 4) | hexValue(value[pos + 1])));
+    }
+}
+
+void BinaryReader::require(size_t count) const {
+    if (remaining() < count) {
+        throw std::runtime_error("Truncated binary record");
+    }
+}
+
+uint8_t BinaryReader::readByte() {
+    require(1);
+    return static_cast<uint8_t>(*current++);
+}
+
+uint64_t BinaryReader::readVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t byte = readByte();
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Varint too long");
+}
+
+int64_t BinaryReader::readSignedVarint() {
+    uint64_t value = readVarint();
+    return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+double BinaryReader::readDouble() {
+    require(8);
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; i++) {
+        bits |= static_cast<uint64_t>(static_cast<uint8_t>(current[i])) << (8 * i);
+    }
+    current += 8;
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+std::string BinaryReader::readString() {
+    return std::string(readStringView());
+}
+
+std::string_view BinaryReader::readStringView() {
+    uint64_t length = readVarint();
+    require(length);
+    std::string_view value(current, length);
+    current += length;
+    return value;
+}
+
+void BinaryReader::readHexField(uint8_t& tag, std::string_view& payload) {
+    tag = readByte();
+    payload = readStringView();
+}
+
+std::string BinaryReader::readHexString() {
+    uint8_t tag;
+    std::string_view payload;
+    readHexField(tag, payload);
+    return hexFieldToString(tag, payload);
+}
+
+std::string BinaryReader::hexFieldToString(uint8_t tag, std::string_view payload) {
+    if (!(tag & HEX_ENCODED)) {
+        return std::string(payload);
+    }
+    
+    const char* digits = (tag & HEX_UPPER) ? "0123456789ABCDEF" : "0123456789abcdef";
+    std::string value;
+    value.reserve(payload.size() * 2 + 2);
+    if (tag & HEX_PREFIX) {
+        value += "0x";
+    }
+    for (size_t i = 0; i < payload.size(); i++) {
+        uint8_t byte = static_cast<uint8_t>(payload[i]);
+        if (i > 0 || !(tag & HEX_ODD)) {
+            value += digits[byte >> 4];
+        }
+        value += digits[byte & 0x0f];
+    }
+    return value;
+}
+
+bool BinaryReader::hexFieldEquals(uint8_t tag, std::string_view payload, const std::string& text) {
+    if (!(tag & HEX_ENCODED)) {
+        return payload == text;
+    }
+    
+    size_t start = (tag & HEX_PREFIX) ? 2 : 0;
+    size_t digitCount = payload.size() * 2 - ((tag & HEX_ODD) && !payload.empty() ? 1 : 0);
+    if (text.size() != start + digitCount || (start && text.compare(0, 2, "0x") != 0)) {
+        return false;
+    }
+    
+    const char* digits = (tag & HEX_UPPER) ? "0123456789ABCDEF" : "0123456789abcdef";
+    size_t pos = start;
+    for (size_t i = 0; i < payload.size(); i++) {
+        uint8_t byte = static_cast<uint8_t>(payload[i]);
+        if (i > 0 || !(tag & HEX_ODD)) {
+            if (text[pos++] != digits[byte >> 4]) return false;
+        }
+        if (text[pos++] != digits[byte & 0x0f]) return false;
+    }
+    return true;
+}
@@ -0,0 +1,61 @@
+#ifndef BINARYCODEC_H
+#define BINARYCODEC_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Compact binary encoding helpers for the storage format.
+// Integers are LEB128 varints, doubles are their 8 IEEE-754 bytes in
+// little-endian order, and strings are length-prefixed. Hex strings
+// (hashes, keys, signatures, addresses) are stored as raw bytes with a
+// tag byte recording how to rebuild the exact original text.
+class BinaryWriter {
+public:
+    void writeByte(uint8_t value) { buffer.push_back(static_cast<char>(value)); }
+    void writeVarint(uint64_t value);
+    void writeSignedVarint(int64_t value);  // Zigzag encoded
+    void writeDouble(double value);
+    void writeString(const std::string& value);
+    // Stores hex text as bytes; anything that isn't clean hex is kept as is
+    void writeHexString(const std::string& value);
+
+    const std::string& data() const { return buffer; }
+    std::string release() { return std::move(buffer); }
+
+private:
+    std::string buffer;
+};
+
+// Reads what BinaryWriter wrote. Throws std::runtime_error on truncated or
+// malformed input.
+class BinaryReader {
+public:
+    BinaryReader(const char* data, size_t size) : current(data), end(data + size) {}
+    explicit BinaryReader(const std::string& data) : BinaryReader(data.data(), data.size()) {}
+
+    uint8_t readByte();
+    uint64_t readVarint();
+    int64_t readSignedVarint();
+    double readDouble();
+    std::string readString();
+    std::string readHexString();
+    // Same as above without copying: the views point into the input buffer
+    std::string_view readStringView();
+    void readHexField(uint8_t& tag, std::string_view& payload);
+
+    // Rebuild or compare the text of a field read with readHexField
+    static std::string hexFieldToString(uint8_t tag, std::string_view payload);
+    static bool hexFieldEquals(uint8_t tag, std::string_view payload, const std::string& text);
+
+    bool atEnd() const { return current == end; }
+    size_t remaining() const { return static_cast<size_t>(end - current); }
+
+private:
+    void require(size_t count) const;
+
+    const char* current;
+    const char* end;
+};
+
+#endif // BINARYCODEC_H
@@ -1,5 +1,6 @@
 #include "Block.h"
 #include "sha.h"
+#include "Miner.h"
 #include "Blockchain.h" // Include for genesis block constants
 
 Block::Block(int blockNumber, std::vector<Transaction> txs, std::string prevHash, int diff) {
@@ -9,6 +10,7 @@ Block::Block(int blockNumber, std::vector<Transaction> txs, std::string prevHash
         previousHash = prevHash;
         nonce = 0;
         difficulty = diff < 1 ? 1 : diff;  // Ensure minimum difficulty of 1
+        version = CURRENT_VERSION;
         timestamp = time(nullptr);
         
         // Special handling for genesis block
@@ -29,6 +31,7 @@ Block::Block(int blockNumber, std::vector<Transaction> txs, std::string prevHash
         previousHash = prevHash;
         nonce = 0;
         difficulty = 1;
+        version = CURRENT_VERSION;
         timestamp = time(nullptr);
         // Create a simple hash without transactions to avoid errors
         std::string data = std::to_string(blockNumber) + std::to_string(timestamp) + previousHash + "0";
@@ -36,43 +39,52 @@ Block::Block(int blockNumber, std::vector<Transaction> txs, std::string prevHash
     }
 }
 
+Block::Block(int blockNumber, time_t timestamp, std::vector<Transaction> txs, std::string prevHash,
+             std::string hash, int nonce, int diff, int version)
+    : blockNumber(blockNumber), timestamp(timestamp), transactions(std::move(txs)),
+      previousHash(std::move(prevHash)), hash(std::move(hash)), nonce(nonce),
+      difficulty(diff), version(version) {
+}
+
 std::string Block::calculateHash() const {
     // For genesis block, don't recalculate the hash - it has a fixed value
     if (blockNumber == 0) {
         return Blockchain::GENESIS_HASH;
     }
     
-    std::string data = std::to_string(blockNumber) + std::to_string(timestamp) + previousHash + std::to_string(nonce);
-    for (const auto& tx : transactions) {
-        data += tx.sender + tx.receiver + std::to_string(tx.amount);
+    std::string data;
+    if (version == VERSION_LEGACY) {
+        data = headerPrefix() + std::to_string(nonce) + transactionPayload();
+    } else {
+        data = headerPrefix() + transactionPayload() + std::to_string(nonce);
     }
     return "0x" + computeSHA256(data);
 }
 
+std::string Block::headerPrefix() const {
+    return std::to_string(blockNumber) + std::to_string(timestamp) + previousHash;
+}
+
+std::string Block::transactionPayload() const {
+    std::string data;
+    for (const auto& tx : transactions) {
+        data += tx.sender + tx.receiver + tx.amountEncoding();
+    }
+    return data;
+}
+
 std::string Block::simpleHash(const std::string& str) const {
     return "0x" + computeSHA256(str);
 }
 
 std::string Block::mineBlock() {
-    std::string target = ""; // adding leading zeros to the target hash
-    for (int i = 0; i < difficulty; i++) {
-        target += "0";
-    }
-    while (true) { // bruteforce the nonce until
-                   // the hash with leading zeros is found
-        nonce++;
-        std::string hash = calculateHash();
-        
-        // Strip 0x prefix for difficulty check
-        std::string hashNoPrefix = hash;
-        if (hashNoPrefix.substr(0, 2) == "0x") {
-            hashNoPrefix = hashNoPrefix.substr(2);
-        }
-        
-        if (hashNoPrefix.substr(0, difficulty) == target) {
-            return hash;
-        }
-    }
+    // Bruteforce the nonce on all cores until a hash with enough leading
+    // zeros is found. The miner returns the lowest such nonce after the
+    // current one, the same result a sequential search would give.
+    Miner miner;
+    std::string minedHash;
+    nonce = miner.findNonce(*this, minedHash);
+    return minedHash;
 }
 
 // Implement the validateTransactions method
@@ -95,7 +107,9 @@ bool Block::validateTransactions() const {
         return transactions[0].isValid();
     }
     
-    // For regular blocks, validate each transaction and check coinbase count
+    // Structural rules first, in block order so the result is deterministic
+    std::vector<const Transaction*> toVerify;
+    toVerify.reserve(transactions.size());
     for (const auto& tx : transactions) {
         // Check if it's a coinbase transaction
         if (tx.sender == "Genesis" && tx.receiver != "Genesis") {
@@ -107,12 +121,7 @@ bool Block::validateTransactions() const {
                 return false;
             }
         }
-        
-        // Verify each transaction is valid
-        if (!tx.isValid()) {
-            std::cerr << "ERROR: Block contains invalid transaction: " << tx.hash << std::endl;
-            return false;
-        }
+        toVerify.push_back(&tx);
     }
     
     // Check that there is exactly one coinbase transaction (reward)
@@ -123,5 +132,12 @@ bool Block::validateTransactions() const {
         return false;
     }
     
+    // Hash, address and signature checks fan out across the thread pool
+    size_t invalid = Transaction::findInvalid(toVerify);
+    if (invalid < toVerify.size()) {
+        std::cerr << "ERROR: Block contains invalid transaction: " << toVerify[invalid]->hash << std::endl;
+        return false;
+    }
+    
     return true;
 } 
\ No newline at end of file
@@ -18,12 +18,31 @@ public:
     std::string hash;
     int nonce;
     int difficulty;
+    int version;    // Hash layout used by calculateHash
 
+    // Legacy layout hashes the nonce before the transactions, so every nonce
+    // rehashes the whole block. The midstate layout puts the nonce last, so
+    // mining can reuse the SHA-256 state of everything in front of it.
+    static const int VERSION_LEGACY = 1;
+    static const int VERSION_MIDSTATE = 2;
+    static const int CURRENT_VERSION = VERSION_MIDSTATE;
+
+    // Constructor for new blocks; mines every block except genesis
     Block(int blockNumber, std::vector<Transaction> txs, std::string prevHash, int diff);
+    
+    // Constructor for recreating blocks from network/storage; keeps the
+    // given hash and nonce and never mines
+    Block(int blockNumber, time_t timestamp, std::vector<Transaction> txs, std::string prevHash,
+          std::string hash, int nonce, int diff, int version);
    
     std::string calculateHash() const;
     std::string mineBlock();
     
+    // Hash input pieces around the nonce, used by the miner to avoid
+    // rebuilding the whole string for every candidate nonce
+    std::string headerPrefix() const;
+    std::string transactionPayload() const;
+    
     // Method to validate block transactions
     bool validateTransactions() const;
 
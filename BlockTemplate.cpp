@@ -0,0 +1,72 @@
+#include "BlockTemplate.h"
+#include <iostream>
+#include <unordered_map>
+
+BlockTemplateBuilder::BlockTemplateBuilder(size_t maxBlockBytes, size_t maxBlockTransactions)
+    : maxBlockBytes(maxBlockBytes), maxBlockTransactions(maxBlockTransactions) {
+}
+
+size_t BlockTemplateBuilder::serializedSize(const Transaction& tx) {
+    // sender|publicKey|receiver|amount|timestamp|hash|signature plus the
+    // leading separator
+    return tx.sender.size() + tx.senderPublicKey.size() + tx.receiver.size() +
+           tx.amountEncoding().size() + std::to_string(tx.timestamp).size() +
+           tx.hash.size() + tx.signature.size() + 7;
+}
+
+std::vector<Transaction> BlockTemplateBuilder::selectTransactions(const Mempool& pool, const BalanceMapping* balances,
+                                                                  size_t reservedBytes,
+                                                                  size_t reservedTransactions) const {
+    std::vector<Transaction> selected;
+    if (reservedBytes >= maxBlockBytes || reservedTransactions >= maxBlockTransactions) {
+        return selected;
+    }
+    size_t bytesLeft = maxBlockBytes - reservedBytes;
+    size_t slotsLeft = maxBlockTransactions - reservedTransactions;
+    
+    // Remaining spendable balance per sender, filled in on first use
+    std::unordered_map<std::string, Amount> remaining;
+    size_t skippedForBalance = 0;
+    size_t skippedForSize = 0;
+    
+    for (const Transaction* tx : pool.byPriority()) {
+        if (slotsLeft == 0) {
+            break;
+        }
+        
+        // A large transaction that doesn't fit may still leave room for
+        // smaller ones behind it
+        size_t size = serializedSize(*tx);
+        if (size > bytesLeft) {
+            skippedForSize++;
+            continue;
+        }
+        
+        if (balances && tx->sender != "Genesis") {
+            auto found = remaining.find(tx->sender);
+            if (found == remaining.end()) {
+                Amount balance = 0;
+                if (!balances->getBalance(tx->sender, balance)) {
+                    balance = 0;
+                }
+                found = remaining.emplace(tx->sender, balance).first;
+            }
+            if (found->second < tx->amount) {
+                skippedForBalance++;
+                continue;
+            }
+            found->second -= tx->amount;
+        }
+        
+        selected.push_back(*tx);
+        bytesLeft -= size;
+        slotsLeft--;
+    }
+    
+    if (skippedForBalance > 0 || skippedForSize > 0 || selected.size() < pool.size()) {
+        std::cout << "Block template: selected " << selected.size() << " of " << pool.size()
+                  << " pending transactions (" << skippedForBalance << " over balance, "
+                  << skippedForSize << " too large)" << std::endl;
+    }
+    return selected;
+}
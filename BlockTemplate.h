@@ -0,0 +1,41 @@
+#ifndef BLOCKTEMPLATE_H
+#define BLOCKTEMPLATE_H
+
+#include <string>
+#include <vector>
+#include "Transaction.h"
+#include "Mempool.h"
+#include "balanceMapping.h"
+
+// Picks the mempool transactions that go into the next block.
+// Walks the pool in priority order and stops adding once the byte or
+// transaction limit is reached. Each sender's confirmed balance is read
+// once and debited as their transactions are picked, so a sender whose
+// pending transactions overspend only gets the ones they can cover.
+// Anything not picked stays in the mempool for a later block.
+class BlockTemplateBuilder {
+public:
+    BlockTemplateBuilder(size_t maxBlockBytes = DEFAULT_MAX_BLOCK_BYTES,
+                         size_t maxBlockTransactions = DEFAULT_MAX_BLOCK_TRANSACTIONS);
+
+    // balances may be null, in which case no balance checks are made.
+    // reservedBytes/reservedTransactions leave room for the coinbase.
+    std::vector<Transaction> selectTransactions(const Mempool& pool, const BalanceMapping* balances,
+                                                size_t reservedBytes = 0,
+                                                size_t reservedTransactions = 0) const;
+
+    // Size of a transaction in the text block format used on the wire
+    static size_t serializedSize(const Transaction& tx);
+
+    size_t getMaxBlockBytes() const { return maxBlockBytes; }
+    size_t getMaxBlockTransactions() const { return maxBlockTransactions; }
+
+    static const size_t DEFAULT_MAX_BLOCK_BYTES = 1024 * 1024;
+    static const size_t DEFAULT_MAX_BLOCK_TRANSACTIONS = 2000;
+
+private:
+    size_t maxBlockBytes;
+    size_t maxBlockTransactions;
+};
+
+#endif // BLOCKTEMPLATE_H
@@ -0,0 +1,35 @@
+#include "BlockTree.h"
+#include <algorithm>
+
+const BlockTree::Entry* BlockTree::find(const std::string& hash) const {
+    auto found = entries.find(hash);
+    return found == entries.end() ? nullptr : &found->second;
+}
+
+void BlockTree::add(std::shared_ptr<const Block> block, double chainWork) {
+    std::string hash = block->hash;
+    entries[hash] = Entry{std::move(block), chainWork};
+}
+
+void BlockTree::remove(const std::string& hash) {
+    entries.erase(hash);
+}
+
+std::vector<std::shared_ptr<const Block>> BlockTree::branch(const std::string& tipHash) const {
+    std::vector<std::shared_ptr<const Block>> blocks;
+    for (const Entry* entry = find(tipHash); entry; entry = find(entry->block->previousHash)) {
+        blocks.push_back(entry->block);
+    }
+    std::reverse(blocks.begin(), blocks.end());
+    return blocks;
+}
+
+void BlockTree::prune(size_t minHeight) {
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (static_cast<size_t>(it->second.block->blockNumber) < minHeight) {
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
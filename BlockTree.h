@@ -0,0 +1,43 @@
+#ifndef BLOCKTREE_H
+#define BLOCKTREE_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Block.h"
+
+// Blocks we hold off the main chain, keyed by hash. Together with the main
+// chain in ChainStore they form the block tree: each entry's parent is
+// either on the main chain or another entry here. Every entry carries the
+// total work of its branch, so a branch tip can be weighed against the main
+// chain without walking either of them.
+class BlockTree {
+public:
+    struct Entry {
+        std::shared_ptr<const Block> block;
+        double chainWork;  // Work of genesis up to this block along its branch
+    };
+
+    bool contains(const std::string& hash) const { return entries.count(hash) > 0; }
+    // Null if the hash isn't on a side branch
+    const Entry* find(const std::string& hash) const;
+
+    void add(std::shared_ptr<const Block> block, double chainWork);
+    void remove(const std::string& hash);
+
+    // The branch ending at tipHash, from its first block off the main chain
+    // up to the tip. Empty if tipHash isn't here.
+    std::vector<std::shared_ptr<const Block>> branch(const std::string& tipHash) const;
+
+    // Forget blocks below minHeight; a branch forking that deep would need
+    // more work than we are willing to keep blocks around for
+    void prune(size_t minHeight);
+
+    size_t size() const { return entries.size(); }
+
+private:
+    std::unordered_map<std::string, Entry> entries;
+};
+
+#endif // BLOCKTREE_H
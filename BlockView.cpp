@@ -0,0 +1,26 @@
+#include "BlockView.h"
+#include "BinaryCodec.h"
+
+std::string HexFieldView::toString() const {
+    return BinaryReader::hexFieldToString(tag, payload);
+}
+
+bool HexFieldView::equals(const std::string& text) const {
+    return BinaryReader::hexFieldEquals(tag, payload, text);
+}
+
+Transaction TransactionView::toTransaction() const {
+    return Transaction(sender.toString(), senderPublicKey.toString(), receiver.toString(),
+                       amount, hash.toString(), signature.toString(), timestamp, version);
+}
+
+Block BlockView::toBlock() const {
+    std::vector<Transaction> txs;
+    txs.reserve(transactions.size());
+    for (const auto& tx : transactions) {
+        txs.push_back(tx.toTransaction());
+    }
+    
+    return Block(blockNumber, timestamp, std::move(txs), previousHash.toString(), hash.toString(),
+                 nonce, difficulty, version);
+}
@@ -0,0 +1,56 @@
+#ifndef BLOCKVIEW_H
+#define BLOCKVIEW_H
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Block.h"
+#include "Transaction.h"
+
+// Read-only views of stored blocks and transactions.
+// Fields point straight into the buffer they were parsed from (normally a
+// LevelDB iterator value), so walking history does not allocate per field.
+// A view is only valid while that buffer is; call toBlock()/toTransaction()
+// to keep a copy.
+
+// A hash/key/address field as stored: raw bytes plus the tag describing how
+// to turn them back into text
+struct HexFieldView {
+    uint8_t tag = 0;
+    std::string_view payload;
+
+    std::string toString() const;
+    bool equals(const std::string& text) const;  // Compares without allocating
+};
+
+struct TransactionView {
+    HexFieldView sender;
+    HexFieldView senderPublicKey;
+    HexFieldView receiver;
+    Amount amount = 0;
+    unsigned long timestamp = 0;
+    HexFieldView hash;
+    HexFieldView signature;
+    int version = Transaction::VERSION_LEGACY;
+
+    Transaction toTransaction() const;
+};
+
+struct BlockView {
+    int blockNumber = 0;
+    time_t timestamp = 0;
+    HexFieldView previousHash;
+    HexFieldView hash;
+    int nonce = 0;
+    int difficulty = 0;
+    int version = Block::VERSION_LEGACY;
+    // Reused across parses, so a BlockView kept for a whole scan only
+    // allocates until it has seen its largest block
+    std::vector<TransactionView> transactions;
+
+    Block toBlock() const;
+};
+
+#endif // BLOCKVIEW_H
@@ -1,6 +1,7 @@
 #include "Blockchain.h"
 #include <iostream>
 #include <cmath> // For pow function
+#include <unordered_set>
 
 // Define the halving interval constant 
 const int Blockchain::HALVING_INTERVAL_DAYS = 30;
@@ -9,10 +10,13 @@ const int Blockchain::HALVING_INTERVAL_DAYS = 30;
 const time_t     Blockchain::GENESIS_TIMESTAMP = 1745026508;
 const int Blockchain::GENESIS_NONCE     =  27701;
 const std::string Blockchain::GENESIS_HASH      = "0x0000eb99d08f42f3c322b891f18212c85aa05365166964973a56d03e7da36f80";
-const double Blockchain::INITIAL_MINING_REWARD = 50.0; // Initial mining reward of 50 coins per block
+const Amount Blockchain::INITIAL_MINING_REWARD = 50 * COIN; // Initial mining reward of 50 coins per block
+const Amount Blockchain::MINIMUM_MINING_REWARD = COIN / 100;
+const size_t Blockchain::DEFAULT_SNAPSHOT_INTERVAL = 100;
+const size_t Blockchain::MAX_REORG_DEPTH = 1000;
 
 // Calculate the current mining reward based on time since genesis
-double Blockchain::calculateCurrentMiningReward() const {
+Amount Blockchain::calculateCurrentMiningReward() const {
     // Get current time
     time_t currentTime = time(nullptr);
     
@@ -24,27 +28,29 @@ double Blockchain::calculateCurrentMiningReward() const {
     int numberOfHalvings = daysSinceGenesis / HALVING_INTERVAL_DAYS;
     
     // Calculate current reward: initial_reward / (2^numberOfHalvings)
-    double currentReward = INITIAL_MINING_REWARD;
-    for (int i = 0; i < numberOfHalvings; i++) {
-        currentReward /= 2.0;
+    Amount currentReward = INITIAL_MINING_REWARD;
+    for (int i = 0; i < numberOfHalvings && currentReward > MINIMUM_MINING_REWARD; i++) {
+        currentReward /= 2;
     }
     
     // Ensure minimum reward of 0.01 coins
-    if (currentReward < 0.01) {
-        currentReward = 0.01;
+    if (currentReward < MINIMUM_MINING_REWARD) {
+        currentReward = MINIMUM_MINING_REWARD;
     }
     
     return currentReward;
 }
 
 // Public method to get the current mining reward
-double Blockchain::getCurrentMiningReward() const {
+Amount Blockchain::getCurrentMiningReward() const {
     return calculateCurrentMiningReward();
 }
 
-Blockchain::Blockchain(int difficulty) : difficulty(difficulty), db(nullptr), balanceMap(nullptr) {
+Blockchain::Blockchain(int difficulty)
+    : difficulty(difficulty), db(nullptr), balanceMap(nullptr), snapshotInterval(DEFAULT_SNAPSHOT_INTERVAL) {
     std::vector<Transaction> genesisTransactions;
     Transaction genesisTx("Genesis", "Genesis", 0);
+    genesisTx.version = Transaction::VERSION_LEGACY; // Keeps the genesis block unchanged
     genesisTx.hash = genesisTx.calculateHash();
     genesisTransactions.push_back(genesisTx);
     
@@ -52,7 +58,7 @@ Blockchain::Blockchain(int difficulty) : difficulty(difficulty), db(nullptr), ba
     genesisBlock.timestamp = GENESIS_TIMESTAMP;
     genesisBlock.nonce     = GENESIS_NONCE;
     genesisBlock.hash      = GENESIS_HASH;
-    chain.push_back(genesisBlock);
+    chain.append(genesisBlock);
     
     std::cout << "Blockchain initialized with genesis block: " << genesisBlock.hash << std::endl;
 }
@@ -64,14 +70,11 @@ void Blockchain::addBlock(const std::vector<Transaction>& transactions) {
         throw std::runtime_error("ERROR: Block contains invalid transactions");
     }
     
-    chain.push_back(newBlock);
+    chain.append(newBlock);
     
-    if (balanceMap) {
-        updateBalancesForBlock(newBlock);
-    }
-    
-    if (db && !db->saveBlock(newBlock)) {
-        std::cerr << "Failed to save block to database: " << db->getLastError() << std::endl;
+    if (!commitBlock(newBlock)) {
+        chain.popTip();
+        throw std::runtime_error("ERROR: Block #" + std::to_string(newBlock.blockNumber) + " could not be committed");
     }
     
     std::cout << "Block #" << newBlock.blockNumber << " added to the blockchain." << std::endl;
@@ -79,57 +82,211 @@ void Blockchain::addBlock(const std::vector<Transaction>& transactions) {
 }
 
 void Blockchain::addExistingBlock(const Block& block) {
-    if(block.previousHash != getLatestBlock().hash && block.blockNumber!=getLatestBlock().blockNumber){
+    // Already on the main chain or a side branch
+    if (isKnownBlock(block.hash)) {
+        return;
+    }
+    
+    // Find the parent and the work of the chain up to it
+    size_t parentHeight = 0;
+    double parentWork = 0;
+    if (chain.findHeight(block.previousHash, parentHeight)) {
+        parentWork = chain.chainWork(parentHeight);
+    } else if (const BlockTree::Entry* parent = sideBranches.find(block.previousHash)) {
+        parentHeight = parent->block->blockNumber;
+        parentWork = parent->chainWork;
+    } else {
         throw std::runtime_error("Blockchain integrity compromised. Previous hash mismatch. Previous hash: " + block.previousHash + " Current hash: " + getLatestBlock().hash);
     }
     
-    if (block.blockNumber==getLatestBlock().blockNumber && block.hash==getLatestBlock().hash && block.previousHash==getLatestBlock().previousHash){
+    if (static_cast<size_t>(block.blockNumber) != parentHeight + 1) {
+        throw std::runtime_error("Block #" + std::to_string(block.blockNumber) + " does not follow its parent #" + std::to_string(parentHeight));
+    }
+    // Work is weighed by the difficulty a block claims, so the claim must be
+    // one this chain asks for and the hash must live up to it
+    if (block.difficulty < difficulty) {
+        throw std::runtime_error("Block #" + std::to_string(block.blockNumber) + " has difficulty " + std::to_string(block.difficulty) + ", below the required " + std::to_string(difficulty));
+    }
+    if (!meetsDifficulty(block.hash, block.difficulty)) {
+        throw std::runtime_error("Block #" + std::to_string(block.blockNumber) + " does not meet its difficulty of " + std::to_string(block.difficulty));
+    }
+    if (block.hash != block.calculateHash()) {
+        throw std::runtime_error("Block #" + std::to_string(block.blockNumber) + " has an incorrect hash: " + block.hash);
+    }
+    if (!block.validateTransactions()) {
+        throw std::runtime_error("ERROR: Received block contains invalid transactions");
+    }
+    for (const auto& tx : block.transactions) {
+        if (!tx.hasExactAmount()) {
+            throw std::runtime_error("ERROR: Received block has legacy transaction " + tx.hash + " whose hash doesn't fix its amount");
+        }
+    }
+    
+    if (block.previousHash == getLatestBlock().hash) {
+        chain.append(block);
+        
+        if (!commitBlock(block)) {
+            chain.popTip();
+            throw std::runtime_error("Block #" + std::to_string(block.blockNumber) + " could not be committed");
+        }
+        
+        mempool.removeAll(block.transactions);
+        std::cout << "Block #" << block.blockNumber << " added to the blockchain." << std::endl;
+        return;
+    }
+    
+    // Builds on an older block: keep it, and switch over once its branch is heavier
+    double work = parentWork + blockWork(block.difficulty);
+    sideBranches.add(std::make_shared<const Block>(block), work);
+    if (chain.size() > MAX_REORG_DEPTH) {
+        sideBranches.prune(chain.size() - MAX_REORG_DEPTH);
+    }
+    std::cout << "Block #" << block.blockNumber << " stored on a side branch (work " << work
+              << ", main chain " << chain.totalWork() << ")" << std::endl;
+    if (work > chain.totalWork()) {
+        reorganize(block.hash);
+    }
+}
+
+void Blockchain::reorganize(const std::string& newTipHash) {
+    std::vector<std::shared_ptr<const Block>> branch = sideBranches.branch(newTipHash);
+    size_t forkHeight = 0;
+    if (branch.empty() || !chain.findHeight(branch.front()->previousHash, forkHeight)) {
+        std::cerr << "Side branch ending at " << newTipHash << " no longer joins the main chain" << std::endl;
         return;
     }
+    size_t oldTip = chain.size() - 1;
+    std::cout << "Reorganizing: disconnecting " << oldTip - forkHeight << " blocks back to #" << forkHeight
+              << ", connecting " << branch.size() << " blocks of a heavier branch" << std::endl;
     
-    if (block.blockNumber==getLatestBlock().blockNumber && block.hash!=getLatestBlock().hash ){
-        throw std::runtime_error("Blockchain integrity compromised. Block hash mismatch even though BlockNumber was same. Block hash: " + block.hash + " Current hash: " + getLatestBlock().hash);
+    // Blocks stored before undo data existed can only be undone by a replay
+    bool replayBalances = false;
+    for (size_t height = forkHeight + 1; db && balanceMap && height <= oldTip; height++) {
+        if (!db->hasUndoData(height)) {
+            replayBalances = true;
+            break;
+        }
     }
     
-    if (!block.validateTransactions()) {
-        throw std::runtime_error("ERROR: Received block contains invalid transactions");
+    // Newest first; the old blocks become a side branch themselves
+    std::vector<std::shared_ptr<const Block>> disconnected;
+    while (chain.size() - 1 > forkHeight) {
+        double work = chain.totalWork();
+        std::shared_ptr<const Block> tip = chain.get(chain.size() - 1);
+        disconnectTip();
+        sideBranches.add(tip, work);
+        disconnected.push_back(tip);
     }
     
-    chain.push_back(block);
+    if (replayBalances) {
+        std::cout << "Some disconnected blocks have no undo data, replaying balances up to #" << forkHeight << std::endl;
+        rebuildBalancesFromTransactions();
+    }
     
-    if (balanceMap) {
-        updateBalancesForBlock(block);
+    // Branch blocks only had their hashes checked, so one may still spend
+    // what its sender doesn't have once its parent is connected
+    size_t connected = 0;
+    while (connected < branch.size()) {
+        chain.append(*branch[connected]);
+        if (!commitBlock(*branch[connected])) {
+            chain.popTip();
+            break;
+        }
+        connected++;
     }
     
-    if (db && !db->saveBlock(block)) {
-        std::cerr << "Failed to save block to database: " << db->getLastError() << std::endl;
+    if (connected < branch.size()) {
+        const Block& bad = *branch[connected];
+        std::cerr << "Block #" << bad.blockNumber << " of the new branch doesn't apply, returning to block #"
+                  << oldTip << std::endl;
+        // The blocks before it are still good and stay on the side tree;
+        // it and everything built on it in this branch are dropped
+        while (chain.size() - 1 > forkHeight) {
+            disconnectTip();
+        }
+        for (size_t i = connected; i < branch.size(); i++) {
+            sideBranches.remove(branch[i]->hash);
+        }
+        for (auto block = disconnected.rbegin(); block != disconnected.rend(); ++block) {
+            sideBranches.remove((*block)->hash);
+            chain.append(**block);
+            if (!commitBlock(**block)) {
+                chain.popTip();
+                throw std::runtime_error("Failed to reconnect block #" + std::to_string((*block)->blockNumber) +
+                                         " after an aborted reorganization");
+            }
+        }
+        throw std::runtime_error("Block #" + std::to_string(bad.blockNumber) + " " + bad.hash +
+                                 " spends more than its senders have");
     }
     
-    mempool.clear();
-    std::cout << "Block #" << block.blockNumber << " added to the blockchain." << std::endl;
+    std::unordered_set<std::string> confirmed;
+    for (const auto& block : branch) {
+        sideBranches.remove(block->hash);
+        mempool.removeAll(block->transactions);
+        for (const auto& tx : block->transactions) {
+            confirmed.insert(tx.hash);
+        }
+    }
+    
+    // Transactions only the old branch confirmed go back to the mempool,
+    // oldest first so spends follow what funds them
+    for (auto block = disconnected.rbegin(); block != disconnected.rend(); ++block) {
+        for (const auto& tx : (*block)->transactions) {
+            if (tx.sender != "Genesis" && !confirmed.count(tx.hash)) {
+                addTransaction(tx);
+            }
+        }
+    }
+    
+    if (chain.size() > MAX_REORG_DEPTH) {
+        sideBranches.prune(chain.size() - MAX_REORG_DEPTH);
+    }
+    std::cout << "Reorganization complete. New tip is block #" << getLatestBlock().blockNumber
+              << " " << getLatestBlock().hash << std::endl;
+}
+
+void Blockchain::disconnectTip() {
+    std::shared_ptr<const Block> tip = chain.get(chain.size() - 1);
+    if (db) {
+        std::map<std::string, Amount> restored;
+        if (!db->disconnectBlock(*tip, restored)) {
+            throw std::runtime_error("Failed to disconnect block #" + std::to_string(tip->blockNumber) + ": " + db->getLastError());
+        }
+        if (balanceMap) {
+            balanceMap->markCommitted(restored);
+        }
+    }
+    chain.popTip();
+    std::cout << "Block #" << tip->blockNumber << " disconnected." << std::endl;
 }
 
 void Blockchain::addTransaction(const Transaction& transaction) {
-    if (balanceMap && !verifyTransactionBalance(transaction)) {
-        std::cerr << "Transaction rejected: Insufficient balance for " << transaction.sender << std::endl;
+    if (mempool.contains(transaction.hash)) return;
+    
+    // Legacy transactions only exist in stored history; new ones must hash
+    // their exact amount
+    if (transaction.version != Transaction::CURRENT_VERSION) {
+        std::cerr << "Transaction rejected: version " << transaction.version << " is not accepted for new transactions" << std::endl;
         return;
     }
     
-    for (auto& old : mempool) {
-        if (old.hash == transaction.hash) return;
+    if (balanceMap && !verifyPendingBalance(transaction)) {
+        std::cerr << "Transaction rejected: Insufficient balance for " << transaction.sender << std::endl;
+        return;
     }
     
-    mempool.push_back(transaction);
+    if (!mempool.add(transaction)) return;
     
     if (db && !db->saveTransaction(transaction)) {
         std::cerr << "Failed to save transaction to database: " << db->getLastError() << std::endl;
     }
     
     std::cout << "Transaction added to mempool: " << transaction.sender << " -> " 
-              << transaction.receiver << ": " << transaction.amount << std::endl;
+              << transaction.receiver << ": " << formatAmount(transaction.amount) << std::endl;
 }
 
-Block& Blockchain::mineBlock(std::vector<Wallet*>& walletList, NodeType nodeType) {
+const Block& Blockchain::mineBlock(std::vector<Wallet*>& walletList, NodeType nodeType) {
     // Store the wallets for future use
     wallets = walletList;
     
@@ -142,53 +299,47 @@ Block& Blockchain::mineBlock(std::vector<Wallet*>& walletList, NodeType nodeType
     }
     
     int emptyBlockCount = 0;
-    for (const auto& block : chain) {
+    for (size_t i = 0; i < chain.size(); i++) {
         // Count blocks that only have one transaction (the coinbase/reward)
-        if (block.transactions.size() <= 1) {
+        if (chain.header(i).transactionCount <= 1) {
             emptyBlockCount++;
         }
     }
     
-    // After 3 empty blocks, require transactions
-    if (mempool.empty() && emptyBlockCount >= 3) {
-        throw std::runtime_error("ERROR: Already mined 3 empty blocks. Need transactions to mine more blocks.");
-    }
-    
     // We need at least one wallet to receive the mining reward
     Wallet* minerWallet = walletList[0];
     std::string minerAddress = minerWallet->getAddress();
     
-    // Verify all transactions have sufficient balance
-    if (balanceMap && !mempool.empty()) {
-        for (const auto& tx : mempool) {
-            if (!verifyTransactionBalance(tx)) {
-                throw std::runtime_error("ERROR: Transaction from " + tx.sender + 
-                                      " has insufficient balance.");
-            }
-        }
-    }
-    
     // Calculate the current mining reward based on halving schedule
-    double currentReward = calculateCurrentMiningReward();
-    
-    // Create a copy of mempool since we'll be adding the reward transaction
-    std::vector<Transaction> blockTransactions = mempool;
+    Amount currentReward = calculateCurrentMiningReward();
     
     // Create a mining reward transaction (coinbase)
     Transaction rewardTx("Genesis", minerAddress, currentReward);
     rewardTx.hash = rewardTx.calculateHash();
     
+    // Pick what fits in the block and what each sender can afford; the rest
+    // stays in the mempool. Room is kept for the reward transaction.
+    std::vector<Transaction> selectedTransactions = blockTemplate.selectTransactions(
+        mempool, balanceMap, BlockTemplateBuilder::serializedSize(rewardTx), 1);
+    
+    // After 3 empty blocks, require transactions
+    if (selectedTransactions.empty() && emptyBlockCount >= 3) {
+        throw std::runtime_error("ERROR: Already mined 3 empty blocks. Need transactions to mine more blocks.");
+    }
+    
+    std::vector<Transaction> blockTransactions = selectedTransactions;
+    
     // Add the reward transaction to the block transactions
     blockTransactions.push_back(rewardTx);
     
     // Log appropriate message based on whether we're mining with transactions or just reward
-    if (mempool.empty()) {
+    if (selectedTransactions.empty()) {
         std::cout << "Mining new block with only coinbase reward transaction (" 
                   << (emptyBlockCount + 1) << " of 3 allowed empty blocks)" << std::endl;
     } else {
         std::cout << "Mining new block with " << blockTransactions.size() << " transactions (including mining reward)..." << std::endl;
     }
-    std::cout << "Mining reward of " << currentReward << " $CLST will be sent to " << minerAddress << std::endl;
+    std::cout << "Mining reward of " << formatAmount(currentReward) << " $CLST will be sent to " << minerAddress << std::endl;
     
     // Calculate and print halving information
     time_t currentTime = time(nullptr);
@@ -197,7 +348,7 @@ Block& Blockchain::mineBlock(std::vector<Wallet*>& walletList, NodeType nodeType
     int numberOfHalvings = daysSinceGenesis / HALVING_INTERVAL_DAYS;
     int daysUntilNextHalving = HALVING_INTERVAL_DAYS - (daysSinceGenesis % HALVING_INTERVAL_DAYS);
     
-    std::cout << "Current block reward: " << currentReward << " $CLST (after " << numberOfHalvings 
+    std::cout << "Current block reward: " << formatAmount(currentReward) << " $CLST (after " << numberOfHalvings 
               << " halvings)" << std::endl;
     std::cout << "Next halving in " << daysUntilNextHalving << " days" << std::endl;
     
@@ -209,22 +360,23 @@ Block& Blockchain::mineBlock(std::vector<Wallet*>& walletList, NodeType nodeType
         throw std::runtime_error("ERROR: Failed to mine block - invalid transactions");
     }
     
-    chain.push_back(newBlock);
+    chain.append(newBlock);
     
     std::cout << "Block #" << newBlock.blockNumber << " mined successfully!" << std::endl;
     std::cout << "Hash: " << newBlock.hash << std::endl;
     std::cout << "Nonce: " << newBlock.nonce << std::endl;
     
-    // First update balances in the database to ensure persistence
-    if (balanceMap) {
-        updateBalancesForBlock(newBlock);
+    // First persist the block and its balance changes
+    if (!commitBlock(newBlock)) {
+        chain.popTip();
+        throw std::runtime_error("ERROR: Failed to mine block - block #" + std::to_string(newBlock.blockNumber) + " could not be committed");
     }
     
     // Then synchronize in-memory wallet objects with database
     if (balanceMap) {
         for (auto& wallet : wallets) {
             // Get the current balance from the database
-            double dbBalance = 0.0;
+            Amount dbBalance = 0;
             if (balanceMap->getBalance(wallet->getAddress(), dbBalance)) {
                 // Synchronize the wallet's in-memory balance with the database
                 wallet->synchronizeBalance(dbBalance);
@@ -237,7 +389,7 @@ Block& Blockchain::mineBlock(std::vector<Wallet*>& walletList, NodeType nodeType
         minerWallet->receiveMoney(currentReward);
         
         // And process other transactions
-        for (const auto& tx : mempool) {
+        for (const auto& tx : selectedTransactions) {
         for (auto& wallet : wallets) {
             if (wallet->getAddress() == tx.receiver) {
                 wallet->receiveMoney(tx.amount);
@@ -247,31 +399,52 @@ Block& Blockchain::mineBlock(std::vector<Wallet*>& walletList, NodeType nodeType
         }
     }
     
-    // Save block to database
-    if (db && !db->saveBlock(newBlock)) {
-        std::cerr << "Failed to save block to database: " << db->getLastError() << std::endl;
-    }
-    
-    mempool.clear();
-    return chain.back();
+    // Only what made it into the block leaves the mempool
+    mempool.removeAll(newBlock.transactions);
+    return chain.tip();
 }
 
 const Block& Blockchain::getLatestBlock() const {
-    return chain.back();
+    return chain.tip();
 }
 
 size_t Blockchain::getChainSize() const {
     return chain.size();
 }
 
-const Block& Blockchain::getBlock(size_t index) const {
+std::shared_ptr<const Block> Blockchain::getBlock(size_t index) const {
+    return chain.get(index);
+}
+
+const BlockHeader& Blockchain::getBlockHeader(size_t index) const {
     if (index >= chain.size()) {
         throw std::out_of_range("Block index out of range");
     }
-    return chain[index];
+    return chain.header(index);
+}
+
+bool Blockchain::hasBlock(const std::string& hash) const {
+    return chain.contains(hash);
 }
 
-const std::vector<Block>& Blockchain::getChain() const {
+bool Blockchain::isKnownBlock(const std::string& hash) const {
+    return chain.contains(hash) || sideBranches.contains(hash);
+}
+
+std::shared_ptr<const Block> Blockchain::findBlock(const std::string& hash) const {
+    size_t height;
+    if (chain.findHeight(hash, height)) {
+        return chain.get(height);
+    }
+    const BlockTree::Entry* entry = sideBranches.find(hash);
+    return entry ? entry->block : nullptr;
+}
+
+double Blockchain::getChainWork() const {
+    return chain.totalWork();
+}
+
+const ChainStore& Blockchain::getChainStore() const {
     return chain;
 }
 
@@ -279,44 +452,63 @@ size_t Blockchain::getMempoolSize() const {
     return mempool.size();
 }
 
-const std::vector<Transaction>& Blockchain::getMempool() const {
-    return mempool;
+std::vector<Transaction> Blockchain::getMempool() const {
+    return mempool.toVector();
+}
+
+bool Blockchain::hasTransaction(const std::string& hash) const {
+    return mempool.contains(hash);
+}
+
+std::vector<const Transaction*> Blockchain::getMempoolTransactions() const {
+    return mempool.byPriority();
+}
+
+const Transaction* Blockchain::findMempoolTransaction(const std::string& hash) const {
+    return mempool.find(hash);
 }
 
 bool Blockchain::isValidChain() const {
+    return validateBlocks(1);
+}
+
+bool Blockchain::validateBlocks(size_t firstBlock) const {
     // Check if chain is empty
     if (chain.empty()) {
         return false;
     }
     
-    for (size_t i = 1; i < chain.size(); i++) {
-        const Block& currentBlock = chain[i];
-        const Block& previousBlock = chain[i - 1];
-        
-        // Check block integrity
-        if (currentBlock.previousHash != previousBlock.hash) {
-            std::cerr << "ERROR: Invalid chain - block " << i << " has incorrect previous hash" << std::endl;
-            return false;
-        }
-        
-        if (currentBlock.hash != currentBlock.calculateHash()) {
-            std::cerr << "ERROR: Invalid chain - block " << i << " has incorrect hash" << std::endl;
-            return false;
-        }
-        
-        // Validate transactions in the block
-        if (!currentBlock.validateTransactions()) {
-            std::cerr << "ERROR: Invalid chain - block " << i << " contains invalid transactions" << std::endl;
-            return false;
-        }
+    bool valid = true;
+    try {
+        chain.forEach(std::max<size_t>(firstBlock, 1), [&](const Block& currentBlock) {
+            size_t i = static_cast<size_t>(currentBlock.blockNumber);
+            const BlockHeader& previousBlock = chain.header(i - 1);
+            
+            // Check block integrity
+            if (currentBlock.previousHash != previousBlock.hash) {
+                std::cerr << "ERROR: Invalid chain - block " << i << " has incorrect previous hash" << std::endl;
+                valid = false;
+            } else if (currentBlock.hash != currentBlock.calculateHash()) {
+                std::cerr << "ERROR: Invalid chain - block " << i << " has incorrect hash" << std::endl;
+                valid = false;
+            } else if (!currentBlock.validateTransactions()) {
+                // Validate transactions in the block
+                std::cerr << "ERROR: Invalid chain - block " << i << " contains invalid transactions" << std::endl;
+                valid = false;
+            }
+            return valid;
+        });
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: Invalid chain - " << e.what() << std::endl;
+        return false;
     }
     
-    return true;
+    return valid;
 }
 
 std::string Blockchain::toString() const {
     std::string result = "Blockchain:\n";
-    for (const auto& block : chain) {
+    chain.forEach(0, [&](const Block& block) {
         result += "Block #" + std::to_string(block.blockNumber) + "\n";
         result += "  Hash: " + block.hash + "\n";
         result += "  Previous Hash: " + block.previousHash + "\n";
@@ -324,9 +516,10 @@ std::string Blockchain::toString() const {
         result += "  Timestamp: " + std::to_string(block.timestamp) + "\n";
         result += "  Transactions: " + std::to_string(block.transactions.size()) + "\n";
         for (const auto& tx : block.transactions) {
-            result += "    - " + tx.sender + " -> " + tx.receiver + ": " + std::to_string(tx.amount) + "\n";
+            result += "    - " + tx.sender + " -> " + tx.receiver + ": " + formatAmount(tx.amount) + "\n";
         }
-    }
+        return true;
+    });
     return result;
 }
 
@@ -336,69 +529,92 @@ void Blockchain::printBlockchain() const {
 
 void Blockchain::printMempool() const {
     std::cout << "Mempool (" << mempool.size() << " transactions):" << std::endl;
-    for (const auto& tx : mempool) {
-        std::cout << "  - " << tx.sender << " -> " << tx.receiver << ": " << tx.amount << std::endl;
+    for (const Transaction* tx : mempool.byPriority()) {
+        std::cout << "  - " << tx->sender << " -> " << tx->receiver << ": " << formatAmount(tx->amount) << std::endl;
     }
 }
 
 // Add a method to set the database
 void Blockchain::setDatabase(BlockchainDB* database) {
+    chain.setDatabase(database);
     db = database;
 }
 
+void Blockchain::setBlockLimits(size_t maxBlockBytes, size_t maxBlockTransactions) {
+    blockTemplate = BlockTemplateBuilder(maxBlockBytes, maxBlockTransactions);
+}
+
+void Blockchain::setSnapshotInterval(size_t blocks) {
+    snapshotInterval = blocks;
+}
+
+void Blockchain::setBlockWindow(size_t blocks) {
+    chain.setWindowSize(blocks);
+}
+
 // Add a method to set the balance mapping
 void Blockchain::setBalanceMapping(BalanceMapping* mapping) {
     balanceMap = mapping;
     std::cout << "Balance mapping " << (mapping ? "connected" : "disabled") << std::endl;
 }
 
-// Update balances when processing a block
-void Blockchain::updateBalancesForBlock(const Block& block) {
-    if (!balanceMap) {
-        std::cerr << "WARNING: Cannot update balances - balance mapping not available" << std::endl;
-        return;
+// Apply a block's balance changes and persist it
+bool Blockchain::commitBlock(const Block& block) {
+    BlockStateChanges changes;
+    if (balanceMap) {
+        int applied = 0;
+        if (!balanceMap->applyBlock(block, changes, applied)) {
+            std::cerr << "Block #" << block.blockNumber << " has transactions its senders can't pay for" << std::endl;
+            return false;
+        }
+        std::cout << "Balances for block #" << block.blockNumber << ": " << applied << " transactions applied, "
+                  << changes.balances.size() << " addresses changed" << std::endl;
     }
     
-    std::cout << "Updating balances for block #" << block.blockNumber << std::endl;
-    int processedTransactions = 0;
-    int failedTransactions = 0;
+    if (db && !db->commitBlock(block, changes)) {
+        std::cerr << "Failed to save block to database: " << db->getLastError() << std::endl;
+        return false;
+    }
+    if (balanceMap) {
+        balanceMap->markCommitted(changes.balances);
+    }
     
-    for (const auto& tx : block.transactions) {
-        // Skip genesis transaction in genesis block
-        if (block.blockNumber == 0 && tx.sender == "Genesis" && tx.receiver == "Genesis") {
-            std::cout << "Skipping genesis block genesis transaction" << std::endl;
-            continue;
-        }
-        
-        std::cout << "Processing transaction: " << tx.sender << " -> " << tx.receiver 
-                 << " (" << tx.amount << ")" << std::endl;
-        
-        // Process the transaction to update balances
-        if (balanceMap->processTransaction(tx.sender, tx.receiver, tx.amount)) {
-            processedTransactions++;
-            
-            // Debug: Show the updated balances
-            double senderBalance = 0.0, receiverBalance = 0.0;
-            balanceMap->getBalance(tx.sender, senderBalance);
-            balanceMap->getBalance(tx.receiver, receiverBalance);
-            
-            std::cout << "Updated balances:" << std::endl;
-            std::cout << "- " << tx.sender << ": " << senderBalance << " $CLST" << std::endl;
-            std::cout << "- " << tx.receiver << ": " << receiverBalance << " $CLST" << std::endl;
+    // Balances only change with blocks, so the stored balances are exactly
+    // the state after it
+    if (db && snapshotInterval > 0 && block.blockNumber > 0 && block.blockNumber % snapshotInterval == 0) {
+        if (db->saveWorldState(block.blockNumber, block.hash)) {
+            std::cout << "World state snapshot saved at block #" << block.blockNumber << std::endl;
         } else {
-            std::cerr << "Failed to update balances for transaction " << tx.hash << std::endl;
-            failedTransactions++;
+            std::cerr << "Failed to save world state snapshot: " << db->getLastError() << std::endl;
         }
     }
+    return true;
+}
+
+// Verify a transaction has sufficient balance
+bool Blockchain::verifyPendingBalance(const Transaction& tx) {
+    if (tx.sender == "Genesis" || !balanceMap) {
+        return true;
+    }
+    
+    Amount balance = 0;
+    if (!balanceMap->getBalance(tx.sender, balance)) {
+        std::cerr << "Error: Could not retrieve balance for " << tx.sender << std::endl;
+        return false;
+    }
     
-    std::cout << "Balance update complete for block #" << block.blockNumber << ":" << std::endl;
-    std::cout << "- Processed: " << processedTransactions << " transactions" << std::endl;
-    if (failedTransactions > 0) {
-        std::cerr << "- Failed: " << failedTransactions << " transactions" << std::endl;
+    // Everything already queued by this sender counts against the balance
+    Amount pending = mempool.pendingSpend(tx.sender);
+    if (balance - pending < tx.amount) {
+        std::cerr << "Error: Insufficient balance. " << tx.sender 
+                  << " has " << formatAmount(balance) << " $CLST with " << formatAmount(pending)
+                  << " $CLST already pending but wants to send " << formatAmount(tx.amount) << " $CLST" << std::endl;
+        return false;
     }
+    
+    return true;
 }
 
-// Verify a transaction has sufficient balance
 bool Blockchain::verifyTransactionBalance(const Transaction& tx) const {
     if (tx.sender == "Genesis") {
         // Genesis transactions or mining rewards are always valid
@@ -410,7 +626,7 @@ bool Blockchain::verifyTransactionBalance(const Transaction& tx) const {
         return true;
     }
     
-    double balance = 0.0;
+    Amount balance = 0;
     if (!balanceMap->getBalance(tx.sender, balance)) {
         std::cerr << "Error: Could not retrieve balance for " << tx.sender << std::endl;
         return false;
@@ -419,7 +635,7 @@ bool Blockchain::verifyTransactionBalance(const Transaction& tx) const {
     // Check if sender has enough balance
     if (balance < tx.amount) {
         std::cerr << "Error: Insufficient balance. " << tx.sender 
-                  << " has " << balance << " $CLST but wants to send " << tx.amount << " $CLST" << std::endl;
+                  << " has " << formatAmount(balance) << " $CLST but wants to send " << formatAmount(tx.amount) << " $CLST" << std::endl;
         return false;
     }
     
@@ -427,36 +643,29 @@ bool Blockchain::verifyTransactionBalance(const Transaction& tx) const {
 }
 
 // Add a method to load the blockchain from database
-void Blockchain::loadFromDatabase() {
+void Blockchain::loadFromDatabase(bool fullVerify) {
     if (!db || !db->isOpen()) {
         throw std::runtime_error("Cannot load blockchain: no database connection");
     }
     
     // Clear the current chain
     chain.clear();
-    
-    // We'll scan for blocks by index until we don't find any more
-    size_t index = 0;
-    bool foundBlocks = false;
-    
-    // Try to load blocks in sequence until no more blocks are found
-    while (true) {
-        // We need to create a minimal block that will be filled by getBlock
-        // Since Block doesn't have a default constructor, we need to create it with parameters
-        std::vector<Transaction> emptyTxs;
-        Block tempBlock(index, emptyTxs, "0x0", difficulty);
-        
-        // Try to get the block by index
-        if (db->getBlock(index, tempBlock)) {
-            // Block was found, add it to the chain
-            chain.push_back(tempBlock);
-            foundBlocks = true;
-            index++;
-        } else {
-            // No more blocks found, exit the loop
-            break;
+    sideBranches = BlockTree();
+    
+    // Ordered scans from the genesis block up to the first gap. Only the
+    // headers and the block window stay in memory.
+    const size_t loadBatchSize = 4096;
+    std::vector<Block> batch;
+    do {
+        batch.clear();
+        if (!db->loadBlocks(chain.size(), chain.size() + loadBatchSize - 1, batch)) {
+            throw std::runtime_error("Cannot load blockchain: " + db->getLastError());
         }
-    }
+        for (auto& block : batch) {
+            chain.append(std::move(block));
+        }
+    } while (batch.size() == loadBatchSize);
+    bool foundBlocks = !chain.empty();
     
     // If no blocks were found, initialize with genesis block
     if (!foundBlocks) {
@@ -464,6 +673,7 @@ void Blockchain::loadFromDatabase() {
         // Create a genesis block directly
         std::vector<Transaction> genesisTransactions;
         Transaction genesisTx("Genesis", "Genesis", 0);
+        genesisTx.version = Transaction::VERSION_LEGACY;
         genesisTx.hash = genesisTx.calculateHash();
         genesisTransactions.push_back(genesisTx);
         
@@ -474,20 +684,119 @@ void Blockchain::loadFromDatabase() {
         genesisBlock.hash = GENESIS_HASH;
         
         // Add to chain and save to database
-        chain.push_back(genesisBlock);
+        chain.append(genesisBlock);
         if (db) {
             db->saveBlock(genesisBlock);
+            std::string checksum;
+            if (db->checksumBlockRecords(0, 0, checksum)) {
+                db->setValidatedTip(0, genesisBlock.hash, checksum);
+            }
         }
         return;
     }
     
     // Verify the loaded blockchain
-    if (!isValidChain()) {
+    if (!validateLoadedChain(fullVerify)) {
         throw std::runtime_error("Loaded blockchain is invalid");
     }
     
-    // Rebuild balances from transactions
-    rebuildBalancesFromTransactions();
+    // Start from the latest snapshot when there is one, otherwise replay
+    // the whole ledger
+    if (!restoreBalancesFromSnapshot()) {
+        rebuildBalancesFromTransactions();
+    }
+}
+
+bool Blockchain::validateLoadedChain(bool fullVerify) {
+    size_t trustedHeight = 0;
+    std::string trustedHash, storedChecksum, checksum;
+    bool trusted = !fullVerify && db->getValidatedTip(trustedHeight, trustedHash, storedChecksum) &&
+                   trustedHeight < chain.size() && chain.header(trustedHeight).hash == trustedHash &&
+                   db->checksumBlockRecords(0, trustedHeight, checksum) && checksum == storedChecksum;
+    
+    size_t firstBlock = 1;
+    if (trusted) {
+        firstBlock = trustedHeight + 1;
+        std::cout << "Blocks up to #" << trustedHeight << " were already validated, checking from #"
+                  << firstBlock << std::endl;
+    } else {
+        if (!fullVerify && !trustedHash.empty()) {
+            std::cout << "Validated tip does not match the stored blocks, checking the whole chain" << std::endl;
+        }
+        checksum.clear();
+        trustedHeight = 0;
+    }
+    
+    if (!validateBlocks(firstBlock)) {
+        return false;
+    }
+    
+    // Everything loaded is validated now
+    size_t tip = chain.size() - 1;
+    size_t checksumFrom = trusted ? trustedHeight + 1 : 0;
+    if (checksumFrom <= tip && !db->checksumBlockRecords(checksumFrom, tip, checksum)) {
+        std::cerr << "Failed to checksum stored blocks: " << db->getLastError() << std::endl;
+        return true;
+    }
+    if (!db->setValidatedTip(tip, chain.header(tip).hash, checksum)) {
+        std::cerr << "Failed to record validated tip: " << db->getLastError() << std::endl;
+    }
+    return true;
+}
+
+bool Blockchain::restoreBalancesFromSnapshot() {
+    if (!balanceMap || !db || !db->isOpen()) {
+        return false;
+    }
+    
+    size_t snapshotHeight = 0;
+    std::string snapshotHash;
+    if (!db->getLatestWorldState(snapshotHeight, snapshotHash)) {
+        return false;
+    }
+    
+    // A snapshot past the tip or off this chain can't be used
+    if (snapshotHeight >= chain.size() || chain.header(snapshotHeight).hash != snapshotHash) {
+        std::cout << "World state snapshot at block #" << snapshotHeight
+                  << " does not match the loaded chain, ignoring it" << std::endl;
+        return false;
+    }
+    
+    std::map<std::string, Amount> snapshot;
+    if (!db->loadWorldState(snapshotHeight, snapshot)) {
+        std::cerr << "Failed to read world state snapshot at block #" << snapshotHeight << std::endl;
+        return false;
+    }
+    
+    std::cout << "Restoring balances from snapshot at block #" << snapshotHeight << "..." << std::endl;
+    balanceMap->clearCache();
+    
+    // Addresses first seen after the snapshot start from zero
+    BlockStateChanges changes;
+    for (const auto& pair : balanceMap->getAllBalances()) {
+        changes.balances[pair.first] = 0;
+    }
+    for (const auto& pair : snapshot) {
+        changes.balances[pair.first] = pair.second;
+    }
+    
+    // Journal entries for these blocks were written when they were committed
+    int processedTransactions = 0;
+    chain.forEach(snapshotHeight + 1, [&](const Block& block) {
+        int applied = 0;
+        balanceMap->applyBlock(block, changes, applied, false);
+        processedTransactions += applied;
+        return true;
+    });
+    
+    if (!balanceMap->commitBalances(changes.balances)) {
+        std::cerr << "ERROR: Failed to write restored balances: " << db->getLastError() << std::endl;
+        return false;
+    }
+    
+    std::cout << "Balances restored: replayed " << (chain.size() - snapshotHeight - 1) << " blocks and "
+              << processedTransactions << " transactions after the snapshot" << std::endl;
+    return true;
 }
 
 // Helper method to rebuild balances from transactions
@@ -503,36 +812,33 @@ void Blockchain::rebuildBalancesFromTransactions() {
     }
     
     std::cout << "Rebuilding balances from transaction history..." << std::endl;
+    // Everything is recomputed from the chain
+    balanceMap->clearCache();
     
-    // Get all current balances and reset them to zero
+    // Start every known address from zero, then replay the whole chain in
+    // memory and write the result once
     auto allBalances = balanceMap->getAllBalances();
     std::cout << "Found " << allBalances.size() << " addresses with balances" << std::endl;
     
+    BlockStateChanges changes;
     for (const auto& pair : allBalances) {
-        std::string address = pair.first;
-        balanceMap->updateBalance(address, 0.0);
+        changes.balances[pair.first] = 0;
     }
     
     int processedBlocks = 0;
     int processedTransactions = 0;
     
     // Process all transactions in order
-    for (const auto& block : chain) {
-        for (const auto& tx : block.transactions) {
-            // Skip the genesis block's genesis transaction
-            if (block.blockNumber == 0 && tx.sender == "Genesis" && tx.receiver == "Genesis") {
-                continue;
-            }
-            
-            if (balanceMap->processTransaction(tx.sender, tx.receiver, tx.amount)) {
-                processedTransactions++;
-            } else {
-                std::cerr << "WARNING: Failed to process transaction: " 
-                         << tx.sender << " -> " << tx.receiver 
-                         << " (" << tx.amount << ")" << std::endl;
-            }
-        }
+    chain.forEach(0, [&](const Block& block) {
+        int applied = 0;
+        balanceMap->applyBlock(block, changes, applied, false);
+        processedTransactions += applied;
         processedBlocks++;
+        return true;
+    });
+    
+    if (!balanceMap->commitBalances(changes.balances)) {
+        std::cerr << "ERROR: Failed to write rebuilt balances: " << db->getLastError() << std::endl;
     }
     
     // Display the results
@@ -547,17 +853,17 @@ void Blockchain::rebuildBalancesFromTransactions() {
     // Log details of non-zero balances
     int nonZeroCount = 0;
     for (const auto& [address, balance] : updatedBalances) {
-        if (balance > 0.0) {
+        if (balance > 0) {
             nonZeroCount++;
-            std::cout << "  > " << address << ": " << balance << std::endl;
+            std::cout << "  > " << address << ": " << formatAmount(balance) << std::endl;
         }
     }
     std::cout << "- " << nonZeroCount << " addresses with non-zero balances" << std::endl;
 }
 
 // Calculate the total supply of coins in the blockchain
-double Blockchain::getTotalSupply() const {
-    double totalSupply = 0.0;
+Amount Blockchain::getTotalSupply() const {
+    Amount totalSupply = 0;
     
     // If we have a balance mapping, we can use it to get the total supply
     if (balanceMap) {
@@ -570,10 +876,10 @@ double Blockchain::getTotalSupply() const {
     
     // If no balance mapping, manually calculate by traversing the blockchain
     // This is less efficient but works as a fallback
-    std::map<std::string, double> balances;
+    std::map<std::string, Amount> balances;
     
     // Process all transactions in the blockchain
-            for (const auto& block : chain) {
+            chain.forEach(0, [&](const Block& block) {
                 for (const auto& tx : block.transactions) {
             // Skip genesis transaction
             if (tx.sender == "Genesis" && tx.receiver == "Genesis") {
@@ -589,7 +895,8 @@ double Blockchain::getTotalSupply() const {
                 balances[tx.receiver] += tx.amount;
                     }
                 }
-            }
+                return true;
+            });
     
     // Sum all positive balances
     for (const auto& [address, balance] : balances) {
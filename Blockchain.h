@@ -10,18 +10,44 @@
 #include "Types.h"
 #include "BlockchainDB.h"
 #include "balanceMapping.h"
+#include "Mempool.h"
+#include "BlockTemplate.h"
+#include "ChainStore.h"
+#include "BlockTree.h"
 
 class Blockchain {
 private:
-    std::vector<Block> chain;
-    std::vector<Transaction> mempool;
+    ChainStore chain;  // Headers plus a window of full blocks, the rest paged from the database
+    BlockTree sideBranches;  // Valid blocks off the main chain that could still overtake it
+    Mempool mempool;
+    BlockTemplateBuilder blockTemplate; // Chooses mempool transactions for mined blocks
     std::vector<Wallet*> wallets;  // To store wallet pointers for updating balances
     int difficulty;
     BlockchainDB* db;  // Database connection
     BalanceMapping* balanceMap; // Balance tracking
+    size_t snapshotInterval;    // Blocks between world state snapshots, 0 disables
     
     // Calculate the current mining reward based on time since genesis
-    double calculateCurrentMiningReward() const;
+    Amount calculateCurrentMiningReward() const;
+    
+    // Load the latest world state snapshot and replay only the blocks after
+    // it. Returns false if there is no usable snapshot.
+    bool restoreBalancesFromSnapshot();
+    
+    // Check hashes, links and transactions of blocks firstBlock..tip
+    bool validateBlocks(size_t firstBlock) const;
+    
+    // Validate what was loaded from the database, skipping blocks below the
+    // stored validated tip when its checksum still matches
+    bool validateLoadedChain(bool fullVerify);
+    
+    // Switch the main chain to the side branch ending at newTipHash:
+    // disconnect back to the fork point, then connect the branch. If a branch
+    // block doesn't apply, the old chain is put back and this throws.
+    void reorganize(const std::string& newTipHash);
+    
+    // Remove the tip block and put back the balances it changed
+    void disconnectTip();
     
     // Number of days between halvings
     static const int HALVING_INTERVAL_DAYS;
@@ -31,21 +57,38 @@ public:
     static const time_t GENESIS_TIMESTAMP;
     static const int     GENESIS_NONCE;
     static const std::string GENESIS_HASH;
-    static const double INITIAL_MINING_REWARD;   // Initial mining reward constant
+    static const Amount INITIAL_MINING_REWARD;   // Initial mining reward constant
+    static const Amount MINIMUM_MINING_REWARD;   // Floor the halvings stop at
+    static const size_t DEFAULT_SNAPSHOT_INTERVAL;
+    static const size_t MAX_REORG_DEPTH;         // Side branches forking deeper are forgotten
     
     Blockchain(int difficulty = 4) ;
     
     void addBlock(const std::vector<Transaction>& transactions);
+    // Add a block mined elsewhere. It extends the tip, or is kept on a side
+    // branch and triggers a reorganization once its branch has more work.
+    // Throws if it's invalid or its parent is unknown.
     void addExistingBlock(const Block& block);
     void addTransaction(const Transaction& transaction);
-    Block& mineBlock(std::vector<Wallet*>& wallets, NodeType nodeType = NodeType::FULL_NODE);
+    const Block& mineBlock(std::vector<Wallet*>& wallets, NodeType nodeType = NodeType::FULL_NODE);
     
+    // Valid until the next block is added
     const Block& getLatestBlock() const;
     size_t getChainSize() const;
-    const Block& getBlock(size_t index) const;
-    const std::vector<Block>& getChain() const;
+    // May read the block back from the database; throws if out of range
+    std::shared_ptr<const Block> getBlock(size_t index) const;
+    const BlockHeader& getBlockHeader(size_t index) const;
+    bool hasBlock(const std::string& hash) const;     // On the main chain
+    bool isKnownBlock(const std::string& hash) const; // On the main chain or a side branch
+    // Block with this hash on any branch; null if it isn't known
+    std::shared_ptr<const Block> findBlock(const std::string& hash) const;
+    double getChainWork() const;
+    const ChainStore& getChainStore() const;
     size_t getMempoolSize() const;
-    const std::vector<Transaction>& getMempool() const;
+    std::vector<Transaction> getMempool() const; // Copy, highest priority first
+    std::vector<const Transaction*> getMempoolTransactions() const; // Same order, valid until the pool changes
+    bool hasTransaction(const std::string& hash) const; // In the mempool
+    const Transaction* findMempoolTransaction(const std::string& hash) const;
     
     std::string toString() const;
     void printBlockchain() const;
@@ -56,19 +99,35 @@ public:
     int getDifficulty() const;
     void setDifficulty(int newDifficulty);
     
+    // Limits applied when picking mempool transactions for a new block
+    void setBlockLimits(size_t maxBlockBytes, size_t maxBlockTransactions);
+    
+    // How often the balances are snapshotted for fast restarts
+    void setSnapshotInterval(size_t blocks);
+    
+    // Number of full blocks kept in memory besides the tip
+    void setBlockWindow(size_t blocks);
+    
     // Statistics methods
-    double getTotalSupply() const;
-    double getCurrentMiningReward() const;
+    Amount getTotalSupply() const;
+    Amount getCurrentMiningReward() const;
 
     // Database operations
     void setDatabase(BlockchainDB* database);
-    void loadFromDatabase();
+    // fullVerify re-validates every block instead of trusting the blocks
+    // this node already validated
+    void loadFromDatabase(bool fullVerify = false);
     void rebuildBalancesFromTransactions();
     
     // Balance mapping operations
     void setBalanceMapping(BalanceMapping* mapping);
-    void updateBalancesForBlock(const Block& block);
+    // Apply a block's balance changes and persist it, all in one batch.
+    // Returns false, with nothing written, if one of its transactions spends
+    // more than its sender has or the write fails.
+    bool commitBlock(const Block& block);
     bool verifyTransactionBalance(const Transaction& tx) const;
+    // Confirmed balance minus what the sender's pooled transactions already spend
+    bool verifyPendingBalance(const Transaction& tx);
 };
 
 #endif // BLOCKCHAIN_H 
\ No newline at end of file
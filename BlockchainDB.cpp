@@ -7,12 +7,199 @@
 #include <leveldb/write_batch.h>
 #include <boost/lexical_cast.hpp>
 #include "crypto_utils.h"
+#include "BinaryCodec.h"
+#include "sha.h"
+#include "ThreadPool.h"
+#include <deque>
+#include <future>
 #include <algorithm>
 
 // Forward declaration if it's not found in the header
 // Remove this if splitString is already declared in crypto_utils.h
 // std::vector<std::string> splitString(const std::string& str, char delim);
 
+// 1: amounts as doubles in coins
+// 2: amounts as base units, transactions carry their hash version
+const int BlockchainDB::STORAGE_FORMAT_VERSION = 2;
+
+namespace {
+
+// Binary records start with a zero byte, which never appears in the old
+// text values, followed by the format version
+const char BINARY_RECORD_MARKER = '\0';
+const char* STORAGE_FORMAT_KEY = "meta:storageFormat";
+// "<height>|<block hash>" of the most recent world state snapshot
+const char* LATEST_WORLD_STATE_KEY = "meta:latestWorldState";
+// "<height>|<block hash>|<checksum>" of the last block this node validated
+const char* VALIDATED_TIP_KEY = "meta:validatedTip";
+
+// Blocks are keyed by a fixed-width big-endian height so LevelDB keeps
+// them in chain order and the chain loads with one sequential scan.
+// Older databases used "block:<decimal height>".
+const std::string BLOCK_KEY_PREFIX = "blk:";
+const std::string LEGACY_BLOCK_KEY_PREFIX = "block:";
+const size_t BLOCK_KEY_SIZE = 4 + 8;
+
+std::string blockKey(uint64_t height) {
+    std::string key = BLOCK_KEY_PREFIX;
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        key.push_back(static_cast<char>((height >> shift) & 0xff));
+    }
+    return key;
+}
+
+bool parseBlockKey(const leveldb::Slice& key, uint64_t& height) {
+    if (key.size() != BLOCK_KEY_SIZE || !key.starts_with(BLOCK_KEY_PREFIX)) {
+        return false;
+    }
+    height = 0;
+    for (size_t i = BLOCK_KEY_PREFIX.size(); i < BLOCK_KEY_SIZE; i++) {
+        height = (height << 8) | static_cast<uint8_t>(key[i]);
+    }
+    return true;
+}
+
+// Block keys aren't printable, so log them by height
+std::string describeBlockKey(const std::string& key) {
+    uint64_t height = 0;
+    return parseBlockKey(key, height) ? "block #" + std::to_string(height) : key;
+}
+
+// Undo data for a block, under the same ordered height suffix
+const std::string UNDO_KEY_PREFIX = "undo:";
+
+std::string undoKey(uint64_t height) {
+    return UNDO_KEY_PREFIX + blockKey(height).substr(BLOCK_KEY_PREFIX.size());
+}
+
+// Records decoded per thread pool task while loading the chain
+const size_t LOAD_CHUNK_SIZE = 256;
+
+// Running checksum over stored block records: each step hashes the
+// previous checksum together with the next record
+std::string extendRecordChecksum(const std::string& checksum, const std::string& record) {
+    return computeSHA256(checksum + record);
+}
+
+bool isBinaryRecord(const char* data, size_t size) {
+    return size > 0 && data[0] == BINARY_RECORD_MARKER;
+}
+
+bool isBinaryRecord(const std::string& data) {
+    return isBinaryRecord(data.data(), data.size());
+}
+
+void writeRecordHeader(BinaryWriter& writer) {
+    writer.writeByte(static_cast<uint8_t>(BINARY_RECORD_MARKER));
+    writer.writeByte(static_cast<uint8_t>(BlockchainDB::STORAGE_FORMAT_VERSION));
+}
+
+// Returns the format version the record was written with
+int readRecordHeader(BinaryReader& reader) {
+    reader.readByte();
+    uint8_t version = reader.readByte();
+    if (version == 0 || version > BlockchainDB::STORAGE_FORMAT_VERSION) {
+        throw std::runtime_error("Unsupported storage format version " + std::to_string(version));
+    }
+    return version;
+}
+
+int recordVersion(const std::string& data) {
+    return isBinaryRecord(data) && data.size() > 1 ? static_cast<uint8_t>(data[1]) : 0;
+}
+
+void writeAmount(BinaryWriter& writer, Amount amount) {
+    writer.writeSignedVarint(amount);
+}
+
+Amount readAmount(BinaryReader& reader, int recordVersion) {
+    if (recordVersion == 1) {
+        return amountFromCoins(reader.readDouble());
+    }
+    return reader.readSignedVarint();
+}
+
+// Current records use the shared transaction layout from Transaction.h.
+// Format 1 stored the amount as a double in coins and had no hash
+// version; that layout is frozen, so it is read here.
+Transaction readStoredTransaction(BinaryReader& reader, int recordVersion) {
+    if (recordVersion >= 2) {
+        return decodeTransaction(reader);
+    }
+    std::string sender = reader.readHexString();
+    std::string senderPublicKey = reader.readHexString();
+    std::string receiver = reader.readHexString();
+    Amount amount = readAmount(reader, recordVersion);
+    unsigned long timestamp = static_cast<unsigned long>(reader.readVarint());
+    std::string hash = reader.readHexString();
+    std::string signature = reader.readHexString();
+    return Transaction(sender, senderPublicKey, receiver, amount, hash, signature, timestamp,
+                       Transaction::VERSION_LEGACY);
+}
+
+// Fill the entry field by field, so a reader that stops at an error keeps
+// what came before it
+void readJournalEntry(BinaryReader& reader, BalanceJournalEntry& entry) {
+    int recordVersion = readRecordHeader(reader);
+    entry.address = reader.readHexString();
+    entry.txHash = reader.readHexString();
+    entry.amount = readAmount(reader, recordVersion);
+    entry.isCredit = reader.readByte() != 0;
+    entry.blockHeight = static_cast<size_t>(reader.readVarint());
+    entry.timestamp = static_cast<time_t>(reader.readSignedVarint());
+}
+
+void readWorldState(BinaryReader& reader, std::map<std::string, Amount>& balances) {
+    int recordVersion = readRecordHeader(reader);
+    uint64_t count = reader.readVarint();
+    for (uint64_t i = 0; i < count; i++) {
+        std::string address = reader.readHexString();
+        balances[address] = readAmount(reader, recordVersion);
+    }
+}
+
+std::string journalKey(const BalanceJournalEntry& entry) {
+    // Timestamp keeps keys unique even with multiple transactions in same block
+    return "journal:" + entry.address + ":" + std::to_string(entry.timestamp) + ":" + entry.txHash;
+}
+
+void readHexField(BinaryReader& reader, HexFieldView& field) {
+    reader.readHexField(field.tag, field.payload);
+}
+
+// Zero-copy reader for the same layout as readStoredTransaction
+void readTransactionView(BinaryReader& reader, TransactionView& view, int recordVersion) {
+    readHexField(reader, view.sender);
+    readHexField(reader, view.senderPublicKey);
+    readHexField(reader, view.receiver);
+    view.amount = readAmount(reader, recordVersion);
+    view.timestamp = static_cast<unsigned long>(reader.readVarint());
+    readHexField(reader, view.hash);
+    readHexField(reader, view.signature);
+    view.version = Transaction::VERSION_LEGACY;
+    if (recordVersion >= 2) {
+        view.version = static_cast<int>(reader.readVarint());
+    }
+}
+
+// Views over a decoded text record: tag 0 means "payload is the text"
+HexFieldView textField(const std::string& text) {
+    return HexFieldView{0, text};
+}
+
+void viewTransaction(const Transaction& tx, TransactionView& view) {
+    view.sender = textField(tx.sender);
+    view.senderPublicKey = textField(tx.senderPublicKey);
+    view.receiver = textField(tx.receiver);
+    view.amount = tx.amount;
+    view.timestamp = tx.timestamp;
+    view.hash = textField(tx.hash);
+    view.signature = textField(tx.signature);
+    view.version = tx.version;
+}
+
+} // namespace
+
 BlockchainDB::BlockchainDB(const std::string& dbPath) : db(nullptr) {
     leveldb::Options options;
     options.create_if_missing = true;
@@ -104,15 +291,174 @@ bool BlockchainDB::writeBatch(const std::vector<std::pair<std::string, std::stri
 }
 
 bool BlockchainDB::saveBlock(const Block& block) {
-    std::string key = "block:" + std::to_string(block.blockNumber);
-    return put(key, serializeBlock(block));
+    return put(blockKey(block.blockNumber), serializeBlock(block));
+}
+
+bool BlockchainDB::commitBlock(const Block& block, const BlockStateChanges& changes) {
+    if (!db) {
+        lastError = "Database not open";
+        return false;
+    }
+    
+    std::string record = serializeBlock(block);
+    leveldb::WriteBatch batch;
+    batch.Put(blockKey(block.blockNumber), record);
+    
+    // Blocks are validated before they get here, so the validated tip moves
+    // along when this block directly extends it
+    size_t validatedHeight = 0;
+    std::string validatedHash, checksum;
+    bool extendsValidatedTip = block.blockNumber > 0 && getValidatedTip(validatedHeight, validatedHash, checksum) &&
+        validatedHeight + 1 == static_cast<size_t>(block.blockNumber) && validatedHash == block.previousHash;
+    if (extendsValidatedTip) {
+        batch.Put(VALIDATED_TIP_KEY, std::to_string(block.blockNumber) + "|" + block.hash + "|" +
+                  extendRecordChecksum(checksum, record));
+    }
+    
+    // Undo data: the balances before the block, the journal keys it adds
+    // and the validated tip checksum to fall back to
+    BinaryWriter undo;
+    writeRecordHeader(undo);
+    undo.writeVarint(changes.previousBalances.size());
+    for (const auto& [address, balance] : changes.previousBalances) {
+        undo.writeHexString(address);
+        writeAmount(undo, balance);
+    }
+    undo.writeVarint(changes.journal.size());
+    for (const auto& entry : changes.journal) {
+        undo.writeString(journalKey(entry));
+    }
+    undo.writeString(extendsValidatedTip ? checksum : "");
+    batch.Put(undoKey(block.blockNumber), undo.release());
+    
+    for (const auto& tx : block.transactions) {
+        batch.Put("tx:" + tx.hash, serializeTransaction(tx));
+    }
+    for (const auto& [address, balance] : changes.balances) {
+        batch.Put("balance:" + address, formatAmount(balance));
+    }
+    for (const auto& entry : changes.journal) {
+        batch.Put(journalKey(entry), serializeJournalEntry(entry));
+    }
+    
+    leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
+    if (!status.ok()) {
+        lastError = status.ToString();
+        return false;
+    }
+    return true;
+}
+
+bool BlockchainDB::disconnectBlock(const Block& block, std::map<std::string, Amount>& restoredBalances) {
+    if (!db) {
+        lastError = "Database not open";
+        return false;
+    }
+    
+    leveldb::WriteBatch batch;
+    batch.Delete(blockKey(block.blockNumber));
+    
+    std::string previousChecksum;
+    std::string record;
+    if (get(undoKey(block.blockNumber), record)) {
+        try {
+            BinaryReader reader(record);
+            int recordVersion = readRecordHeader(reader);
+            uint64_t balanceCount = reader.readVarint();
+            for (uint64_t i = 0; i < balanceCount; i++) {
+                std::string address = reader.readHexString();
+                Amount balance = readAmount(reader, recordVersion);
+                batch.Put("balance:" + address, formatAmount(balance));
+                restoredBalances[address] = balance;
+            }
+            uint64_t journalCount = reader.readVarint();
+            for (uint64_t i = 0; i < journalCount; i++) {
+                batch.Delete(reader.readString());
+            }
+            previousChecksum = reader.readString();
+        } catch (const std::exception& e) {
+            lastError = "Corrupt undo data for block " + std::to_string(block.blockNumber) + ": " + e.what();
+            restoredBalances.clear();
+            return false;
+        }
+        batch.Delete(undoKey(block.blockNumber));
+    }
+    
+    // Step the validated tip back to the parent, or drop it if we can't
+    size_t validatedHeight = 0;
+    std::string validatedHash, checksum;
+    if (getValidatedTip(validatedHeight, validatedHash, checksum) &&
+        validatedHeight >= static_cast<size_t>(block.blockNumber)) {
+        if (validatedHeight == static_cast<size_t>(block.blockNumber) && !previousChecksum.empty()) {
+            batch.Put(VALIDATED_TIP_KEY, std::to_string(block.blockNumber - 1) + "|" + block.previousHash + "|" +
+                      previousChecksum);
+        } else {
+            batch.Delete(VALIDATED_TIP_KEY);
+        }
+    }
+    
+    leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
+    if (!status.ok()) {
+        lastError = status.ToString();
+        restoredBalances.clear();
+        return false;
+    }
+    return true;
+}
+
+bool BlockchainDB::hasUndoData(size_t blockNumber) const {
+    std::string record;
+    return get(undoKey(blockNumber), record);
+}
+
+bool BlockchainDB::getValidatedTip(size_t& blockHeight, std::string& blockHash, std::string& checksum) const {
+    std::string marker;
+    if (!get(VALIDATED_TIP_KEY, marker)) {
+        return false;
+    }
+    
+    std::vector<std::string> parts = splitString(marker, '|');
+    if (parts.size() != 3) {
+        lastError = "Malformed validated tip marker: " + marker;
+        return false;
+    }
+    try {
+        blockHeight = std::stoull(parts[0]);
+    } catch (const std::exception& e) {
+        lastError = "Malformed validated tip marker: " + marker;
+        return false;
+    }
+    blockHash = parts[1];
+    checksum = parts[2];
+    return true;
+}
+
+bool BlockchainDB::setValidatedTip(size_t blockHeight, const std::string& blockHash, const std::string& checksum) {
+    return put(VALIDATED_TIP_KEY, std::to_string(blockHeight) + "|" + blockHash + "|" + checksum);
+}
+
+bool BlockchainDB::checksumBlockRecords(size_t firstBlock, size_t lastBlock, std::string& checksum) const {
+    if (!db) {
+        lastError = "Database not open";
+        return false;
+    }
+    
+    std::unique_ptr<leveldb::Iterator> it(db->NewIterator(leveldb::ReadOptions()));
+    it->Seek(blockKey(firstBlock));
+    for (size_t blockNumber = firstBlock; blockNumber <= lastBlock; blockNumber++, it->Next()) {
+        uint64_t height = 0;
+        if (!it->Valid() || !parseBlockKey(it->key(), height) || height != blockNumber) {
+            lastError = "Block " + std::to_string(blockNumber) + " not found";
+            return false;
+        }
+        checksum = extendRecordChecksum(checksum, it->value().ToString());
+    }
+    return true;
 }
 
 bool BlockchainDB::getBlock(size_t blockNumber, Block& block) const {
     std::string value;
-    std::string key = "block:" + std::to_string(blockNumber);
-
-    if (!get(key, value)) {
+    if (!get(blockKey(blockNumber), value)) {
         return false;
     }
 
@@ -125,6 +471,112 @@ bool BlockchainDB::getBlock(size_t blockNumber, Block& block) const {
     }
 }
 
+bool BlockchainDB::loadBlocks(size_t firstBlock, size_t lastBlock, std::vector<Block>& blocks) const {
+    if (!db) {
+        lastError = "Database not open";
+        return false;
+    }
+    
+    // Decode one chunk of raw records into blocks; runs on the thread pool
+    auto decodeChunk = [this](std::vector<std::string> records) {
+        std::vector<Block> decoded;
+        decoded.reserve(records.size());
+        BlockView view;
+        Block legacyStorage(0, {}, "0x0", 1);
+        for (const auto& record : records) {
+            parseBlockRecord(record.data(), record.size(), view, legacyStorage);
+            decoded.push_back(view.toBlock());
+        }
+        return decoded;
+    };
+    
+    // The scan keeps reading while earlier chunks decode. At most a few
+    // chunks per worker are in flight so memory stays bounded.
+    const size_t maxInFlight = 2 * ThreadPool::shared().getThreadCount() + 1;
+    std::deque<std::future<std::vector<Block>>> inFlight;
+    bool ok = true;
+    auto collectOldest = [&]() {
+        try {
+            for (auto& block : inFlight.front().get()) {
+                blocks.push_back(std::move(block));
+            }
+        } catch (const std::exception& e) {
+            if (ok) {
+                lastError = std::string("Corrupt block record: ") + e.what();
+            }
+            ok = false;
+        }
+        inFlight.pop_front();
+    };
+    
+    std::unique_ptr<leveldb::Iterator> it(db->NewIterator(leveldb::ReadOptions()));
+    std::vector<std::string> chunk;
+    size_t expected = firstBlock;
+    for (it->Seek(blockKey(firstBlock)); it->Valid() && expected <= lastBlock; it->Next(), expected++) {
+        // Stop at the end of the blocks or the first missing height
+        uint64_t height = 0;
+        if (!parseBlockKey(it->key(), height) || height != expected) {
+            break;
+        }
+        
+        chunk.push_back(it->value().ToString());
+        if (chunk.size() == LOAD_CHUNK_SIZE) {
+            inFlight.push_back(ThreadPool::shared().submit(
+                [decodeChunk, records = std::move(chunk)]() mutable { return decodeChunk(std::move(records)); }));
+            chunk.clear();
+            if (inFlight.size() >= maxInFlight) {
+                collectOldest();
+            }
+        }
+    }
+    if (!it->status().ok()) {
+        lastError = it->status().ToString();
+        ok = false;
+    }
+    if (!chunk.empty()) {
+        inFlight.push_back(ThreadPool::shared().submit(
+            [decodeChunk, records = std::move(chunk)]() mutable { return decodeChunk(std::move(records)); }));
+    }
+    while (!inFlight.empty()) {
+        collectOldest();
+    }
+    return ok;
+}
+
+bool BlockchainDB::migrateBlockKeys() {
+    std::unique_ptr<leveldb::Iterator> it(db->NewIterator(leveldb::ReadOptions()));
+    it->Seek(LEGACY_BLOCK_KEY_PREFIX);
+    if (!it->Valid() || !it->key().starts_with(LEGACY_BLOCK_KEY_PREFIX)) {
+        return true;
+    }
+    
+    std::cout << "Moving blocks to height-ordered keys..." << std::endl;
+    leveldb::WriteBatch batch;
+    size_t moved = 0;
+    for (; it->Valid() && it->key().starts_with(LEGACY_BLOCK_KEY_PREFIX); it->Next()) {
+        std::string key = it->key().ToString();
+        uint64_t height = 0;
+        try {
+            height = std::stoull(key.substr(LEGACY_BLOCK_KEY_PREFIX.size()));
+        } catch (const std::exception& e) {
+            std::cerr << "Skipping unrecognised block key " << key << std::endl;
+            continue;
+        }
+        // Both keys go in the same batch, so no block is ever missing
+        batch.Put(blockKey(height), it->value());
+        batch.Delete(key);
+        moved++;
+    }
+    
+    leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
+    if (!status.ok()) {
+        lastError = status.ToString();
+        return false;
+    }
+    std::cout << "Moved " << moved << " blocks" << std::endl;
+    return true;
+}
+
 bool BlockchainDB::saveTransaction(const Transaction& tx) {
     std::string key = "tx:" + tx.hash;
     return put(key, serializeTransaction(tx));
@@ -169,21 +621,225 @@ std::vector<std::string> BlockchainDB::getAllKeys(const std::string& prefix) con
     return keys;
 }
 
+bool BlockchainDB::migrateStorageFormat() {
+    if (!db) {
+        lastError = "Database not open";
+        return false;
+    }
+    
+    if (!migrateBlockKeys()) {
+        return false;
+    }
+    
+    std::string marker;
+    if (get(STORAGE_FORMAT_KEY, marker) && marker == std::to_string(STORAGE_FORMAT_VERSION)) {
+        return true;
+    }
+    
+    std::cout << "Migrating database to storage format " << STORAGE_FORMAT_VERSION << "..." << std::endl;
+    const std::string prefixes[] = {BLOCK_KEY_PREFIX, "tx:", "journal:", "worldstate:"};
+    size_t converted = 0;
+    size_t failed = 0;
+    leveldb::WriteBatch batch;
+    size_t batched = 0;
+    
+    // The iterator reads from an implicit snapshot, so writing converted
+    // values back while iterating is safe
+    std::unique_ptr<leveldb::Iterator> it(db->NewIterator(leveldb::ReadOptions()));
+    for (const std::string& prefix : prefixes) {
+        for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+            std::string value = it->value().ToString();
+            if (recordVersion(value) == STORAGE_FORMAT_VERSION) {
+                continue;
+            }
+            
+            // The readers understand text and every older binary version
+            try {
+                std::string encoded;
+                if (prefix == BLOCK_KEY_PREFIX) {
+                    encoded = serializeBlock(decodeBlockRecord(value));
+                } else if (prefix == "tx:") {
+                    encoded = serializeTransaction(deserializeTransaction(value));
+                } else if (prefix == "journal:") {
+                    encoded = serializeJournalEntry(decodeJournalRecord(value));
+                } else {
+                    encoded = serializeWorldState(decodeWorldStateRecord(value));
+                }
+                batch.Put(it->key(), encoded);
+                converted++;
+                batched++;
+            } catch (const std::exception& e) {
+                // Left as it was; the readers still understand it
+                std::cerr << "Could not migrate " << describeBlockKey(it->key().ToString()) << ": " << e.what() << std::endl;
+                failed++;
+            }
+            
+            if (batched >= 500) {
+                leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
+                if (!status.ok()) {
+                    lastError = status.ToString();
+                    return false;
+                }
+                batch.Clear();
+                batched = 0;
+            }
+        }
+    }
+    
+    batch.Put(STORAGE_FORMAT_KEY, std::to_string(STORAGE_FORMAT_VERSION));
+    leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
+    if (!status.ok()) {
+        lastError = status.ToString();
+        return false;
+    }
+    
+    std::cout << "Storage migration complete: " << converted << " records converted, "
+              << failed << " left in an older format" << std::endl;
+    return true;
+}
+
+void BlockchainDB::parseBlockRecord(const char* data, size_t size, BlockView& view, Block& legacyStorage) const {
+    if (!isBinaryRecord(data, size)) {
+        legacyStorage = deserializeLegacyBlock(std::string(data, size));
+        view.blockNumber = legacyStorage.blockNumber;
+        view.timestamp = legacyStorage.timestamp;
+        view.previousHash = textField(legacyStorage.previousHash);
+        view.hash = textField(legacyStorage.hash);
+        view.nonce = legacyStorage.nonce;
+        view.difficulty = legacyStorage.difficulty;
+        view.version = legacyStorage.version;
+        view.transactions.resize(legacyStorage.transactions.size());
+        for (size_t i = 0; i < legacyStorage.transactions.size(); i++) {
+            viewTransaction(legacyStorage.transactions[i], view.transactions[i]);
+        }
+        return;
+    }
+    
+    BinaryReader reader(data, size);
+    int recordVersion = readRecordHeader(reader);
+    view.blockNumber = static_cast<int>(reader.readSignedVarint());
+    view.timestamp = static_cast<time_t>(reader.readSignedVarint());
+    readHexField(reader, view.previousHash);
+    readHexField(reader, view.hash);
+    view.nonce = static_cast<int>(reader.readSignedVarint());
+    view.difficulty = static_cast<int>(reader.readSignedVarint());
+    view.version = static_cast<int>(reader.readSignedVarint());
+    
+    uint64_t txCount = reader.readVarint();
+    if (txCount > reader.remaining()) {
+        throw std::runtime_error("Invalid transaction count: " + std::to_string(txCount));
+    }
+    view.transactions.resize(txCount);
+    for (auto& tx : view.transactions) {
+        readTransactionView(reader, tx, recordVersion);
+    }
+}
+
+void BlockchainDB::parseTransactionRecord(const char* data, size_t size, TransactionView& view,
+                                          Transaction& legacyStorage) const {
+    if (!isBinaryRecord(data, size)) {
+        legacyStorage = deserializeLegacyTransaction(std::string(data, size));
+        viewTransaction(legacyStorage, view);
+        return;
+    }
+    
+    BinaryReader reader(data, size);
+    int recordVersion = readRecordHeader(reader);
+    readTransactionView(reader, view, recordVersion);
+}
+
+bool BlockchainDB::forEachBlockView(size_t firstBlock, size_t lastBlock,
+                                    const std::function<bool(const BlockView&)>& visitor) const {
+    if (!db) {
+        lastError = "Database not open";
+        return false;
+    }
+    
+    std::unique_ptr<leveldb::Iterator> it(db->NewIterator(leveldb::ReadOptions()));
+    BlockView view;
+    Block legacyStorage(0, {}, "0x0", 1);
+    it->Seek(blockKey(firstBlock));
+    for (size_t blockNumber = firstBlock; blockNumber <= lastBlock; blockNumber++, it->Next()) {
+        uint64_t height = 0;
+        if (!it->Valid() || !parseBlockKey(it->key(), height) || height != blockNumber) {
+            lastError = "Block " + std::to_string(blockNumber) + " not found";
+            return false;
+        }
+        
+        try {
+            leveldb::Slice value = it->value();
+            parseBlockRecord(value.data(), value.size(), view, legacyStorage);
+        } catch (const std::exception& e) {
+            lastError = "Corrupt block " + std::to_string(blockNumber) + ": " + e.what();
+            return false;
+        }
+        
+        if (!visitor(view)) {
+            break;
+        }
+    }
+    return true;
+}
+
+bool BlockchainDB::withBlockView(size_t blockNumber, const std::function<void(const BlockView&)>& visitor) const {
+    return forEachBlockView(blockNumber, blockNumber, [&](const BlockView& view) {
+        visitor(view);
+        return true;
+    });
+}
+
+bool BlockchainDB::forEachTransactionView(const std::function<bool(const TransactionView&)>& visitor) const {
+    if (!db) {
+        lastError = "Database not open";
+        return false;
+    }
+    
+    const leveldb::Slice prefix("tx:");
+    std::unique_ptr<leveldb::Iterator> it(db->NewIterator(leveldb::ReadOptions()));
+    TransactionView view;
+    Transaction legacyStorage("", "", 0);
+    for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+        try {
+            leveldb::Slice value = it->value();
+            parseTransactionRecord(value.data(), value.size(), view, legacyStorage);
+        } catch (const std::exception& e) {
+            // Same as getTransaction: skip what can't be read
+            continue;
+        }
+        
+        if (!visitor(view)) {
+            break;
+        }
+    }
+    return true;
+}
+
 // Helper method to serialize a transaction consistently
 std::string BlockchainDB::serializeTransaction(const Transaction& tx) const {
-    std::stringstream ss;
-    ss << tx.sender << "|"
-       << tx.senderPublicKey << "|"
-       << tx.receiver << "|"
-       << tx.amount << "|"
-       << tx.timestamp << "|"
-       << tx.hash << "|"
-       << tx.signature;
-    return ss.str();
+    BinaryWriter writer;
+    writeRecordHeader(writer);
+    encodeTransaction(writer, tx);
+    return writer.release();
 }
 
 // Helper method to deserialize a transaction consistently
 Transaction BlockchainDB::deserializeTransaction(const std::string& data) const {
+    if (!isBinaryRecord(data)) {
+        return deserializeLegacyTransaction(data);
+    }
+    
+    try {
+        BinaryReader reader(data);
+        int recordVersion = readRecordHeader(reader);
+        return readStoredTransaction(reader, recordVersion);
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR in deserializeTransaction: " << e.what() << std::endl;
+        throw;
+    }
+}
+
+// Pipe-delimited text format used before the binary encoding
+Transaction BlockchainDB::deserializeLegacyTransaction(const std::string& data) const {
     try {
         // Debug the transaction data
         std::cout << "Deserializing transaction data: ";
@@ -208,11 +864,9 @@ Transaction BlockchainDB::deserializeTransaction(const std::string& data) const
         }
         
         // Parse amount safely
-        double amount;
-        try {
-            amount = std::stod(parts[3]);
-        } catch (const std::exception& e) {
-            throw std::runtime_error("Invalid amount: " + parts[3] + " - " + std::string(e.what()));
+        Amount amount;
+        if (!parseAmount(parts[3], amount)) {
+            throw std::runtime_error("Invalid amount: " + parts[3]);
         }
         
         // Parse timestamp safely
@@ -243,148 +897,194 @@ Transaction BlockchainDB::deserializeTransaction(const std::string& data) const
 
 // Helper method to serialize a block consistently
 std::string BlockchainDB::serializeBlock(const Block& block) const {
-    std::stringstream ss;
-    ss << block.blockNumber << "|"
-       << block.timestamp << "|"
-       << block.previousHash << "|"
-       << block.hash << "|"
-       << block.nonce << "|"
-       << block.difficulty << "|"
-       << block.transactions.size();
-
-    // For each transaction, serialize and then escape any '|' characters in the transaction data
-    // to prevent conflict with the block serialization format
+    BinaryWriter writer;
+    writeRecordHeader(writer);
+    writer.writeSignedVarint(block.blockNumber);
+    writer.writeSignedVarint(static_cast<int64_t>(block.timestamp));
+    writer.writeHexString(block.previousHash);
+    writer.writeHexString(block.hash);
+    writer.writeSignedVarint(block.nonce);
+    writer.writeSignedVarint(block.difficulty);
+    writer.writeSignedVarint(block.version);
+    writer.writeVarint(block.transactions.size());
     for (const auto& tx : block.transactions) {
-        // Instead of using the serializeTransaction method directly, we'll serialize
-        // the transaction fields individually to avoid nesting delimiters
-        ss << "|" << tx.sender
-           << "|" << tx.senderPublicKey
-           << "|" << tx.receiver
-           << "|" << tx.amount
-           << "|" << tx.timestamp
-           << "|" << tx.hash
-           << "|" << tx.signature;
+        encodeTransaction(writer, tx);
     }
-
-    return ss.str();
+    return writer.release();
 }
 
 // Helper method to deserialize a block consistently
 Block BlockchainDB::deserializeBlock(const std::string& data) const {
     try {
-        std::cout << "Deserializing block data: ";
-        // Print a safe version of the data (first 30 chars)
-        std::cout << (data.length() > 30 ? data.substr(0, 30) + "..." : data) << std::endl;
-        
-        std::vector<std::string> parts;
-        try {
-            parts = splitString(data, '|');
-        } catch (const std::exception& e) {
-            throw std::runtime_error("Failed to split block data: " + std::string(e.what()));
+        if (!isBinaryRecord(data)) {
+            return deserializeLegacyBlock(data);
         }
+        return decodeBlockRecord(data);
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR in deserializeBlock: " << e.what() << std::endl;
+        // Create an empty genesis-like block as a fallback
+        std::vector<Transaction> emptyTxs;
+        Block emptyBlock(0, emptyTxs, "0x0", 1);
+        return emptyBlock;
+    }
+}
 
-        if (parts.size() < 7) {
-            throw std::runtime_error("Invalid block data format: expected at least 7 parts, got " + 
-                                    std::to_string(parts.size()));
-        }
+Block BlockchainDB::decodeBlockRecord(const std::string& data) const {
+    if (!isBinaryRecord(data)) {
+        return deserializeLegacyBlock(data, true);
+    }
+    
+    BinaryReader reader(data);
+    int recordVersion = readRecordHeader(reader);
+    int blockNumber = static_cast<int>(reader.readSignedVarint());
+    time_t timestamp = static_cast<time_t>(reader.readSignedVarint());
+    std::string previousHash = reader.readHexString();
+    std::string hash = reader.readHexString();
+    int nonce = static_cast<int>(reader.readSignedVarint());
+    int difficulty = static_cast<int>(reader.readSignedVarint());
+    int version = static_cast<int>(reader.readSignedVarint());
+    
+    uint64_t txCount = reader.readVarint();
+    // Every transaction takes well over one byte, so a count larger than
+    // what's left means the record is corrupt
+    if (txCount > reader.remaining()) {
+        throw std::runtime_error("Invalid transaction count: " + std::to_string(txCount));
+    }
+    std::vector<Transaction> transactions;
+    transactions.reserve(txCount);
+    for (uint64_t i = 0; i < txCount; i++) {
+        transactions.push_back(readStoredTransaction(reader, recordVersion));
+    }
+    if (!reader.atEnd()) {
+        throw std::runtime_error("Trailing bytes after block #" + std::to_string(blockNumber));
+    }
+    
+    return Block(blockNumber, timestamp, std::move(transactions), previousHash, hash,
+                 nonce, difficulty, version);
+}
 
-        // Safely parse block header data
-        int blockNumber;
-        time_t timestamp;
-        std::string previousHash;
-        std::string hash;
-        int nonce;
-        int difficulty;
-        size_t txCount;
-        
-        try {
-            blockNumber = std::stoi(parts[0]);
-            timestamp = std::stoul(parts[1]);
-            previousHash = parts[2];
-            hash = parts[3];
-            nonce = std::stoi(parts[4]);
-            difficulty = std::stoi(parts[5]);
-            txCount = std::stoull(parts[6]);
-        } catch (const std::exception& e) {
-            throw std::runtime_error("Failed to parse block header: " + std::string(e.what()));
-        }
+// Pipe-delimited text format used before the binary encoding. Throws on
+// a malformed header; bad transactions are skipped unless strict.
+Block BlockchainDB::deserializeLegacyBlock(const std::string& data, bool strict) const {
+    std::cout << "Deserializing block data: ";
+    // Print a safe version of the data (first 30 chars)
+    std::cout << (data.length() > 30 ? data.substr(0, 30) + "..." : data) << std::endl;
+    
+    std::vector<std::string> parts;
+    try {
+        parts = splitString(data, '|');
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Failed to split block data: " + std::string(e.what()));
+    }
 
-        // Validate basic block fields
-        if (previousHash.empty() || hash.empty()) {
-            throw std::runtime_error("Block has empty hash fields");
-        }
+    if (parts.size() < 7) {
+        throw std::runtime_error("Invalid block data format: expected at least 7 parts, got " + 
+                                std::to_string(parts.size()));
+    }
 
-        std::vector<Transaction> transactions;
+    // Safely parse block header data
+    int blockNumber;
+    time_t timestamp;
+    std::string previousHash;
+    std::string hash;
+    int nonce;
+    int difficulty;
+    size_t txCount;
+    
+    try {
+        blockNumber = std::stoi(parts[0]);
+        timestamp = std::stoul(parts[1]);
+        previousHash = parts[2];
+        hash = parts[3];
+        nonce = std::stoi(parts[4]);
+        difficulty = std::stoi(parts[5]);
+        txCount = std::stoull(parts[6]);
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Failed to parse block header: " + std::string(e.what()));
+    }
+
+    // Validate basic block fields
+    if (previousHash.empty() || hash.empty()) {
+        throw std::runtime_error("Block has empty hash fields");
+    }
+
+    std::vector<Transaction> transactions;
+    
+    // Each transaction uses 7 parts, so index accordingly
+    bool txError = false;
+    for (size_t i = 0; i < txCount; i++) {
+        // Calculate the base index for this transaction
+        size_t baseIdx = 7 + i * 7;
         
-        // Each transaction uses 7 parts, so index accordingly
-        bool txError = false;
-        for (size_t i = 0; i < txCount; i++) {
-            // Calculate the base index for this transaction
-            size_t baseIdx = 7 + i * 7;
-            
-            // Check if we have enough parts
-            if (baseIdx + 6 >= parts.size()) {
-                std::cerr << "Warning: Truncated transaction data at index " << i << 
-                          ". Expected " << 7 + txCount * 7 << " parts, got " << parts.size() << std::endl;
-                txError = true;
-                break;
+        // Check if we have enough parts
+        if (baseIdx + 6 >= parts.size()) {
+            std::cerr << "Warning: Truncated transaction data at index " << i << 
+                      ". Expected " << 7 + txCount * 7 << " parts, got " << parts.size() << std::endl;
+            txError = true;
+            break;
+        }
+        
+        // Create transaction directly from the parts
+        try {
+            std::string sender = parts[baseIdx];
+            std::string senderPubKey = parts[baseIdx + 1];
+            std::string receiver = parts[baseIdx + 2];
+            Amount amount;
+            if (!parseAmount(parts[baseIdx + 3], amount)) {
+                throw std::runtime_error("Invalid amount: " + parts[baseIdx + 3]);
             }
+            unsigned long txTimestamp = std::stoul(parts[baseIdx + 4]);
+            std::string txHash = parts[baseIdx + 5];
+            std::string signature = parts[baseIdx + 6];
             
-            // Create transaction directly from the parts
-            try {
-                std::string sender = parts[baseIdx];
-                std::string senderPubKey = parts[baseIdx + 1];
-                std::string receiver = parts[baseIdx + 2];
-                double amount = std::stod(parts[baseIdx + 3]);
-                unsigned long txTimestamp = std::stoul(parts[baseIdx + 4]);
-                std::string txHash = parts[baseIdx + 5];
-                std::string signature = parts[baseIdx + 6];
-                
-                Transaction tx(
-                    sender,         // sender
-                    senderPubKey,   // senderPublicKey
-                    receiver,       // receiver
-                    amount,         // amount
-                    txHash,         // hash
-                    signature,      // signature
-                    txTimestamp     // timestamp
-                );
-                transactions.push_back(tx);
-            } catch (const std::exception& e) {
-                std::cerr << "Warning: Error parsing transaction at index " << i << 
-                          ": " << e.what() << std::endl;
-                // Continue with next transaction
-                txError = true;
-            }
+            Transaction tx(
+                sender,         // sender
+                senderPubKey,   // senderPublicKey
+                receiver,       // receiver
+                amount,         // amount
+                txHash,         // hash
+                signature,      // signature
+                txTimestamp     // timestamp
+            );
+            transactions.push_back(tx);
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: Error parsing transaction at index " << i << 
+                      ": " << e.what() << std::endl;
+            // Continue with next transaction
+            txError = true;
         }
-        
-        // If we had transaction errors, log but continue
-        if (txError) {
-            std::cerr << "Warning: Some transactions were skipped due to errors" << std::endl;
+    }
+    
+    int version = Block::VERSION_LEGACY;
+    size_t versionIdx = 7 + txCount * 7;
+    if (!txError && versionIdx < parts.size()) {
+        try {
+            version = std::stoi(parts[versionIdx]);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid block version: " + parts[versionIdx]);
         }
-
-        std::cout << "before creating block: " << blockNumber << std::endl;
-        std::cout << "Initializing block with details:" << std::endl;
-        std::cout << "Block Number: " << blockNumber << std::endl;
-        std::cout << "Previous Hash: " << previousHash << std::endl;
-        std::cout << "Difficulty: " << difficulty << std::endl;
-        std::cout << "Number of Transactions: " << transactions.size() << std::endl;
-        
-        // Create a block even if we had some transaction errors
-        Block block(blockNumber, transactions, previousHash, difficulty);
-        block.timestamp = timestamp;
-        block.nonce = nonce;
-        block.hash = hash;
-        
-        std::cout << "after creating block: " << blockNumber << std::endl;
-        return block;
-    } catch (const std::exception& e) {
-        std::cerr << "ERROR in deserializeBlock: " << e.what() << std::endl;
-        // Create an empty genesis-like block as a fallback
-        std::vector<Transaction> emptyTxs;
-        Block emptyBlock(0, emptyTxs, "0x0", 1);
-        return emptyBlock;
     }
+    
+    // If we had transaction errors, log but continue
+    if (txError) {
+        if (strict) {
+            throw std::runtime_error("Block #" + std::to_string(blockNumber) + " has transactions that could not be parsed");
+        }
+        std::cerr << "Warning: Some transactions were skipped due to errors" << std::endl;
+    }
+
+    std::cout << "before creating block: " << blockNumber << std::endl;
+    std::cout << "Initializing block with details:" << std::endl;
+    std::cout << "Block Number: " << blockNumber << std::endl;
+    std::cout << "Previous Hash: " << previousHash << std::endl;
+    std::cout << "Difficulty: " << difficulty << std::endl;
+    std::cout << "Number of Transactions: " << transactions.size() << std::endl;
+    
+    // Create a block even if we had some transaction errors
+    Block block(blockNumber, timestamp, transactions, previousHash, hash, nonce, difficulty, version);
+    
+    std::cout << "after creating block: " << blockNumber << std::endl;
+    return block;
 }
 
 // Database integrity verification and repair
@@ -403,8 +1103,10 @@ bool BlockchainDB::verifyDatabaseIntegrity(bool repairCorrupted) {
     
     try {
         // Check all blocks
-        auto blockKeys = getAllKeys("block:");
+        auto blockKeys = getAllKeys(BLOCK_KEY_PREFIX);
         std::cout << "Found " << blockKeys.size() << " blocks in database" << std::endl;
+        BlockView blockView;
+        Block legacyBlock(0, {}, "0x0", 1);
         for (const auto& key : blockKeys) {
             std::string value;
             bool keyValid = false;
@@ -412,28 +1114,26 @@ bool BlockchainDB::verifyDatabaseIntegrity(bool repairCorrupted) {
             try {
                 keyValid = get(key, value);
             } catch (const std::exception& e) {
-                std::cerr << "Error reading key " << key << ": " << e.what() << std::endl;
+                std::cerr << "Error reading " << describeBlockKey(key) << ": " << e.what() << std::endl;
                 keyValid = false;
             }
             
             if (keyValid) {
                 try {
-                    // Try to deserialize the block
-                    Block block = deserializeBlock(value);
-                    std::cout<<"blockschecked"<<blocksChecked<<std::endl;
+                    // Parse in place; no need to build a Block just to check it
+                    parseBlockRecord(value.data(), value.size(), blockView, legacyBlock);
                     blocksChecked++;
-                    std::cout<<"blockschecked"<<blocksChecked<<std::endl;
 
                     // Further validation can be added here if needed
                 } 
                 catch (const std::exception& e) {
                     blocksErrorCount++;
                     hasErrors = true;
-                    std::cerr << "Error in block " << key << ": " << e.what() << std::endl;
+                    std::cerr << "Error in " << describeBlockKey(key) << ": " << e.what() << std::endl;
                     
                     if (repairCorrupted) {
                         try {
-                            std::cout << "Removing corrupted block entry: " << key << std::endl;
+                            std::cout << "Removing corrupted block entry: " << describeBlockKey(key) << std::endl;
                             if (remove(key)) {
                                 std::cout << "Successfully removed corrupted block" << std::endl;
                             } else {
@@ -449,11 +1149,11 @@ bool BlockchainDB::verifyDatabaseIntegrity(bool repairCorrupted) {
                 // Key couldn't be read
                 blocksErrorCount++;
                 hasErrors = true;
-                std::cerr << "Could not read block data for key " << key << std::endl;
+                std::cerr << "Could not read block data for " << describeBlockKey(key) << std::endl;
                 
                 if (repairCorrupted) {
                     try {
-                        std::cout << "Removing unreadable block entry: " << key << std::endl;
+                        std::cout << "Removing unreadable block entry: " << describeBlockKey(key) << std::endl;
                         if (remove(key)) {
                             std::cout << "Successfully removed unreadable block" << std::endl;
                         } else {
@@ -484,11 +1184,11 @@ bool BlockchainDB::verifyDatabaseIntegrity(bool repairCorrupted) {
             if (keyValid) {
                 bool txValid = true;
                 Transaction tx("", "", 0); // Default transaction
+                TransactionView txView;
                 
                 try {
-                    // Try to deserialize the transaction
-                    tx = deserializeTransaction(value);
-                    std::cout << "Deserialized transaction: " << tx.hash << std::endl;
+                    // Try to parse the transaction
+                    parseTransactionRecord(value.data(), value.size(), txView, tx);
                     txChecked++;
                     
                     // Further validation can be added here if needed
@@ -555,37 +1255,36 @@ bool BlockchainDB::verifyDatabaseIntegrity(bool repairCorrupted) {
 }
 
 // Wallet balance operations
-bool BlockchainDB::updateBalance(const std::string& address, double newBalance) {
+bool BlockchainDB::updateBalance(const std::string& address, Amount newBalance) {
     if (!isOpen()) return false;
     
     std::string key = "balance:" + address;
-    std::string value = std::to_string(newBalance);
+    std::string value = formatAmount(newBalance);
     
     return put(key, value);
 }
 
-bool BlockchainDB::getBalance(const std::string& address, double& balance) const {
+bool BlockchainDB::getBalance(const std::string& address, Amount& balance) const {
     if (!isOpen()) return false;
     
     std::string key = "balance:" + address;
     std::string value;
     
     if (!get(key, value)) {
-        balance = 0.0; // Default balance for new addresses
+        balance = 0; // Default balance for new addresses
         return true;
     }
     
-    try {
-        balance = std::stod(value);
-        return true;
-    } catch (const std::exception& e) {
-        lastError = "Failed to parse balance: " + std::string(e.what());
+    // Older nodes wrote std::to_string of a double, which parses exactly too
+    if (!parseAmount(value, balance)) {
+        lastError = "Failed to parse balance: " + value;
         return false;
     }
+    return true;
 }
 
 bool BlockchainDB::addBalanceJournalEntry(const std::string& address, const std::string& txHash, 
-                                        double amount, bool isCredit, size_t blockHeight) {
+                                        Amount amount, bool isCredit, size_t blockHeight) {
     if (!isOpen()) return false;
     
     BalanceJournalEntry entry;
@@ -596,11 +1295,7 @@ bool BlockchainDB::addBalanceJournalEntry(const std::string& address, const std:
     entry.blockHeight = blockHeight;
     entry.timestamp = time(nullptr);
     
-    // Use timestamp to ensure unique keys even with multiple transactions in same block
-    std::string key = "journal:" + address + ":" + std::to_string(entry.timestamp) + ":" + txHash;
-    std::string value = serializeJournalEntry(entry);
-    
-    return put(key, value);
+    return put(journalKey(entry), serializeJournalEntry(entry));
 }
 
 std::vector<BalanceJournalEntry> BlockchainDB::getBalanceJournal(const std::string& address) const {
@@ -626,20 +1321,62 @@ std::vector<BalanceJournalEntry> BlockchainDB::getBalanceJournal(const std::stri
 }
 
 // World state operations
-bool BlockchainDB::saveWorldState(size_t blockHeight) {
-    if (!isOpen()) return false;
+bool BlockchainDB::saveWorldState(size_t blockHeight, const std::string& blockHash) {
+    if (!db) {
+        lastError = "Database not open";
+        return false;
+    }
     
-    // Get all current balances
+    // Balances on disk are exactly the state after the last committed block
     auto balances = getAllBalances();
     
-    // Serialize and save
-    std::string key = "worldstate:" + std::to_string(blockHeight);
-    std::string value = serializeWorldState(balances);
+    // The previous snapshot is kept as a fallback, anything older is dropped
+    size_t previousHeight = 0;
+    std::string previousHash;
+    bool hasPrevious = getLatestWorldState(previousHeight, previousHash);
     
-    return put(key, value);
+    const std::string prefix = "worldstate:";
+    leveldb::WriteBatch batch;
+    for (const auto& key : getAllKeys(prefix)) {
+        std::string height = key.substr(prefix.size());
+        if (height != std::to_string(blockHeight) &&
+            !(hasPrevious && height == std::to_string(previousHeight))) {
+            batch.Delete(key);
+        }
+    }
+    batch.Put(prefix + std::to_string(blockHeight), serializeWorldState(balances));
+    batch.Put(LATEST_WORLD_STATE_KEY, std::to_string(blockHeight) + "|" + blockHash);
+    
+    leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
+    if (!status.ok()) {
+        lastError = status.ToString();
+        return false;
+    }
+    return true;
+}
+
+bool BlockchainDB::getLatestWorldState(size_t& blockHeight, std::string& blockHash) const {
+    std::string marker;
+    if (!get(LATEST_WORLD_STATE_KEY, marker)) {
+        return false;
+    }
+    
+    size_t separator = marker.find('|');
+    if (separator == std::string::npos) {
+        lastError = "Malformed world state marker: " + marker;
+        return false;
+    }
+    try {
+        blockHeight = std::stoull(marker.substr(0, separator));
+    } catch (const std::exception& e) {
+        lastError = "Malformed world state marker: " + marker;
+        return false;
+    }
+    blockHash = marker.substr(separator + 1);
+    return true;
 }
 
-bool BlockchainDB::loadWorldState(size_t blockHeight, std::map<std::string, double>& balances) const {
+bool BlockchainDB::loadWorldState(size_t blockHeight, std::map<std::string, Amount>& balances) const {
     if (!isOpen()) return false;
     
     std::string key = "worldstate:" + std::to_string(blockHeight);
@@ -653,23 +1390,19 @@ bool BlockchainDB::loadWorldState(size_t blockHeight, std::map<std::string, doub
     return true;
 }
 
-std::map<std::string, double> BlockchainDB::getAllBalances() const {
-    std::map<std::string, double> balances;
+std::map<std::string, Amount> BlockchainDB::getAllBalances() const {
+    std::map<std::string, Amount> balances;
     if (!isOpen()) return balances;
     
-    std::string prefix = "balance:";
-    std::vector<std::string> keys = getAllKeys(prefix);
-    
-    for (const auto& key : keys) {
-        std::string value;
-        if (get(key, value)) {
-            try {
-                std::string address = key.substr(prefix.length());
-                double balance = std::stod(value);
-                balances[address] = balance;
-            } catch (const std::exception& e) {
-                // Skip invalid entries
-            }
+    // One iterator pass: LevelDB iterators read from an implicit snapshot,
+    // and blocks commit atomically, so this is the state after some block
+    const leveldb::Slice prefix("balance:");
+    std::unique_ptr<leveldb::Iterator> it(db->NewIterator(leveldb::ReadOptions()));
+    for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+        Amount balance;
+        if (parseAmount(it->value().ToString(), balance)) {
+            std::string address(it->key().data() + prefix.size(), it->key().size() - prefix.size());
+            balances[address] = balance;
         }
     }
     
@@ -678,16 +1411,52 @@ std::map<std::string, double> BlockchainDB::getAllBalances() const {
 
 // Helper methods for serialization/deserialization
 std::string BlockchainDB::serializeJournalEntry(const BalanceJournalEntry& entry) const {
-    // Format: address|txHash|amount|isCredit|blockHeight|timestamp
-    return entry.address + "|" + 
-           entry.txHash + "|" + 
-           std::to_string(entry.amount) + "|" + 
-           (entry.isCredit ? "1" : "0") + "|" + 
-           std::to_string(entry.blockHeight) + "|" + 
-           std::to_string(entry.timestamp);
+    BinaryWriter writer;
+    writeRecordHeader(writer);
+    writer.writeHexString(entry.address);
+    writer.writeHexString(entry.txHash);
+    writeAmount(writer, entry.amount);
+    writer.writeByte(entry.isCredit ? 1 : 0);
+    writer.writeVarint(entry.blockHeight);
+    writer.writeSignedVarint(static_cast<int64_t>(entry.timestamp));
+    return writer.release();
 }
 
 BalanceJournalEntry BlockchainDB::deserializeJournalEntry(const std::string& data) const {
+    if (!isBinaryRecord(data)) {
+        return deserializeLegacyJournalEntry(data);
+    }
+    
+    BalanceJournalEntry entry;
+    try {
+        BinaryReader reader(data);
+        readJournalEntry(reader, entry);
+    } catch (const std::exception& e) {
+        // Use defaults if parsing fails, same as the text format
+        entry.amount = 0;
+        entry.isCredit = false;
+        entry.blockHeight = 0;
+        entry.timestamp = 0;
+    }
+    return entry;
+}
+
+BalanceJournalEntry BlockchainDB::decodeJournalRecord(const std::string& data) const {
+    if (!isBinaryRecord(data)) {
+        return deserializeLegacyJournalEntry(data, true);
+    }
+    
+    BalanceJournalEntry entry;
+    BinaryReader reader(data);
+    readJournalEntry(reader, entry);
+    if (!reader.atEnd()) {
+        throw std::runtime_error("Trailing bytes after journal entry");
+    }
+    return entry;
+}
+
+// Pipe-delimited text format used before the binary encoding
+BalanceJournalEntry BlockchainDB::deserializeLegacyJournalEntry(const std::string& data, bool strict) const {
     BalanceJournalEntry entry;
     std::vector<std::string> parts;
     std::string part;
@@ -697,17 +1466,25 @@ BalanceJournalEntry BlockchainDB::deserializeJournalEntry(const std::string& dat
         parts.push_back(part);
     }
     
+    if (strict && parts.size() < 6) {
+        throw std::runtime_error("Invalid journal entry: expected 6 parts, got " + std::to_string(parts.size()));
+    }
     if (parts.size() >= 6) {
         entry.address = parts[0];
         entry.txHash = parts[1];
         try {
-            entry.amount = std::stod(parts[2]);
+            if (!parseAmount(parts[2], entry.amount)) {
+                throw std::runtime_error("Invalid amount: " + parts[2]);
+            }
             entry.isCredit = (parts[3] == "1");
             entry.blockHeight = std::stoull(parts[4]);
             entry.timestamp = std::stoll(parts[5]);
         } catch (const std::exception& e) {
+            if (strict) {
+                throw;
+            }
             // Use defaults if parsing fails
-            entry.amount = 0.0;
+            entry.amount = 0;
             entry.isCredit = false;
             entry.blockHeight = 0;
             entry.timestamp = 0;
@@ -717,16 +1494,49 @@ BalanceJournalEntry BlockchainDB::deserializeJournalEntry(const std::string& dat
     return entry;
 }
 
-std::string BlockchainDB::serializeWorldState(const std::map<std::string, double>& balances) const {
-    std::stringstream ss;
+std::string BlockchainDB::serializeWorldState(const std::map<std::string, Amount>& balances) const {
+    BinaryWriter writer;
+    writeRecordHeader(writer);
+    writer.writeVarint(balances.size());
     for (const auto& pair : balances) {
-        ss << pair.first << ":" << pair.second << "\n";
+        writer.writeHexString(pair.first);
+        writeAmount(writer, pair.second);
     }
-    return ss.str();
+    return writer.release();
 }
 
-std::map<std::string, double> BlockchainDB::deserializeWorldState(const std::string& data) const {
-    std::map<std::string, double> balances;
+std::map<std::string, Amount> BlockchainDB::deserializeWorldState(const std::string& data) const {
+    if (!isBinaryRecord(data)) {
+        return deserializeLegacyWorldState(data);
+    }
+    
+    std::map<std::string, Amount> balances;
+    try {
+        BinaryReader reader(data);
+        readWorldState(reader, balances);
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR in deserializeWorldState: " << e.what() << std::endl;
+    }
+    return balances;
+}
+
+std::map<std::string, Amount> BlockchainDB::decodeWorldStateRecord(const std::string& data) const {
+    if (!isBinaryRecord(data)) {
+        return deserializeLegacyWorldState(data, true);
+    }
+    
+    std::map<std::string, Amount> balances;
+    BinaryReader reader(data);
+    readWorldState(reader, balances);
+    if (!reader.atEnd()) {
+        throw std::runtime_error("Trailing bytes after world state");
+    }
+    return balances;
+}
+
+// Line-based text format used before the binary encoding
+std::map<std::string, Amount> BlockchainDB::deserializeLegacyWorldState(const std::string& data, bool strict) const {
+    std::map<std::string, Amount> balances;
     std::istringstream stream(data);
     std::string line;
     
@@ -734,13 +1544,15 @@ std::map<std::string, double> BlockchainDB::deserializeWorldState(const std::str
         size_t pos = line.find(':');
         if (pos != std::string::npos) {
             std::string address = line.substr(0, pos);
-            try {
-                double balance = std::stod(line.substr(pos + 1));
+            Amount balance;
+            if (parseAmount(line.substr(pos + 1), balance)) {
                 balances[address] = balance;
-            } catch (const std::exception& e) {
-                // Skip invalid entries
+                continue;
             }
         }
+        if (strict && !line.empty()) {
+            throw std::runtime_error("Invalid world state line: " + line);
+        }
     }
     
     return balances;
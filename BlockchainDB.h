@@ -8,17 +8,27 @@
 #include <leveldb/write_batch.h>
 #include "Block.h"
 #include "Transaction.h"
+#include "BlockView.h"
+#include <functional>
 #include <map>
 // Structure to store journal entries
 struct BalanceJournalEntry {
     std::string address;
     std::string txHash;
-    double amount;
+    Amount amount;
     bool isCredit;
     size_t blockHeight;
     time_t timestamp;
 };
 
+// Everything applying one block changes besides the block itself.
+// Filled by BalanceMapping::applyBlock, written by BlockchainDB::commitBlock.
+struct BlockStateChanges {
+    std::map<std::string, Amount> balances;  // Final balance per touched address
+    std::map<std::string, Amount> previousBalances;  // Same addresses before the block, kept as undo data
+    std::vector<BalanceJournalEntry> journal;
+};
+
 class BlockchainDB {
 private:
     std::unique_ptr<leveldb::DB> db;
@@ -41,22 +51,69 @@ public:
     bool getBlock(size_t blockNumber, Block& block) const;
     bool saveTransaction(const Transaction& tx);
     bool getTransaction(const std::string& txHash, Transaction& tx) const;
+    // Block, its transactions, balances and journal in one WriteBatch, so a
+    // crash leaves either all of it or none of it on disk
+    bool commitBlock(const Block& block, const BlockStateChanges& changes);
+    
+    // Undo of commitBlock for the tip block, in one batch: removes the block
+    // and its journal entries and puts back the balances it changed, which
+    // are returned in restoredBalances. Blocks committed before undo data
+    // existed have none; only the block is removed then.
+    bool disconnectBlock(const Block& block, std::map<std::string, Amount>& restoredBalances);
+    bool hasUndoData(size_t blockNumber) const;
+    
+    // Highest block this node has fully validated, with a checksum chained
+    // over the stored records of blocks 0..height so a changed record is
+    // noticed without re-verifying hashes and signatures. commitBlock
+    // advances it when the new block directly extends it.
+    bool getValidatedTip(size_t& blockHeight, std::string& blockHash, std::string& checksum) const;
+    bool setValidatedTip(size_t blockHeight, const std::string& blockHash, const std::string& checksum);
+    // Extends checksum over the records of blocks firstBlock..lastBlock;
+    // start from an empty checksum at block 0
+    bool checksumBlockRecords(size_t firstBlock, size_t lastBlock, std::string& checksum) const;
+    
+    // Zero-copy reads: views point into LevelDB's buffer and are only valid
+    // inside the callback. The visitor returns false to stop early. Returns
+    // false if a block in the range is missing or corrupt.
+    bool withBlockView(size_t blockNumber, const std::function<void(const BlockView&)>& visitor) const;
+    bool forEachBlockView(size_t firstBlock, size_t lastBlock,
+                          const std::function<bool(const BlockView&)>& visitor) const;
+    bool forEachTransactionView(const std::function<bool(const TransactionView&)>& visitor) const;
+    
+    // Appends blocks firstBlock..lastBlock with one sequential scan, stopping
+    // early at the first missing height. Records are decoded on the shared
+    // thread pool while the scan continues. Returns false if a record is
+    // corrupt.
+    bool loadBlocks(size_t firstBlock, size_t lastBlock, std::vector<Block>& blocks) const;
 
     // Wallet balance operations
-    bool updateBalance(const std::string& address, double newBalance);
-    bool getBalance(const std::string& address, double& balance) const;
+    bool updateBalance(const std::string& address, Amount newBalance);
+    bool getBalance(const std::string& address, Amount& balance) const;
     bool addBalanceJournalEntry(const std::string& address, const std::string& txHash, 
-                               double amount, bool isCredit, size_t blockHeight);
+                               Amount amount, bool isCredit, size_t blockHeight);
     std::vector<BalanceJournalEntry> getBalanceJournal(const std::string& address) const;
     
-    // World state operations
-    bool saveWorldState(size_t blockHeight);
-    bool loadWorldState(size_t blockHeight, std::map<std::string, double>& balances) const;
-    std::map<std::string, double> getAllBalances() const;
+    // World state operations. A snapshot holds every balance after the
+    // given block; the latest one is recorded with its block hash so a
+    // restart only has to replay the blocks after it.
+    bool saveWorldState(size_t blockHeight, const std::string& blockHash);
+    bool getLatestWorldState(size_t& blockHeight, std::string& blockHash) const;
+    bool loadWorldState(size_t blockHeight, std::map<std::string, Amount>& balances) const;
+    std::map<std::string, Amount> getAllBalances() const;
 
     // Iterator operations
     std::vector<std::string> getAllKeys(const std::string& prefix = "") const;
     bool verifyDatabaseIntegrity(bool repairCorrupted);
+    
+    // Rewrites block, transaction, journal and world state values still in
+    // the old text format, or an older binary version, into the current
+    // format, and moves blocks from the old decimal height keys. Cheap once
+    // done: a marker key records the format version and later calls return
+    // immediately.
+    bool migrateStorageFormat();
+    
+    // Version written into every binary record
+    static const int STORAGE_FORMAT_VERSION;
 private:
     // Helper methods
     std::string serializeBlock(const Block& block) const;
@@ -67,8 +124,32 @@ private:
     // Helper methods for journal entries
     std::string serializeJournalEntry(const BalanceJournalEntry& entry) const;
     BalanceJournalEntry deserializeJournalEntry(const std::string& data) const;
-    std::string serializeWorldState(const std::map<std::string, double>& balances) const;
-    std::map<std::string, double> deserializeWorldState(const std::string& data) const;
+    std::string serializeWorldState(const std::map<std::string, Amount>& balances) const;
+    std::map<std::string, Amount> deserializeWorldState(const std::string& data) const;
+    
+    // Same as the deserializers, but throw on anything they would skip or
+    // replace with defaults. Migration uses these so a damaged record is
+    // left alone instead of being rewritten with what could be read of it.
+    Block decodeBlockRecord(const std::string& data) const;
+    BalanceJournalEntry decodeJournalRecord(const std::string& data) const;
+    std::map<std::string, Amount> decodeWorldStateRecord(const std::string& data) const;
+    
+    // Parse a stored value into a view. Text records are decoded into the
+    // storage argument, which the view then points into. Throws if corrupt.
+    void parseBlockRecord(const char* data, size_t size, BlockView& view, Block& legacyStorage) const;
+    void parseTransactionRecord(const char* data, size_t size, TransactionView& view,
+                                Transaction& legacyStorage) const;
+    
+    // Readers for the pipe/line delimited text format used before the
+    // binary records; kept so old databases still load. Unless strict, they
+    // skip or default what they can't parse.
+    Block deserializeLegacyBlock(const std::string& data, bool strict = false) const;
+    Transaction deserializeLegacyTransaction(const std::string& data) const;
+    BalanceJournalEntry deserializeLegacyJournalEntry(const std::string& data, bool strict = false) const;
+    std::map<std::string, Amount> deserializeLegacyWorldState(const std::string& data, bool strict = false) const;
+    
+    // Moves blocks stored under "block:<decimal height>" to the ordered keys
+    bool migrateBlockKeys();
 };
 
 #endif // BLOCKCHAIN_DB_H
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "ChainStore.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "BlockchainDB.h"
+
+namespace {
+
+// Blocks read per database scan when walking outside the window
+const size_t SCAN_BATCH_SIZE = 512;
+
+} // namespace
+
+BlockHeader headerOf(const Block& block) {
+    return BlockHeader{block.blockNumber, block.timestamp, block.previousHash, block.hash,
+                       block.nonce, block.difficulty, block.version, block.transactions.size()};
+}
+
+double blockWork(int difficulty) {
+    return std::pow(16.0, difficulty);
+}
+
+bool meetsDifficulty(const std::string& hash, int difficulty) {
+    if (difficulty < 1 || hash.size() < 2 + static_cast<size_t>(difficulty) || hash.compare(0, 2, "0x") != 0) {
+        return false;
+    }
+    return std::all_of(hash.begin() + 2, hash.begin() + 2 + difficulty, [](char c) { return c == '0'; });
+}
+
+ChainStore::ChainStore(size_t windowSize)
+    : db(nullptr), windowSize(windowSize), hits(0), misses(0) {
+}
+
+void ChainStore::setDatabase(const BlockchainDB* database) {
+    std::lock_guard<std::mutex> lock(mutex);
+    db = database;
+    trimWindow();
+}
+
+void ChainStore::setWindowSize(size_t blocks) {
+    std::lock_guard<std::mutex> lock(mutex);
+    windowSize = blocks;
+    trimWindow();
+}
+
+void ChainStore::append(Block block) {
+    if (static_cast<size_t>(block.blockNumber) != headers.size()) {
+        throw std::runtime_error("Block #" + std::to_string(block.blockNumber) +
+                                 " does not extend a chain of " + std::to_string(headers.size()) + " blocks");
+    }
+
+    auto stored = std::make_shared<const Block>(std::move(block));
+    headers.push_back(headerOf(*stored));
+    work.push_back(totalWork() + blockWork(stored->difficulty));
+    heightByHash[stored->hash] = headers.size() - 1;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    // The old tip stays around as the most recently used block
+    if (tipBlock) {
+        remember(tipBlock);
+    }
+    tipBlock = stored;
+    trimWindow();
+}
+
+void ChainStore::popTip() {
+    if (headers.empty()) {
+        throw std::out_of_range("No block to remove");
+    }
+    std::shared_ptr<const Block> newTip;
+    if (headers.size() > 1) {
+        newTip = get(headers.size() - 2);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    heightByHash.erase(headers.back().hash);
+    headers.pop_back();
+    work.pop_back();
+    // The tip is held on its own, not in the window
+    if (newTip) {
+        auto found = windowIndex.find(headers.size() - 1);
+        if (found != windowIndex.end()) {
+            window.erase(found->second);
+            windowIndex.erase(found);
+        }
+    }
+    tipBlock = newTip;
+}
+
+void ChainStore::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    headers.clear();
+    work.clear();
+    heightByHash.clear();
+    tipBlock.reset();
+    window.clear();
+    windowIndex.clear();
+}
+
+bool ChainStore::findHeight(const std::string& hash, size_t& height) const {
+    auto found = heightByHash.find(hash);
+    if (found == heightByHash.end()) {
+        return false;
+    }
+    height = found->second;
+    return true;
+}
+
+std::shared_ptr<const Block> ChainStore::get(size_t height) const {
+    if (height >= headers.size()) {
+        throw std::out_of_range("Block index out of range");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (height == headers.size() - 1) {
+        return tipBlock;
+    }
+
+    auto found = windowIndex.find(height);
+    if (found != windowIndex.end()) {
+        hits++;
+        window.splice(window.begin(), window, found->second);
+        return *found->second;
+    }
+    misses++;
+
+    Block loaded(static_cast<int>(height), 0, {}, "0x0", "", 0, 1, Block::CURRENT_VERSION);
+    if (!db || !db->getBlock(height, loaded)) {
+        throw std::runtime_error("Block #" + std::to_string(height) + " is not available");
+    }
+    auto block = std::make_shared<const Block>(std::move(loaded));
+    remember(block);
+    trimWindow();
+    return block;
+}
+
+void ChainStore::forEach(size_t firstBlock, const std::function<bool(const Block&)>& visitor) const {
+    std::vector<Block> batch;
+    size_t height = firstBlock;
+    while (height < headers.size()) {
+        std::shared_ptr<const Block> resident;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (height == headers.size() - 1) {
+                resident = tipBlock;
+            } else {
+                auto found = windowIndex.find(height);
+                if (found != windowIndex.end()) {
+                    resident = *found->second;
+                }
+            }
+        }
+
+        if (resident || !db) {
+            if (!visitor(resident ? *resident : *get(height))) {
+                return;
+            }
+            height++;
+            continue;
+        }
+
+        // Read ahead from the database in one ordered scan
+        size_t lastBlock = std::min(height + SCAN_BATCH_SIZE, headers.size()) - 1;
+        batch.clear();
+        if (!db->loadBlocks(height, lastBlock, batch) || batch.empty()) {
+            throw std::runtime_error("Block #" + std::to_string(height) + " is not available: " + db->getLastError());
+        }
+        for (const auto& block : batch) {
+            if (!visitor(block)) {
+                return;
+            }
+        }
+        height += batch.size();
+    }
+}
+
+size_t ChainStore::residentBlocks() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return window.size() + (tipBlock ? 1 : 0);
+}
+
+void ChainStore::remember(const std::shared_ptr<const Block>& block) const {
+    size_t height = static_cast<size_t>(block->blockNumber);
+    auto found = windowIndex.find(height);
+    if (found != windowIndex.end()) {
+        window.splice(window.begin(), window, found->second);
+        return;
+    }
+    window.push_front(block);
+    windowIndex[height] = window.begin();
+}
+
+void ChainStore::trimWindow() const {
+    // Without a database there is nowhere to page blocks back in from
+    if (!db) {
+        return;
+    }
+    while (window.size() > windowSize) {
+        windowIndex.erase(static_cast<size_t>(window.back()->blockNumber));
+        window.pop_back();
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef CHAINSTORE_H
+#define CHAINSTORE_H
+
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Block.h"
+
+class BlockchainDB;
+
+// Work a block of this difficulty stands for. Each leading hex zero makes a
+// hash 16 times harder to find, so this is 16^difficulty.
+double blockWork(int difficulty);
+// Whether a hash has the difficulty's worth of leading zeros after "0x"
+bool meetsDifficulty(const std::string& hash, int difficulty);
+
+// Everything about a block except its transactions
+struct BlockHeader {
+    int blockNumber;
+    time_t timestamp;
+    std::string previousHash;
+    std::string hash;
+    int nonce;
+    int difficulty;
+    int version;
+    size_t transactionCount;
+};
+
+BlockHeader headerOf(const Block& block);
+
+// The chain as the node sees it: a header for every block, plus full blocks
+// for the tip and an LRU window of recently used ones. Blocks outside the
+// window are read back from the database when asked for, so memory stays
+// flat as the chain grows. Without a database nothing is ever dropped.
+class ChainStore {
+public:
+    explicit ChainStore(size_t windowSize = DEFAULT_WINDOW_SIZE);
+
+    ChainStore(const ChainStore&) = delete;
+    ChainStore& operator=(const ChainStore&) = delete;
+
+    void setDatabase(const BlockchainDB* database);
+    void setWindowSize(size_t blocks);
+
+    // The block must be the next height. Older blocks may leave the window,
+    // so they must already be in the database.
+    void append(Block block);
+    // Drop the tip. The block below becomes the tip and is read back from
+    // the database if it left the window.
+    void popTip();
+    void clear();
+
+    size_t size() const { return headers.size(); }
+    bool empty() const { return headers.empty(); }
+    const BlockHeader& header(size_t height) const { return headers.at(height); }
+    // Valid until the next append
+    const Block& tip() const { return *tipBlock; }
+    bool contains(const std::string& hash) const { return heightByHash.count(hash) > 0; }
+    bool findHeight(const std::string& hash, size_t& height) const;
+    // Total work of blocks 0..height
+    double chainWork(size_t height) const { return work.at(height); }
+    double totalWork() const { return work.empty() ? 0 : work.back(); }
+
+    // Throws if the height is out of range or the block can't be read
+    std::shared_ptr<const Block> get(size_t height) const;
+
+    // Visit blocks from firstBlock to the tip in order until the visitor
+    // returns false. Blocks outside the window are read in ordered batches
+    // and are not added to it, so a full scan doesn't flush the window.
+    void forEach(size_t firstBlock, const std::function<bool(const Block&)>& visitor) const;
+
+    size_t residentBlocks() const;
+    uint64_t getHits() const { return hits; }
+    uint64_t getMisses() const { return misses; }
+
+    static const size_t DEFAULT_WINDOW_SIZE = 1024;
+
+private:
+    using Window = std::list<std::shared_ptr<const Block>>;
+
+    // Callers hold mutex
+    void remember(const std::shared_ptr<const Block>& block) const;
+    void trimWindow() const;
+
+    const BlockchainDB* db;
+    size_t windowSize;
+    std::vector<BlockHeader> headers;
+    std::vector<double> work;  // Cumulative, per height
+    std::unordered_map<std::string, size_t> heightByHash;
+    std::shared_ptr<const Block> tipBlock;
+
+    // Most recently used first
+    mutable std::mutex mutex;
+    mutable Window window;
+    mutable std::unordered_map<size_t, Window::iterator> windowIndex;
+    mutable uint64_t hits;
+    mutable uint64_t misses;
+};
+
+#endif // CHAINSTORE_H
@@ -0,0 +1,343 @@
+#include "ChainSync.h"
+#include <algorithm>
+#include <iostream>
+
+const size_t ChainSync::MAX_HEADERS_PER_MESSAGE = 2000;
+const size_t ChainSync::MAX_BLOCKS_PER_MESSAGE = 128;
+const size_t ChainSync::BLOCKS_PER_REQUEST = 64;
+const size_t ChainSync::MAX_REQUESTS_PER_PEER = 2;
+const size_t ChainSync::MAX_BLOCKS_AHEAD = 1024;
+const std::chrono::seconds ChainSync::REQUEST_TIMEOUT(30);
+
+namespace {
+
+// Locator entries taken one block apart before the steps start doubling
+const size_t DENSE_LOCATOR_HASHES = 10;
+
+} // namespace
+
+ChainSync::ChainSync(Blockchain& blockchain)
+    : blockchain(blockchain), handedOver(0), nextHeight(0) {
+}
+
+std::vector<std::string> ChainSync::locator() {
+    std::lock_guard<std::mutex> lock(mutex);
+    followChain();
+
+    std::vector<std::string> hashes;
+    size_t height = bestHeight();
+    size_t step = 1;
+    while (true) {
+        hashes.push_back(hashAt(height));
+        if (height == 0) {
+            break;
+        }
+        if (hashes.size() >= DENSE_LOCATOR_HASHES) {
+            step *= 2;
+        }
+        height = height > step ? height - step : 0;
+    }
+    return hashes;
+}
+
+size_t ChainSync::findForkPoint(const Blockchain& blockchain, const std::vector<std::string>& locator) {
+    for (const auto& hash : locator) {
+        size_t height;
+        if (blockchain.getChainStore().findHeight(hash, height)) {
+            return height;
+        }
+    }
+    return 0;
+}
+
+bool ChainSync::addHeaders(const std::string& peerId, const std::vector<BlockHeader>& newHeaders) {
+    std::lock_guard<std::mutex> lock(mutex);
+    followChain();
+    if (newHeaders.empty()) {
+        return true;
+    }
+
+    for (size_t i = 0; i < newHeaders.size(); i++) {
+        const BlockHeader& header = newHeaders[i];
+        // The block hash covers the transactions, so a header alone can't be
+        // rehashed. Its hash must at least have the leading zeros it claims;
+        // the full block is checked against it when it arrives.
+        if (header.blockNumber < 1 || header.difficulty < blockchain.getDifficulty() ||
+            !meetsDifficulty(header.hash, header.difficulty)) {
+            std::cerr << "Invalid header #" << header.blockNumber << " from " << peerId << std::endl;
+            return false;
+        }
+        if (i > 0 && (header.blockNumber != newHeaders[i - 1].blockNumber + 1 ||
+                      header.previousHash != newHeaders[i - 1].hash)) {
+            std::cerr << "Headers from " << peerId << " are not linked at #" << header.blockNumber << std::endl;
+            return false;
+        }
+    }
+
+    // The first header builds on a block from our locator
+    size_t parent = static_cast<size_t>(newHeaders.front().blockNumber) - 1;
+    if (parent > bestHeight() || hashAt(parent) != newHeaders.front().previousHash) {
+        std::cerr << "Headers from " << peerId << " don't connect to our chain at #" << parent << std::endl;
+        return false;
+    }
+
+    // Skip what we already have
+    size_t skip = 0;
+    while (skip < newHeaders.size() && static_cast<size_t>(newHeaders[skip].blockNumber) <= bestHeight() &&
+           hashAt(newHeaders[skip].blockNumber) == newHeaders[skip].hash) {
+        skip++;
+    }
+    if (skip == newHeaders.size()) {
+        size_t& peerHeight = peerHeights[peerId];
+        peerHeight = std::max<size_t>(peerHeight, newHeaders.back().blockNumber);
+        return true;
+    }
+
+    // Only follow a branch with more work than the best one we know
+    size_t divergence = static_cast<size_t>(newHeaders[skip].blockNumber);
+    double theirs = workAt(divergence - 1);
+    for (size_t i = skip; i < newHeaders.size(); i++) {
+        theirs += blockWork(newHeaders[i].difficulty);
+    }
+    if (theirs <= bestWork()) {
+        size_t& peerHeight = peerHeights[peerId];
+        peerHeight = std::max(peerHeight, divergence - 1);
+        std::cout << "Peer " << peerId << " is on a lighter branch forking at #" << divergence - 1 << std::endl;
+        return true;
+    }
+
+    if (divergence <= bestHeight()) {
+        dropHeadersFrom(divergence);
+    }
+    headers.insert(headers.end(), newHeaders.begin() + skip, newHeaders.end());
+    nextHeight = std::min(nextHeight, divergence);
+    peerHeights[peerId] = newHeaders.back().blockNumber;
+
+    std::cout << "Accepted " << newHeaders.size() - skip << " headers from " << peerId
+              << ", best header now #" << bestHeight();
+    if (divergence < blockchain.getChainSize()) {
+        std::cout << " on a heavier branch forking at #" << divergence - 1;
+    }
+    std::cout << std::endl;
+    return true;
+}
+
+bool ChainSync::nextRange(const std::string& peerId, BlockRange& range) {
+    std::lock_guard<std::mutex> lock(mutex);
+    followChain();
+
+    auto known = peerHeights.find(peerId);
+    if (known == peerHeights.end()) {
+        return false;
+    }
+    size_t peerHeight = std::min(known->second, bestHeight());
+
+    size_t outstanding = std::count_if(inFlight.begin(), inFlight.end(),
+                                       [&](const Request& request) { return request.peerId == peerId; });
+    if (outstanding >= MAX_REQUESTS_PER_PEER) {
+        return false;
+    }
+
+    bool found = false;
+    for (auto it = retry.begin(); it != retry.end(); ++it) {
+        if (it->firstBlock + it->count - 1 <= peerHeight) {
+            range = *it;
+            retry.erase(it);
+            found = true;
+            break;
+        }
+    }
+
+    if (!found) {
+        if (nextHeight > peerHeight || nextHeight >= baseHeight() + handedOver + MAX_BLOCKS_AHEAD) {
+            return false;
+        }
+        range.firstBlock = nextHeight;
+        range.count = std::min(BLOCKS_PER_REQUEST, peerHeight - nextHeight + 1);
+        nextHeight += range.count;
+    }
+
+    inFlight.push_back(Request{peerId, range, std::chrono::steady_clock::now()});
+    return true;
+}
+
+size_t ChainSync::addBlocks(const std::string& peerId, const std::vector<Block>& blocks) {
+    std::lock_guard<std::mutex> lock(mutex);
+    followChain();
+
+    // A peer answers its requests in the order they were sent
+    auto request = std::find_if(inFlight.begin(), inFlight.end(),
+                                [&](const Request& pending) { return pending.peerId == peerId; });
+    if (request == inFlight.end()) {
+        std::cerr << "Ignoring " << blocks.size() << " unrequested blocks from " << peerId << std::endl;
+        return 0;
+    }
+    BlockRange range = request->range;
+    inFlight.erase(request);
+
+    // Blocks below this the chain already has
+    size_t needed = baseHeight() + handedOver;
+    size_t delivered = 0;
+    for (const auto& block : blocks) {
+        size_t height = range.firstBlock + delivered;
+        if (delivered == range.count || static_cast<size_t>(block.blockNumber) != height) {
+            break;
+        }
+        if (height >= needed) {
+            if (height > bestHeight() || block.hash != hashAt(height) || block.calculateHash() != block.hash) {
+                std::cerr << "Block #" << height << " from " << peerId << " doesn't match its header" << std::endl;
+                peerHeights.erase(peerId);
+                break;
+            }
+            downloaded.emplace(height, block);
+        }
+        delivered++;
+    }
+
+    if (delivered < range.count) {
+        BlockRange rest{range.firstBlock + delivered, range.count - delivered};
+        if (rest.firstBlock <= bestHeight()) {
+            rest.count = std::min<uint64_t>(rest.count, bestHeight() - rest.firstBlock + 1);
+            retry.push_back(rest);
+        }
+    }
+
+    // In height order; the chain switches branches by itself once ours is heavier
+    size_t handed = 0;
+    while (handedOver < headers.size()) {
+        auto next = downloaded.find(headers[handedOver].blockNumber);
+        if (next == downloaded.end()) {
+            break;
+        }
+        try {
+            blockchain.addExistingBlock(next->second);
+        } catch (const std::exception& e) {
+            // The headers led to a block we won't accept, so they're no good either
+            std::cerr << "Error adding block #" << next->first << ": " << e.what() << std::endl;
+            reset();
+            return handed;
+        }
+        downloaded.erase(next);
+        handedOver++;
+        handed++;
+        followChain();
+    }
+
+    if (handed > 0 && headers.empty()) {
+        std::cout << "Chain synced to block #" << blockchain.getChainSize() - 1 << std::endl;
+    }
+    return handed;
+}
+
+void ChainSync::requeueStalled() {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = inFlight.begin(); it != inFlight.end();) {
+        if (now - it->sent < REQUEST_TIMEOUT) {
+            ++it;
+            continue;
+        }
+        std::cerr << "Blocks #" << it->range.firstBlock << "-" << it->range.firstBlock + it->range.count - 1
+                  << " from " << it->peerId << " timed out" << std::endl;
+        retry.push_back(it->range);
+        peerHeights.erase(it->peerId);
+        it = inFlight.erase(it);
+    }
+}
+
+bool ChainSync::isSyncing() {
+    std::lock_guard<std::mutex> lock(mutex);
+    followChain();
+    return !headers.empty();
+}
+
+size_t ChainSync::getBestHeaderHeight() {
+    std::lock_guard<std::mutex> lock(mutex);
+    followChain();
+    return bestHeight();
+}
+
+void ChainSync::followChain() {
+    // Blocks also arrive by gossip or get mined here. Headers whose blocks
+    // are on the main chain are done with.
+    size_t chainSize = blockchain.getChainSize();
+    while (!headers.empty() && static_cast<size_t>(headers.front().blockNumber) < chainSize &&
+           blockchain.getBlockHeader(headers.front().blockNumber).hash == headers.front().hash) {
+        headers.pop_front();
+        handedOver = handedOver > 0 ? handedOver - 1 : 0;
+    }
+
+    // The rest has to branch off the main chain and still outweigh it
+    if (!headers.empty()) {
+        size_t parent = static_cast<size_t>(headers.front().blockNumber) - 1;
+        if (parent >= chainSize || blockchain.getBlockHeader(parent).hash != headers.front().previousHash ||
+            bestWork() <= blockchain.getChainWork()) {
+            reset();
+            return;
+        }
+    }
+    downloaded.erase(downloaded.begin(), downloaded.lower_bound(baseHeight()));
+    nextHeight = std::max(nextHeight, baseHeight());
+}
+
+void ChainSync::reset() {
+    headers.clear();
+    handedOver = 0;
+    peerHeights.clear();
+    retry.clear();
+    inFlight.clear();
+    downloaded.clear();
+    nextHeight = blockchain.getChainSize();
+}
+
+void ChainSync::dropHeadersFrom(size_t height) {
+    if (!headers.empty()) {
+        size_t base = baseHeight();
+        headers.resize(height > base ? height - base : 0);
+        handedOver = std::min(handedOver, headers.size());
+    }
+    downloaded.erase(downloaded.lower_bound(height), downloaded.end());
+    for (auto it = retry.begin(); it != retry.end();) {
+        if (it->firstBlock >= height) {
+            it = retry.erase(it);
+            continue;
+        }
+        it->count = std::min<uint64_t>(it->count, height - it->firstBlock);
+        ++it;
+    }
+    for (auto& known : peerHeights) {
+        known.second = std::min(known.second, height - 1);
+    }
+    nextHeight = std::min(nextHeight, height);
+}
+
+size_t ChainSync::baseHeight() const {
+    return headers.empty() ? blockchain.getChainSize() : headers.front().blockNumber;
+}
+
+size_t ChainSync::bestHeight() const {
+    return headers.empty() ? blockchain.getChainSize() - 1 : headers.back().blockNumber;
+}
+
+double ChainSync::bestWork() const {
+    return headers.empty() ? blockchain.getChainWork() : workAt(bestHeight());
+}
+
+double ChainSync::workAt(size_t height) const {
+    size_t base = baseHeight();
+    if (height < base) {
+        return blockchain.getChainStore().chainWork(height);
+    }
+    double work = blockchain.getChainStore().chainWork(base - 1);
+    for (size_t i = 0; i + base <= height; i++) {
+        work += blockWork(headers[i].difficulty);
+    }
+    return work;
+}
+
+const std::string& ChainSync::hashAt(size_t height) const {
+    if (!headers.empty() && height >= static_cast<size_t>(headers.front().blockNumber)) {
+        return headers[height - headers.front().blockNumber].hash;
+    }
+    return blockchain.getBlockHeader(height).hash;
+}
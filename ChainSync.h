@@ -0,0 +1,92 @@
+#ifndef CHAINSYNC_H
+#define CHAINSYNC_H
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Blockchain.h"
+#include "ChainStore.h"
+#include "WireProtocol.h"
+
+// Headers-first catch-up with peers.
+//
+// We send a block locator and peers answer with the headers that follow
+// the newest block we share. The heaviest header branch we hear of is kept
+// alongside the chain: it either extends our tip or forks below it with
+// more work. Its blocks are fetched in ranges spread over every peer that
+// has them and handed to the chain in height order as they arrive, which
+// reorganizes onto the branch once it outweighs ours. Only blocks we don't
+// have are downloaded, and each one from a single peer.
+class ChainSync {
+public:
+    explicit ChainSync(Blockchain& blockchain);
+
+    ChainSync(const ChainSync&) = delete;
+    ChainSync& operator=(const ChainSync&) = delete;
+
+    // Hashes from our best header back to genesis, one per block near the
+    // tip and exponentially sparser further down
+    std::vector<std::string> locator();
+
+    // Height of the first locator hash that is on our chain, 0 if none is
+    static size_t findForkPoint(const Blockchain& blockchain, const std::vector<std::string>& locator);
+
+    // Headers a peer sent for our locator. Returns false if they don't link
+    // up or don't meet the difficulty they claim.
+    bool addHeaders(const std::string& peerId, const std::vector<BlockHeader>& headers);
+
+    // Next range to ask this peer for; false if it has nothing we need or
+    // already has enough requests outstanding
+    bool nextRange(const std::string& peerId, BlockRange& range);
+
+    // Blocks a peer sent for its oldest outstanding range. Blocks matching
+    // the headers go to the chain once everything below them has, and
+    // whatever the peer didn't deliver goes back to be asked of someone
+    // else. Returns the number of blocks handed to the chain.
+    size_t addBlocks(const std::string& peerId, const std::vector<Block>& blocks);
+
+    // Hand ranges that went unanswered for too long to other peers
+    void requeueStalled();
+
+    bool isSyncing();
+    size_t getBestHeaderHeight();
+
+    static const size_t MAX_HEADERS_PER_MESSAGE;
+    static const size_t MAX_BLOCKS_PER_MESSAGE;
+    static const size_t BLOCKS_PER_REQUEST;
+    static const size_t MAX_REQUESTS_PER_PEER;
+    static const size_t MAX_BLOCKS_AHEAD;      // Downloaded but not yet connected
+    static const std::chrono::seconds REQUEST_TIMEOUT;
+
+private:
+    struct Request {
+        std::string peerId;
+        BlockRange range;
+        std::chrono::steady_clock::time_point sent;
+    };
+
+    // Callers hold mutex
+    void followChain();
+    void reset();
+    void dropHeadersFrom(size_t height);
+    size_t baseHeight() const;
+    size_t bestHeight() const;
+    double bestWork() const;
+    double workAt(size_t height) const;
+    const std::string& hashAt(size_t height) const;
+
+    Blockchain& blockchain;
+    std::mutex mutex;
+    std::deque<BlockHeader> headers;            // Checked branch off the main chain, lowest first
+    size_t handedOver;                          // Leading headers whose blocks the chain has
+    std::map<std::string, size_t> peerHeights;  // Highest header each peer can serve
+    std::deque<BlockRange> retry;               // Ranges to hand out again
+    size_t nextHeight;                          // Lowest height not handed out yet
+    std::vector<Request> inFlight;              // Oldest first
+    std::map<size_t, Block> downloaded;         // Waiting for the blocks below them
+};
+
+#endif // CHAINSYNC_H
@@ -0,0 +1,130 @@
+#include "Mempool.h"
+#include <iostream>
+
+Mempool::Mempool(size_t maxBytes)
+    : maxBytes(maxBytes), usedBytes(0), nextSequence(0) {
+}
+
+size_t Mempool::estimateBytes(const Transaction& tx) {
+    // Object plus string payloads, plus a rough allowance for the three
+    // index entries pointing at it
+    return sizeof(Entry) + tx.sender.capacity() + tx.senderPublicKey.capacity() +
+           tx.receiver.capacity() + tx.hash.capacity() * 3 + tx.signature.capacity() + 128;
+}
+
+bool Mempool::add(const Transaction& tx) {
+    if (entries.count(tx.hash)) {
+        return false;
+    }
+    
+    PriorityKey priority{tx.timestamp, nextSequence++};
+    size_t bytes = estimateBytes(tx);
+    
+    // When full, a transaction that would rank last is turned away rather
+    // than admitted and immediately evicted
+    if (usedBytes + bytes > maxBytes && !priorityOrder.empty() &&
+        !(priority < priorityOrder.rbegin()->first)) {
+        std::cerr << "Mempool full, rejecting transaction " << tx.hash << std::endl;
+        return false;
+    }
+    
+    entries.emplace(tx.hash, Entry{tx, priority, bytes});
+    priorityOrder.emplace(priority, tx.hash);
+    SenderState& sender = bySender[tx.sender];
+    sender.hashes.insert(tx.hash);
+    sender.pendingSpend += tx.amount;
+    usedBytes += bytes;
+    
+    evictToLimit();
+    return entries.count(tx.hash) > 0;
+}
+
+void Mempool::evictToLimit() {
+    while (usedBytes > maxBytes && !priorityOrder.empty()) {
+        std::string victim = priorityOrder.rbegin()->second;
+        std::cerr << "Mempool full, evicting transaction " << victim << std::endl;
+        remove(victim);
+    }
+}
+
+bool Mempool::remove(const std::string& hash) {
+    auto found = entries.find(hash);
+    if (found == entries.end()) {
+        return false;
+    }
+    
+    const Entry& entry = found->second;
+    priorityOrder.erase(entry.priority);
+    
+    auto senderIt = bySender.find(entry.tx.sender);
+    if (senderIt != bySender.end()) {
+        senderIt->second.hashes.erase(hash);
+        senderIt->second.pendingSpend -= entry.tx.amount;
+        if (senderIt->second.hashes.empty()) {
+            bySender.erase(senderIt);
+        }
+    }
+    
+    usedBytes -= entry.bytes;
+    entries.erase(found);
+    return true;
+}
+
+void Mempool::removeAll(const std::vector<Transaction>& txs) {
+    for (const auto& tx : txs) {
+        remove(tx.hash);
+    }
+}
+
+void Mempool::clear() {
+    entries.clear();
+    priorityOrder.clear();
+    bySender.clear();
+    usedBytes = 0;
+}
+
+bool Mempool::contains(const std::string& hash) const {
+    return entries.count(hash) > 0;
+}
+
+const Transaction* Mempool::find(const std::string& hash) const {
+    auto found = entries.find(hash);
+    return found == entries.end() ? nullptr : &found->second.tx;
+}
+
+std::vector<const Transaction*> Mempool::fromSender(const std::string& sender) const {
+    std::vector<const Transaction*> result;
+    auto senderIt = bySender.find(sender);
+    if (senderIt == bySender.end()) {
+        return result;
+    }
+    
+    result.reserve(senderIt->second.hashes.size());
+    for (const auto& hash : senderIt->second.hashes) {
+        result.push_back(&entries.at(hash).tx);
+    }
+    return result;
+}
+
+Amount Mempool::pendingSpend(const std::string& sender) const {
+    auto senderIt = bySender.find(sender);
+    return senderIt == bySender.end() ? 0 : senderIt->second.pendingSpend;
+}
+
+std::vector<const Transaction*> Mempool::byPriority() const {
+    std::vector<const Transaction*> result;
+    result.reserve(entries.size());
+    for (const auto& item : priorityOrder) {
+        result.push_back(&entries.at(item.second).tx);
+    }
+    return result;
+}
+
+std::vector<Transaction> Mempool::toVector() const {
+    std::vector<Transaction> result;
+    result.reserve(entries.size());
+    for (const auto& item : priorityOrder) {
+        result.push_back(entries.at(item.second).tx);
+    }
+    return result;
+}
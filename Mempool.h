@@ -0,0 +1,82 @@
+#ifndef MEMPOOL_H
+#define MEMPOOL_H
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Transaction.h"
+
+// Pending transactions waiting to be mined.
+// Indexed by hash for O(1) duplicate checks and lookups, by sender, and by
+// priority for block selection. Transactions carry no fee, so priority is
+// oldest timestamp first with arrival order breaking ties. The pool is
+// bounded by an estimate of the memory it holds; when full, the lowest
+// priority transactions are evicted first.
+class Mempool {
+public:
+    explicit Mempool(size_t maxBytes = DEFAULT_MAX_BYTES);
+
+    // Returns false if the hash is already pooled, or if the pool is full and
+    // the transaction would be the first one evicted
+    bool add(const Transaction& tx);
+    bool remove(const std::string& hash);
+    // Drop every transaction that appears in txs (e.g. a newly added block)
+    void removeAll(const std::vector<Transaction>& txs);
+    void clear();
+
+    bool contains(const std::string& hash) const;
+    const Transaction* find(const std::string& hash) const;
+    std::vector<const Transaction*> fromSender(const std::string& sender) const;
+    // Total amount the sender's pooled transactions will spend; kept up to
+    // date on every add, remove and eviction so lookups are O(1)
+    Amount pendingSpend(const std::string& sender) const;
+
+    // Highest priority first
+    std::vector<const Transaction*> byPriority() const;
+    std::vector<Transaction> toVector() const;
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    size_t memoryUsage() const { return usedBytes; }
+    size_t getMaxBytes() const { return maxBytes; }
+
+    static const size_t DEFAULT_MAX_BYTES = 64 * 1024 * 1024;
+
+private:
+    struct PriorityKey {
+        unsigned long timestamp;
+        uint64_t sequence;
+        bool operator<(const PriorityKey& other) const {
+            if (timestamp != other.timestamp) {
+                return timestamp < other.timestamp;
+            }
+            return sequence < other.sequence;
+        }
+    };
+
+    struct Entry {
+        Transaction tx;
+        PriorityKey priority;
+        size_t bytes;
+    };
+
+    static size_t estimateBytes(const Transaction& tx);
+    void evictToLimit();
+
+    size_t maxBytes;
+    size_t usedBytes;
+    uint64_t nextSequence;
+    std::unordered_map<std::string, Entry> entries;                   // by hash
+    std::map<PriorityKey, std::string> priorityOrder;                 // priority -> hash
+    struct SenderState {
+        std::set<std::string> hashes;
+        Amount pendingSpend = 0;
+    };
+
+    std::unordered_map<std::string, SenderState> bySender;
+};
+
+#endif // MEMPOOL_H
@@ -0,0 +1,126 @@
+#include "Miner.h"
+#include "sha.h"
+#include "sha_multibuffer.h"
+#include <atomic>
+#include <charconv>
+#include <climits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+const int Miner::RANGE_SIZE = 4096;
+
+Miner::Miner(unsigned int threadCount) : threadCount(threadCount) {
+    if (this->threadCount == 0) {
+        this->threadCount = std::thread::hardware_concurrency();
+    }
+    if (this->threadCount == 0) {
+        this->threadCount = 1;
+    }
+}
+
+int Miner::findNonce(const Block& block, std::string& hashOut) const {
+    // Everything except the nonce is fixed while mining, so build it once
+    const std::string prefix = block.headerPrefix();
+    const std::string payload = block.transactionPayload();
+    const int difficulty = block.difficulty;
+    const bool legacyLayout = (block.version == Block::VERSION_LEGACY);
+
+    // With the midstate layout only the nonce at the end changes, so the
+    // SHA-256 state of the header and transactions is computed once
+    const SHA256Midstate midstate(legacyLayout ? std::string() : prefix + payload);
+
+    // Ranges are handed out in increasing order, so once a winner is known
+    // any range starting above it can be skipped
+    std::atomic<long long> nextNonce(static_cast<long long>(block.nonce) + 1);
+    std::atomic<long long> bestNonce(LLONG_MAX);
+    std::mutex resultMutex;
+    std::string bestHash;
+
+    // Candidates are hashed a batch at a time so the multi-buffer kernel
+    // can fill all of its SIMD lanes
+    const size_t batchSize = SHA256MultiBuffer::laneCount();
+
+    auto worker = [&]() {
+        std::vector<std::string> messages(batchSize);
+        for (auto& message : messages) {
+            message.reserve(legacyLayout ? prefix.size() + payload.size() + 16 : 16);
+        }
+        std::vector<SHA256Digest> digests(batchSize);
+        char nonceText[16];
+
+        while (true) {
+            long long start = nextNonce.fetch_add(RANGE_SIZE);
+            if (start > INT_MAX || start >= bestNonce.load()) {
+                return;
+            }
+            long long end = std::min<long long>(start + RANGE_SIZE, static_cast<long long>(INT_MAX) + 1);
+
+            for (long long first = start; first < end; first += batchSize) {
+                // Another worker already found a lower nonce
+                if (first >= bestNonce.load(std::memory_order_relaxed)) {
+                    return;
+                }
+                size_t count = static_cast<size_t>(std::min<long long>(batchSize, end - first));
+
+                for (size_t lane = 0; lane < count; lane++) {
+                    // Same text std::to_string would produce, without the allocation
+                    char* nonceEnd = std::to_chars(nonceText, nonceText + sizeof(nonceText), first + static_cast<long long>(lane)).ptr;
+                    size_t nonceLength = nonceEnd - nonceText;
+
+                    if (legacyLayout) {
+                        messages[lane].assign(prefix);
+                        messages[lane].append(nonceText, nonceLength);
+                        messages[lane] += payload;
+                    } else {
+                        messages[lane].assign(nonceText, nonceLength);
+                    }
+                }
+
+                if (legacyLayout) {
+                    SHA256MultiBuffer::hash(messages.data(), count, digests.data());
+                } else {
+                    SHA256MultiBuffer::hashSuffixes(midstate, messages.data(), count, digests.data());
+                }
+
+                // Lanes are checked in nonce order so the lowest winner in
+                // the batch is the one reported. Compare against the target
+                // on the raw bytes; only the winning digest becomes hex
+                for (size_t lane = 0; lane < count; lane++) {
+                    if (!hasLeadingZeroNibbles(digests[lane], difficulty)) {
+                        continue;
+                    }
+
+                    long long candidate = first + static_cast<long long>(lane);
+                    std::lock_guard<std::mutex> lock(resultMutex);
+                    if (candidate < bestNonce.load()) {
+                        bestNonce.store(candidate);
+                        bestHash = "0x" + digestToHex(digests[lane]);
+                    }
+                    return;
+                }
+            }
+        }
+    };
+
+    if (threadCount == 1) {
+        worker();
+    } else {
+        std::vector<std::thread> workers;
+        workers.reserve(threadCount);
+        for (unsigned int i = 0; i < threadCount; i++) {
+            workers.emplace_back(worker);
+        }
+        for (auto& t : workers) {
+            t.join();
+        }
+    }
+
+    if (bestNonce.load() == LLONG_MAX) {
+        throw std::runtime_error("ERROR: Nonce space exhausted without finding a valid hash");
+    }
+
+    hashOut = bestHash;
+    return static_cast<int>(bestNonce.load());
+}
@@ -0,0 +1,30 @@
+#ifndef MINER_H
+#define MINER_H
+
+#include <string>
+#include "Block.h"
+
+// Parallel proof-of-work search for Block::mineBlock.
+// Worker threads claim fixed-size nonce ranges from a shared counter, so a
+// fast thread simply steals more ranges than a slow one. The lowest winning
+// nonce is always the one returned, which keeps the result identical to the
+// old single-threaded loop.
+class Miner {
+public:
+    // threadCount of 0 uses every available hardware thread
+    explicit Miner(unsigned int threadCount = 0);
+
+    // Search the nonces after block.nonce; returns the winning nonce and
+    // stores its "0x" prefixed hash in hashOut
+    int findNonce(const Block& block, std::string& hashOut) const;
+
+    unsigned int getThreadCount() const { return threadCount; }
+
+    // Number of nonces a worker claims at a time
+    static const int RANGE_SIZE;
+
+private:
+    unsigned int threadCount;
+};
+
+#endif // MINER_H
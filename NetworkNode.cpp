@@ -1,51 +1,95 @@
 #include "NetworkNode.h"
-#include <boost/algorithm/string.hpp>
+#include <algorithm>
 #include <iostream>
-#include <sstream>
 #include <random>
 #include <stdexcept>
-#include <cmath>  
 
-// NetworkMessage implementation
-std::string NetworkMessage::serialize() const {
-    std::stringstream ss;
-    ss << static_cast<int>(type) << "|" << sender << "|" << data;
-    return ss.str();
+namespace {
+
+// How long a peer has to answer a GET_DATA before another may be asked
+const std::chrono::seconds INVENTORY_REQUEST_TIMEOUT(30);
+
+// Compact blocks kept waiting for their missing transactions at once
+const size_t MAX_PARTIAL_BLOCKS = 16;
+
+// Largest payload a peer may send for a message type after the handshake
+uint32_t maxPayloadFor(MessageType type) {
+    switch (type) {
+        case MessageType::BLOCKS:
+        case MessageType::CHAIN_RESPONSE:
+            return MAX_FRAME_PAYLOAD;
+        case MessageType::BLOCK:
+        case MessageType::CMPCT_BLOCK:
+        case MessageType::BLOCK_TXN:
+            return MAX_BLOCK_PAYLOAD;
+        case MessageType::HEADERS:
+        case MessageType::GET_BLOCK_TXN:
+            return MAX_HEADERS_PAYLOAD;
+        default:
+            return MAX_CONTROL_PAYLOAD;
+    }
 }
 
-NetworkMessage NetworkMessage::deserialize(const std::string& serialized) {
-    std::vector<std::string> parts;
-    boost::split(parts, serialized, boost::is_any_of("|"));
+}
+
+// NetworkMessage implementation
+std::string NetworkMessage::serialize(uint8_t protocolVersion) const {
+    BinaryWriter writer;
+    writer.writeString(sender);
+    std::string payload = writer.release();
+    payload += data;
     
-    if (parts.size() < 3) {
-        throw std::runtime_error("Invalid message format");
+    FrameHeader header;
+    header.version = protocolVersion;
+    header.type = static_cast<uint8_t>(type);
+    header.length = static_cast<uint32_t>(payload.size());
+    header.checksum = payloadChecksum(payload.data(), payload.size());
+    return encodeFrameHeader(header) + payload;
+}
+
+NetworkMessage NetworkMessage::deserialize(const FrameHeader& header, const std::string& payload) {
+    BinaryReader reader(payload);
+    std::string sender = reader.readString();
+    size_t bodyStart = payload.size() - reader.remaining();
+    return NetworkMessage(static_cast<MessageType>(header.type), sender, payload.substr(bodyStart));
+}
+
+// KnownInventory implementation
+bool KnownInventory::contains(const std::string& hash) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return digests.count(std::hash<std::string>()(hash)) > 0;
+}
+
+bool KnownInventory::insert(const std::string& hash) {
+    size_t digest = std::hash<std::string>()(hash);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!digests.insert(digest).second) {
+        return false;
     }
-    
-    MessageType type = static_cast<MessageType>(std::stoi(parts[0]));
-    std::string sender = parts[1];
-    
-    // Combine the rest of the parts as data (in case data contains the delimiter)
-    std::string data;
-    for (size_t i = 2; i < parts.size(); ++i) {
-        if (i > 2) data += "|";
-        data += parts[i];
+    order.push_back(digest);
+    if (order.size() > capacity) {
+        digests.erase(order.front());
+        order.pop_front();
     }
-    
-    return NetworkMessage(type, sender, data);
+    return true;
 }
 
 // Connection implementation
 Connection::Connection(boost::asio::io_context& io_context, NetworkManager* manager)
-    : socket_(io_context), manager_(manager) {
+    : socket_(io_context), manager_(manager), protocol_version_(MIN_PROTOCOL_VERSION),
+      handshake_complete_(false) {
 }
 
 void Connection::start() {
+    read_header();
+}
+
+void Connection::read_header() {
     boost::asio::async_read(
         socket_,
-        boost::asio::buffer(buffer_),
-        boost::asio::transfer_at_least(1),
+        boost::asio::buffer(header_buffer_),
         boost::bind(
-            &Connection::handle_read,
+            &Connection::handle_read_header,
             shared_from_this(),
             boost::asio::placeholders::error,
             boost::asio::placeholders::bytes_transferred
@@ -54,10 +98,21 @@ void Connection::start() {
 }
 
 void Connection::send(const NetworkMessage& message) {
-    std::string serialized = message.serialize() + "\n"; // Add newline as message delimiter
+    std::string frame = message.serialize(protocol_version_);
+    // The queue lives on the io thread, so hand the frame over to it
+    boost::asio::post(socket_.get_executor(), [self = shared_from_this(), frame = std::move(frame)]() mutable {
+        bool idle = self->write_queue_.empty();
+        self->write_queue_.push_back(std::move(frame));
+        if (idle) {
+            self->write_next();
+        }
+    });
+}
+
+void Connection::write_next() {
     boost::asio::async_write(
         socket_,
-        boost::asio::buffer(serialized),
+        boost::asio::buffer(write_queue_.front()),
         boost::bind(
             &Connection::handle_write,
             shared_from_this(),
@@ -66,55 +121,98 @@ void Connection::send(const NetworkMessage& message) {
     );
 }
 
-void Connection::handle_read(const boost::system::error_code& error, size_t bytes_transferred) {
-    if (!error) {
-        message_buffer_.append(buffer_.data(), bytes_transferred);
-        
-        // Check if we have a complete message (terminated by newline)
-        size_t pos = message_buffer_.find('\n');
-        while (pos != std::string::npos) {
-            std::string message_str = message_buffer_.substr(0, pos);
-            message_buffer_.erase(0, pos + 1);
-            
-            try {
-                NetworkMessage message = NetworkMessage::deserialize(message_str);
-                manager_->handleMessage(shared_from_this(), message);
-            } catch (const std::exception& e) {
-                std::cerr << "Error parsing message: " << e.what() << std::endl;
-            }
-            
-            pos = message_buffer_.find('\n');
-        }
-        
-        // Continue reading
-        boost::asio::async_read(
-            socket_,
-            boost::asio::buffer(buffer_),
-            boost::asio::transfer_at_least(1),
-            boost::bind(
-                &Connection::handle_read,
-                shared_from_this(),
-                boost::asio::placeholders::error,
-                boost::asio::placeholders::bytes_transferred
-            )
-        );
-    } else {
+void Connection::close() {
+    boost::system::error_code ec;
+    socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+    socket_.close(ec);
+}
+
+void Connection::handle_read_header(const boost::system::error_code& error, size_t bytes_transferred) {
+    if (error) {
         // Connection closed or error occurred
-        if (error != boost::asio::error::eof) {
+        if (error != boost::asio::error::eof && error != boost::asio::error::operation_aborted) {
             std::cerr << "Error: " << error.message() << std::endl;
         }
+        return;
     }
+    
+    try {
+        frame_ = decodeFrameHeader(header_buffer_.data());
+    } catch (const std::exception& e) {
+        // Out of sync or not speaking this protocol; nothing after this can be trusted
+        std::cerr << "Dropping connection: " << e.what() << std::endl;
+        close();
+        return;
+    }
+    if (frame_.version < MIN_PROTOCOL_VERSION || frame_.version > PROTOCOL_VERSION) {
+        std::cerr << "Dropping connection: unsupported protocol version " << static_cast<int>(frame_.version) << std::endl;
+        close();
+        return;
+    }
+    uint32_t limit = handshake_complete_ ? maxPayloadFor(static_cast<MessageType>(frame_.type)) : MAX_HANDSHAKE_PAYLOAD;
+    if (frame_.length > limit) {
+        std::cerr << "Dropping connection: " << frame_.length << " byte payload for message type "
+                  << static_cast<int>(frame_.type) << ", limit is " << limit << std::endl;
+        close();
+        return;
+    }
+    
+    payload_.resize(frame_.length);
+    if (payload_.empty()) {
+        handle_read_payload(error, 0);
+        return;
+    }
+    boost::asio::async_read(
+        socket_,
+        boost::asio::buffer(&payload_[0], payload_.size()),
+        boost::bind(
+            &Connection::handle_read_payload,
+            shared_from_this(),
+            boost::asio::placeholders::error,
+            boost::asio::placeholders::bytes_transferred
+        )
+    );
+}
+
+void Connection::handle_read_payload(const boost::system::error_code& error, size_t bytes_transferred) {
+    if (error) {
+        if (error != boost::asio::error::eof && error != boost::asio::error::operation_aborted) {
+            std::cerr << "Error: " << error.message() << std::endl;
+        }
+        return;
+    }
+    
+    if (payloadChecksum(payload_.data(), payload_.size()) != frame_.checksum) {
+        std::cerr << "Dropping message with a bad checksum" << std::endl;
+    } else {
+        try {
+            NetworkMessage message = NetworkMessage::deserialize(frame_, payload_);
+            manager_->handleMessage(shared_from_this(), message);
+        } catch (const std::exception& e) {
+            std::cerr << "Error parsing message: " << e.what() << std::endl;
+        }
+    }
+    
+    // Continue reading
+    read_header();
 }
 
 void Connection::handle_write(const boost::system::error_code& error) {
     if (error) {
         std::cerr << "Error writing to socket: " << error.message() << std::endl;
+        write_queue_.clear();
+        return;
+    }
+    write_queue_.pop_front();
+    if (!write_queue_.empty()) {
+        write_next();
     }
 }
 
 // NetworkManager implementation
 NetworkManager::NetworkManager(Blockchain& blockchain, Wallet& wallet, const std::string& host, int port, NodeType type)
     : blockchain(blockchain),
+      sync(blockchain),
       wallet(wallet),
       nodeType(type),
       host(host),
@@ -248,10 +346,7 @@ void NetworkManager::handleAccept(Connection::pointer new_connection, const boos
         }
         
         // Send a handshake message
-        std::string type_str = (nodeType==NodeType::FULL_NODE?"FULL_NODE":"WALLET_NODE");
-        std::string payload  = type_str + "|" + std::to_string(port);
-        NetworkMessage hs(MessageType::HANDSHAKE, nodeId, payload);
-        new_connection->send(hs);
+        new_connection->send(makeHandshake());
     }
     
     // Continue accepting new connections
@@ -294,10 +389,7 @@ bool NetworkManager::connectToPeer(const std::string& address, int peer_port) {
         }
         
         // Send a handshake message
-        std::string type_str = (nodeType==NodeType::FULL_NODE?"FULL_NODE":"WALLET_NODE");
-        std::string payload  = type_str + "|" + std::to_string(port);
-        NetworkMessage hs(MessageType::HANDSHAKE, nodeId, payload);
-        connection->send(hs);
+        connection->send(makeHandshake());
         std::cout << "Sent handshake message to peer" << std::endl;
         
         return true;
@@ -307,35 +399,31 @@ bool NetworkManager::connectToPeer(const std::string& address, int peer_port) {
     }
 }
 
+NetworkMessage NetworkManager::makeHandshake() const {
+    HandshakePayload handshake;
+    handshake.minVersion = MIN_PROTOCOL_VERSION;
+    handshake.maxVersion = PROTOCOL_VERSION;
+    handshake.nodeType = nodeType;
+    handshake.listenPort = port;
+    return NetworkMessage(MessageType::HANDSHAKE, nodeId, encodeHandshake(handshake));
+}
+
 void NetworkManager::broadcastTransaction(const Transaction& transaction) {
     // Check if there are any connections
-    std::lock_guard<std::mutex> lock(connections_mutex);
-    if (connections.empty()) {
-        std::cout << "No peers connected. Transaction will only be stored locally." << std::endl;
-        return;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        if (connections.empty()) {
+            std::cout << "No peers connected. Transaction will only be stored locally." << std::endl;
+            return;
+        }
     }
     
-    // Convert the transaction to a serialized string
-    std::stringstream ss;
-    ss << transaction.sender << "|"
-       << transaction.senderPublicKey << "|"
-       << transaction.receiver << "|"
-       << transaction.amount << "|"
-       << transaction.timestamp << "|"
-       << transaction.hash << "|"
-       << transaction.signature;
-    
-    std::string tx_data = ss.str();
-    
-    // Create a network message
-    NetworkMessage msg(MessageType::TRANSACTION, nodeId, tx_data);
-    
-    // Broadcast to all connections
-    for (auto& connection : connections) {
-        connection->send(msg);
-    }
+    // Peers fetch it with GET_DATA if they don't have it
+    size_t reached = relayInventory(InventoryItem{InventoryType::TRANSACTION, transaction.hash}, [&] {
+        return NetworkMessage(MessageType::TRANSACTION, nodeId, encodeTransaction(transaction));
+    }, nullptr);
     
-    std::cout << "Broadcasted transaction to " << connections.size() << " peers." << std::endl;
+    std::cout << "Announced transaction to " << reached << " peers." << std::endl;
 }
 
 void NetworkManager::broadcastBlock(const Block& block) {
@@ -346,44 +434,87 @@ void NetworkManager::broadcastBlock(const Block& block) {
     }
     
     // Check if there are any connections
-    std::lock_guard<std::mutex> lock(connections_mutex);
-    if (connections.empty()) {
-        std::cout << "No peers connected. Block will only be stored locally." << std::endl;
-        return;
-    }
-    
-    // Serialize the block
-    std::stringstream ss;
-    ss << block.blockNumber << "|"
-       << block.timestamp << "|"
-       << block.previousHash << "|"
-       << block.hash << "|"
-       << block.nonce << "|"
-       << block.difficulty << "|"
-       << block.transactions.size();
-    
-    // Add each transaction to the serialized data
-    for (const auto& tx : block.transactions) {
-        ss << "|" << tx.sender << "|"
-           << tx.senderPublicKey << "|"
-           << tx.receiver << "|"
-           << tx.amount << "|"
-           << tx.timestamp << "|"
-           << tx.hash << "|"
-           << tx.signature;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        if (connections.empty()) {
+            std::cout << "No peers connected. Block will only be stored locally." << std::endl;
+            return;
+        }
     }
     
-    std::string block_data = ss.str();
+    size_t reached = relayBlock(block, nullptr);
     
-    // Create a network message
-    NetworkMessage msg(MessageType::BLOCK, nodeId, block_data);
+    std::cout << "Announced block #" << block.blockNumber << " to " << reached << " peers." << std::endl;
+}
+
+size_t NetworkManager::relayInventory(const InventoryItem& item, const std::function<NetworkMessage()>& fullMessage,
+                                      Connection::pointer except,
+                                      const std::function<NetworkMessage()>& compactMessage) {
+    NetworkMessage announcement(MessageType::INV, nodeId, encodeInventory({item}));
+    std::unique_ptr<NetworkMessage> full;
+    std::unique_ptr<NetworkMessage> compact;
+    size_t reached = 0;
     
-    // Broadcast to all connections
+    std::lock_guard<std::mutex> lock(connections_mutex);
     for (auto& connection : connections) {
-        connection->send(msg);
+        if (connection == except || !connection->knownInventory().insert(item.hash)) {
+            continue;
+        }
+        if (compactMessage && connection->protocolVersion() >= COMPACT_BLOCKS_VERSION) {
+            if (!compact) {
+                compact = std::make_unique<NetworkMessage>(compactMessage());
+            }
+            connection->send(*compact);
+        } else if (connection->protocolVersion() >= INVENTORY_VERSION) {
+            connection->send(announcement);
+        } else {
+            if (!full) {
+                full = std::make_unique<NetworkMessage>(fullMessage());
+            }
+            connection->send(*full);
+        }
+        reached++;
+    }
+    return reached;
+}
+
+size_t NetworkManager::relayBlock(const Block& block, Connection::pointer except) {
+    // Pushed compact rather than announced: the peer most likely wants a
+    // new block, and skipping the GET_DATA round trip gets it there sooner
+    return relayInventory(InventoryItem{InventoryType::BLOCK, block.hash}, [&] {
+        return NetworkMessage(MessageType::BLOCK, nodeId, encodeBlock(block));
+    }, except, [&] {
+        std::random_device rd;
+        uint64_t salt = (static_cast<uint64_t>(rd()) << 32) | rd();
+        return NetworkMessage(MessageType::CMPCT_BLOCK, nodeId, encodeCompactBlock(makeCompactBlock(block, salt)));
+    });
+}
+
+void NetworkManager::requestFullBlock(Connection::pointer connection, const std::string& hash) {
+    if (markRequested(hash)) {
+        NetworkMessage request(MessageType::GET_DATA, nodeId,
+                               encodeInventory({InventoryItem{InventoryType::BLOCK, hash}}));
+        connection->send(request);
     }
-    
-    std::cout << "Broadcasted block #" << block.blockNumber << " to " << connections.size() << " peers." << std::endl;
+}
+
+bool NetworkManager::markRequested(const std::string& hash) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(inventory_mutex);
+    // Forget requests nobody answered so the items can be asked of others
+    for (auto it = requestedInventory.begin(); it != requestedInventory.end();) {
+        if (now - it->second >= INVENTORY_REQUEST_TIMEOUT) {
+            it = requestedInventory.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return requestedInventory.emplace(hash, now).second;
+}
+
+void NetworkManager::clearRequested(const std::string& hash) {
+    std::lock_guard<std::mutex> lock(inventory_mutex);
+    requestedInventory.erase(hash);
 }
 
 void NetworkManager::requestBlockchain() {
@@ -394,31 +525,110 @@ void NetworkManager::requestBlockchain() {
         return;
     }
     
-    // Create a request message
-    NetworkMessage msg(MessageType::CHAIN_REQUEST, nodeId, "");
+    sync.requeueStalled();
+    
+    // Create the request messages
+    NetworkMessage headersRequest(MessageType::GET_HEADERS, nodeId, encodeLocator(sync.locator()));
+    NetworkMessage chainRequest(MessageType::CHAIN_REQUEST, nodeId, "");
     
     // Send to all connections
     for (auto& connection : connections) {
-        connection->send(msg);
+        if (connection->protocolVersion() >= HEADERS_FIRST_VERSION) {
+            connection->send(headersRequest);
+        } else {
+            connection->send(chainRequest);
+        }
     }
     
     std::cout << "Requested blockchain from " << connections.size() << " peers." << std::endl;
 }
 
+void NetworkManager::requestHeaders(Connection::pointer connection) {
+    NetworkMessage request(MessageType::GET_HEADERS, nodeId, encodeLocator(sync.locator()));
+    connection->send(request);
+}
+
+void NetworkManager::scheduleBlockDownloads() {
+    sync.requeueStalled();
+    
+    std::lock_guard<std::mutex> lock(connections_mutex);
+    for (auto& connection : connections) {
+        if (connection->protocolVersion() < HEADERS_FIRST_VERSION || connection->peerId().empty()) {
+            continue;
+        }
+        BlockRange range;
+        while (sync.nextRange(connection->peerId(), range)) {
+            NetworkMessage request(MessageType::GET_BLOCKS, nodeId, encodeBlockRange(range));
+            connection->send(request);
+        }
+    }
+}
+
+void NetworkManager::acceptBlock(Connection::pointer connection, const Block& block) {
+    // 1) De-duplicate: skip if we already have this hash, on any branch
+    if (blockchain.isKnownBlock(block.hash)) {
+        // already added
+        return;
+    }
+
+    // 2) Add to our chain
+    try{
+        blockchain.addExistingBlock(block);  // or a new addExistingBlock method
+    }
+    catch(const std::exception& e){
+        std::cerr << "Error adding block to chain: " << e.what() << std::endl;
+        // We miss its parent; fetch just the blocks leading up to it from this peer
+        if (!blockchain.isKnownBlock(block.previousHash) &&
+            connection->protocolVersion() >= HEADERS_FIRST_VERSION) {
+            requestHeaders(connection);
+            return;
+        }
+        failedBlockCount++;
+        if(failedBlockCount >= 5){
+            try{
+                requestBlockchain();
+                failedBlockCount = 0;
+            }
+            catch(const std::exception& e){
+                std::cerr << "Error requesting blockchain: " << e.what() << std::endl;
+            }
+        }
+    }
+
+    // 3) Announce it to the other peers, if it made it into our tree
+    if (!blockchain.isKnownBlock(block.hash)) {
+        return;
+    }
+    relayBlock(block, connection);
+
+    std::cout << "Added and relayed block #"
+              << block.blockNumber << " with "
+              << block.transactions.size() << " transactions" << std::endl;
+}
+
 void NetworkManager::handleMessage(Connection::pointer connection, const NetworkMessage& message) {
     std::cout << "Received message of type " << static_cast<int>(message.type) << " from " << message.sender << std::endl;
     
     switch (message.type) {
         case MessageType::HANDSHAKE: {
+            HandshakePayload handshake = decodeHandshake(message.data);
+            
+            // Settle on the highest version both sides speak
+            uint8_t agreed = std::min(PROTOCOL_VERSION, handshake.maxVersion);
+            if (agreed < std::max(MIN_PROTOCOL_VERSION, handshake.minVersion)) {
+                std::cerr << "Peer " << message.sender << " speaks protocol versions "
+                          << static_cast<int>(handshake.minVersion) << "-" << static_cast<int>(handshake.maxVersion)
+                          << ", we speak " << static_cast<int>(MIN_PROTOCOL_VERSION) << "-"
+                          << static_cast<int>(PROTOCOL_VERSION) << ". Disconnecting." << std::endl;
+                connection->close();
+                break;
+            }
+            connection->setProtocolVersion(agreed);
+            connection->setPeerId(message.sender);
+            
             // Add the peer to our peer list
-            // split the payload
-            std::vector<std::string> parts;
-            boost::split(parts, message.data, boost::is_any_of("|"));
-
-            // parts[0] == "FULL_NODE" or "WALLET_NODE"
-            // parts[1] == listening port
-            NodeType peer_type = (parts[0] == "FULL_NODE") ? NodeType::FULL_NODE : NodeType::WALLET_NODE;
-            int peer_listen_port = std::stoi(parts[1]);
+            NodeType peer_type = handshake.nodeType;
+            int peer_listen_port = handshake.listenPort;
 
             std::string peer_address = connection->socket().remote_endpoint().address().to_string();
             Peer new_peer(peer_address, peer_listen_port, peer_type, message.sender);
@@ -440,169 +650,68 @@ void NetworkManager::handleMessage(Connection::pointer connection, const Network
                       << (peer_already_known ? " (already known)" : " (new peer)") << std::endl;
             
             // Send our peer list to the new peer
-            std::stringstream ss;
-            
+            std::vector<PeerInfo> peerInfos;
             {
                 std::lock_guard<std::mutex> lock(peers_mutex);
-                ss << peers.size();
-                
                 for (const auto& peer : peers) {
-                    ss << "|" << peer.address << "|" << peer.port << "|"
-                       << (peer.type == NodeType::FULL_NODE ? "FULL_NODE" : "WALLET_NODE") << "|"
-                       << peer.id;
+                    peerInfos.push_back(PeerInfo{peer.address, peer.port, peer.type, peer.id});
                 }
             }
             
-            NetworkMessage peer_list_msg(MessageType::PEER_LIST, nodeId, ss.str());
+            NetworkMessage peer_list_msg(MessageType::PEER_LIST, nodeId, encodePeerList(peerInfos));
             connection->send(peer_list_msg);
-            std::cout << "Sent peer list to " << message.sender << " with " << peers.size() << " peers" << std::endl;
+            std::cout << "Sent peer list to " << message.sender << " with " << peerInfos.size() << " peers" << std::endl;
+            
+            // Catch up with anything the peer has beyond our tip
+            if (agreed >= HEADERS_FIRST_VERSION) {
+                requestHeaders(connection);
+            }
             break;
         }
         case MessageType::TRANSACTION: {
-            // parse the transaction data
-            std::vector<std::string> parts;
-            boost::split(parts, message.data, boost::is_any_of("|"));
-            if (parts.size() != 7) {
-                std::cerr << "Invalid transaction data format" << std::endl;
+            Transaction tx = decodeTransaction(message.data);
+            connection->knownInventory().insert(tx.hash);
+            clearRequested(tx.hash);
+        
+            // 1) Deduplicate: if we've seen this hash before, do nothing.
+            //    Checked first since it's a hash lookup and validation isn't
+            if (blockchain.hasTransaction(tx.hash)) {
+                // already processed—drop it
                 break;
             }
         
-            // Construct the Transaction object
-            // parts[0] = sender, parts[1] = senderPublicKey, parts[2] = receiver, parts[3] = amount
-            // parts[4] = timestamp, parts[5] = hash, parts[6] = signature
-            Transaction tx(
-                parts[0],                    // sender address
-                parts[1],                    // sender public key
-                parts[2],                    // receiver
-                std::stod(parts[3]),         // amount
-                parts[5],                    // hash
-                parts[6],                    // signature
-                std::stoul(parts[4])         // timestamp
-            );
-        
-            // 1) Validate the transaction
+            // 2) Validate the transaction. Only the current version hashes
+            //    the exact amount, so older ones could be altered in transit
+            if (tx.version != Transaction::CURRENT_VERSION) {
+                std::cerr << "Received transaction with version " << tx.version << " from " << message.sender << std::endl;
+                break;
+            }
             if (!tx.isValid()) {
                 std::cerr << "Received invalid transaction from " << message.sender << std::endl;
                 break;
             }
         
-            // 2) Deduplicate: if we've seen this hash before, do nothing
-            {
-                const auto& pool = blockchain.getMempool();
-                bool seen = std::any_of(pool.begin(), pool.end(),
-                    [&](const Transaction& old){ return old.hash == tx.hash; });
-                if (seen) {
-                    // already processed—drop it
-                    break;
-                }
-            }
-        
-            // 3) Add it to our mempool
+            // 3) Add it to our mempool; don't pass on what it turned away
             blockchain.addTransaction(tx);
-        
-            // 4) Relay it on to all other peers (except the one who sent it)
-            {
-                std::lock_guard<std::mutex> lock(connections_mutex);
-                for (auto& conn : connections) {
-                    if (conn != connection) {
-                        conn->send(message);
-                    }
-                }
+            if (!blockchain.hasTransaction(tx.hash)) {
+                break;
             }
         
+            // 4) Announce it to the other peers that don't have it yet
+            relayInventory(InventoryItem{InventoryType::TRANSACTION, tx.hash},
+                           [&] { return message; }, connection);
+        
             std::cout << "Added and relayed transaction from "
                       << tx.sender << " to " << tx.receiver
-                      << " for " << tx.amount << std::endl;
+                      << " for " << formatAmount(tx.amount) << std::endl;
             break;
         }
         case MessageType::BLOCK: {
-            // parse the block data
-            std::vector<std::string> parts;
-            boost::split(parts, message.data, boost::is_any_of("|"));
-            if (parts.size() < 7) {
-                std::cerr << "Invalid block data format" << std::endl;
-                break;
-            }
-        
-            int blockNumber = std::stoi(parts[0]);
-            time_t timestamp = static_cast<time_t>(std::stoul(parts[1]));
-            std::string previousHash = parts[2];
-            std::string hash         = parts[3];
-            int nonce      = std::stoi(parts[4]);
-            int difficulty = std::stoi(parts[5]);
-            int txCount    = std::stoi(parts[6]);
-        
-            // Check for enough data for all transactions
-            size_t required_size = 7 + static_cast<size_t>(txCount) * 7;
-            if (parts.size() < required_size) {
-                std::cerr << "Invalid block data: missing transaction data" << std::endl;
-                break;
-            }
-        
-            // 1) De‑duplicate: skip if we already have this hash
-            {
-                const auto& chain = blockchain.getChain();
-                auto it = std::find_if(chain.begin(), chain.end(),
-                    [&](const Block& b){ return b.hash == hash; });
-                if (it != chain.end()) {
-                    // already added
-                    break;
-                }
-            }
+            Block block = decodeBlock(message.data);
+            connection->knownInventory().insert(block.hash);
+            clearRequested(block.hash);
         
-            // 2) Reconstruct the transactions
-            std::vector<Transaction> transactions;
-            for (int i = 0; i < txCount; ++i) {
-                int idx = 7 + i * 7;
-                Transaction tx(
-                    parts[idx],                   // sender address
-                    parts[idx+1],                 // sender public key
-                    parts[idx+2],                 // receiver
-                    std::stod(parts[idx+3]),      // amount
-                    parts[idx+5],                 // hash
-                    parts[idx+6],                 // signature
-                    std::stoul(parts[idx+4])      // timestamp
-                );
-                transactions.push_back(tx);
-            }
-        
-            // 3) Create a block stub and set its fields
-            Block block(blockNumber, transactions, previousHash, difficulty);
-            block.timestamp = timestamp;
-            block.nonce     = nonce;
-            block.hash      = hash;
-        
-            // 4) Add to our chain
-            try{
-                blockchain.addExistingBlock(block);  // or a new addExistingBlock method
-            }
-            catch(const std::exception& e){
-                std::cerr << "Error adding block to chain: " << e.what() << std::endl;
-                failedBlockCount++;
-                if(failedBlockCount >= 5){
-                    try{
-                        requestBlockchain();
-                        failedBlockCount = 0;
-                    }
-                    catch(const std::exception& e){
-                        std::cerr << "Error requesting blockchain: " << e.what() << std::endl;
-                    }
-                }
-            }
-        
-            // 5) Relay to other peers, except the sender
-            {
-                std::lock_guard<std::mutex> lock(connections_mutex);
-                for (auto& conn : connections) {
-                    if (conn != connection) {
-                        conn->send(message);
-                    }
-                }
-            }
-        
-            std::cout << "Added and relayed block #"
-                      << blockNumber << " with "
-                      << txCount << " transactions" << std::endl;
+            acceptBlock(connection, block);
             break;
         } 
         case MessageType::CHAIN_REQUEST: {
@@ -613,46 +722,28 @@ void NetworkManager::handleMessage(Connection::pointer connection, const Network
             }
             
             // Serialize the blockchain
-            std::stringstream ss;
-            const std::vector<Block>& chain = blockchain.getChain();
-            ss << chain.size();
-            for (const auto& block : chain) {
-                ss << "|" << block.blockNumber << "|"
-                   << block.timestamp << "|"
-                   << block.previousHash << "|"
-                   << block.hash << "|"
-                   << block.nonce << "|"
-                   << block.difficulty << "|"
-                   << block.transactions.size();
-                
-                for (const auto& tx : block.transactions) {
-                    ss << "|" << tx.sender << "|"
-                       << tx.senderPublicKey << "|"
-                       << tx.receiver << "|"
-                       << tx.amount << "|"
-                       << tx.timestamp << "|"
-                       << tx.hash << "|"
-                       << tx.signature;
-                }
-            }
+            BinaryWriter writer;
+            size_t chainSize = blockchain.getChainSize();
+            writer.writeVarint(chainSize);
+            blockchain.getChainStore().forEach(0, [&](const Block& block) {
+                encodeBlock(writer, block);
+                return true;
+            });
             
-            NetworkMessage response(MessageType::CHAIN_RESPONSE, nodeId, ss.str());
+            NetworkMessage response(MessageType::CHAIN_RESPONSE, nodeId, writer.release());
             connection->send(response);
             
-            std::cout << "Sent blockchain (" << chain.size() << " blocks) to " << message.sender << std::endl;
+            std::cout << "Sent blockchain (" << chainSize << " blocks) to " << message.sender << std::endl;
             break;
         }
         case MessageType::CHAIN_RESPONSE: {
             // Parse the blockchain data
-            std::vector<std::string> parts;
-            boost::split(parts, message.data, boost::is_any_of("|"));
-            
-            if (parts.size() < 1) {
-                std::cerr << "Invalid blockchain data format" << std::endl;
+            BinaryReader reader(message.data);
+            uint64_t blockCount = reader.readVarint();
+            if (blockCount > reader.remaining()) {
+                std::cerr << "Invalid blockchain data: bad block count" << std::endl;
                 break;
             }
-            
-            int blockCount = std::stoi(parts[0]);
             std::cout << "Received blockchain with " << blockCount << " blocks from " << message.sender << std::endl;
             
             // Implement the longest chain algorithm by:
@@ -662,67 +753,21 @@ void NetworkManager::handleMessage(Connection::pointer connection, const Network
             // 4. Replace our chain if the received one is valid and longer
             
             std::vector<Block> receivedChain;
-            int currentPos = 1;
+            receivedChain.reserve(blockCount);
             bool chainValid = true;
             
             try {
-            for (int i = 0; i < blockCount; i++) {
-                if (currentPos + 6 >= parts.size()) {
-                    std::cerr << "Invalid blockchain data: missing block data" << std::endl;
-                        chainValid = false;
-                    break;
-                }
-                
-                int blockNumber = std::stoi(parts[currentPos++]);
-                time_t timestamp = std::stoul(parts[currentPos++]);
-                std::string previousHash = parts[currentPos++];
-                std::string hash = parts[currentPos++];
-                int nonce = std::stoi(parts[currentPos++]);
-                int difficulty = std::stoi(parts[currentPos++]);
-                int txCount = std::stoi(parts[currentPos++]);
+            for (uint64_t i = 0; i < blockCount; i++) {
+                Block block = decodeBlock(reader);
+                int blockNumber = block.blockNumber;
+                const std::string& hash = block.hash;
                     
                     // Validate block number
-                    if (i != blockNumber) {
+                    if (i != static_cast<uint64_t>(blockNumber)) {
                         std::cerr << "Block number mismatch: expected " << i << ", got " << blockNumber << std::endl;
                         chainValid = false;
                         break;
                     }
-                
-                std::vector<Transaction> transactions;
-                
-                for (int j = 0; j < txCount; j++) {
-                    if (currentPos + 6 >= parts.size()) {
-                        std::cerr << "Invalid blockchain data: missing transaction data" << std::endl;
-                            chainValid = false;
-                        break;
-                    }
-                    
-                    std::string sender = parts[currentPos++];
-                    std::string senderPublicKey = parts[currentPos++];
-                    std::string receiver = parts[currentPos++];
-                    double amount = std::stod(parts[currentPos++]);
-                    unsigned long txTimestamp = std::stoul(parts[currentPos++]);
-                    std::string txHash = parts[currentPos++];
-                    std::string signature = parts[currentPos++];
-                    
-                    Transaction tx(sender, senderPublicKey, receiver, amount, txHash, signature, txTimestamp);
-                        
-                        // Validate transaction
-                        if (!tx.isValid()) {
-                            std::cerr << "Invalid transaction in block " << blockNumber << std::endl;
-                            chainValid = false;
-                            break;
-                        }
-                        
-                    transactions.push_back(tx);
-                }
-                    
-                    if (!chainValid) break;
-                
-                Block block(blockNumber, transactions, previousHash, difficulty);
-                block.timestamp = timestamp;
-                block.nonce = nonce;
-                block.hash = hash;
                     
                     // Validate block hash
                     std::string calculatedHash = block.calculateHash();
@@ -755,78 +800,68 @@ void NetworkManager::handleMessage(Connection::pointer connection, const Network
                         }
                     }
                 
-                receivedChain.push_back(block);
+                receivedChain.push_back(std::move(block));
             }
             
+                // Verify every transaction of the received chain in one batch
+                // on the thread pool rather than one by one on this thread
+                if (chainValid) {
+                    std::vector<const Transaction*> toVerify;
+                    std::vector<int> owningBlock;
+                    for (const auto& block : receivedChain) {
+                        for (const auto& tx : block.transactions) {
+                            toVerify.push_back(&tx);
+                            owningBlock.push_back(block.blockNumber);
+                        }
+                    }
+                    
+                    size_t invalid = Transaction::findInvalid(toVerify);
+                    if (invalid < toVerify.size()) {
+                        std::cerr << "Invalid transaction in block " << owningBlock[invalid] << std::endl;
+                        chainValid = false;
+                    }
+                }
+            
                 // Implement the longest chain algorithm
                 if (chainValid && !receivedChain.empty()) {
                     // Check if the genesis block matches our genesis block
-                    const auto& ourChain = blockchain.getChain();
+                    size_t ourChainSize = blockchain.getChainSize();
                     
-                    if (ourChain.empty()) {
+                    if (ourChainSize == 0) {
                         std::cerr << "Our chain is empty. Cannot validate against genesis block." << std::endl;
                         break;
                     }
                     
-                    if (receivedChain[0].hash != ourChain[0].hash) {
+                    if (receivedChain[0].hash != blockchain.getBlockHeader(0).hash) {
                         std::cerr << "Genesis block mismatch. Different blockchain network." << std::endl;
                         break;
                     }
                     
-                    // Calculate total difficulty (work) for both chains
                     // In PoW blockchains, the chain with the most accumulated work is considered valid
-                    // Total work is approximated as sum of 2^difficulty for each block
-                    double ourTotalWork = 0;
+                    double ourTotalWork = blockchain.getChainWork();
                     double receivedTotalWork = 0;
-                    
-                    for (const auto& block : ourChain) {
-                        // 2^difficulty approximates the amount of work needed
-                        ourTotalWork += std::pow(2.0, block.difficulty);
-                    }
-                    
-                for (const auto& block : receivedChain) {
-                        receivedTotalWork += std::pow(2.0, block.difficulty);
+                    for (const auto& block : receivedChain) {
+                        receivedTotalWork += blockWork(block.difficulty);
                     }
                     
-                    std::cout << "Our chain work: " << ourTotalWork << ", length: " << ourChain.size() << std::endl;
+                    std::cout << "Our chain work: " << ourTotalWork << ", length: " << ourChainSize << std::endl;
                     std::cout << "Received chain work: " << receivedTotalWork << ", length: " << receivedChain.size() << std::endl;
                     
-                    // Compare chain work - implement the correct chain selection rule
                     if (receivedTotalWork > ourTotalWork) {
                         std::cout << "Received chain has more proof of work (" << receivedTotalWork 
                                   << ") than our chain (" << ourTotalWork << ")" << std::endl;
                         
-                        // Clear our chain except genesis block
-                        for (size_t i = 1; i < ourChain.size(); i++) {
-                            // For any transactions in replaced blocks, add them back to mempool
-                            // if they're not already in the new chain
-                            for (const auto& tx : ourChain[i].transactions) {
-                                bool txInNewChain = false;
-                                for (size_t j = 1; j < receivedChain.size(); j++) {
-                                    for (const auto& newTx : receivedChain[j].transactions) {
-                                        if (tx.hash == newTx.hash) {
-                                            txInNewChain = true;
-                                            break;
-                                        }
-                                    }
-                                    if (txInNewChain) break;
-                                }
-                                
-                                if (!txInNewChain) {
-                                    std::cout << "Re-adding transaction " << tx.hash << " to mempool" << std::endl;
-                                    blockchain.addTransaction(tx);
-                                }
-                            }
-                        }
-                        
-                        // Create a new blockchain with just the genesis block
-                        Blockchain newChain(receivedChain[0].difficulty);
-                        
-                        // Add each block from the received chain (skip genesis which is already added)
+                        // Blocks we already have are skipped; the rest extend our tip
+                        // or build a side branch the chain reorganizes onto once it
+                        // is heavier, so only the part after the fork is processed
+                        size_t added = 0;
                         for (size_t i = 1; i < receivedChain.size(); i++) {
+                            if (blockchain.isKnownBlock(receivedChain[i].hash)) {
+                                continue;
+                            }
                             try {
-                                std::cout << "Adding block #" << i << " to our chain" << std::endl;
                                 blockchain.addExistingBlock(receivedChain[i]);
+                                added++;
                             } catch (const std::exception& e) {
                                 std::cerr << "Error adding block #" << i << ": " << e.what() << std::endl;
                                 chainValid = false;
@@ -835,9 +870,10 @@ void NetworkManager::handleMessage(Connection::pointer connection, const Network
                         }
                         
                         if (chainValid) {
-                            std::cout << "Chain replaced successfully with chain having more proof of work" << std::endl;
+                            std::cout << "Took " << added << " new blocks from the received chain, tip is now #"
+                                      << blockchain.getChainSize() - 1 << std::endl;
                         } else {
-                            std::cerr << "Failed to replace chain - invalid blocks detected" << std::endl;
+                            std::cerr << "Failed to switch to the received chain - invalid blocks detected" << std::endl;
                         }
                     } else {
                         std::cout << "Our chain has more or equal proof of work. Keeping our chain." << std::endl;
@@ -850,32 +886,237 @@ void NetworkManager::handleMessage(Connection::pointer connection, const Network
             break;
         }
         
-        case MessageType::PEER_LIST: {
-            // Parse the peer list
-            std::vector<std::string> parts;
-            boost::split(parts, message.data, boost::is_any_of("|"));
+        case MessageType::GET_HEADERS: {
+            if (nodeType != NodeType::FULL_NODE) {
+                break;
+            }
             
-            if (parts.size() < 1) {
-                std::cerr << "Invalid peer list format" << std::endl;
+            // Everything after the newest block we share with the requester
+            size_t forkPoint = ChainSync::findForkPoint(blockchain, decodeLocator(message.data));
+            std::vector<BlockHeader> headers;
+            size_t chainSize = blockchain.getChainSize();
+            for (size_t height = forkPoint + 1;
+                 height < chainSize && headers.size() < ChainSync::MAX_HEADERS_PER_MESSAGE; height++) {
+                headers.push_back(blockchain.getBlockHeader(height));
+            }
+            
+            NetworkMessage response(MessageType::HEADERS, nodeId, encodeHeaders(headers));
+            connection->send(response);
+            std::cout << "Sent " << headers.size() << " headers after block #" << forkPoint
+                      << " to " << message.sender << std::endl;
+            break;
+        }
+        
+        case MessageType::HEADERS: {
+            std::vector<BlockHeader> headers = decodeHeaders(message.data);
+            if (!sync.addHeaders(message.sender, headers)) {
+                break;
+            }
+            
+            // A full batch means the peer has more
+            if (headers.size() == ChainSync::MAX_HEADERS_PER_MESSAGE) {
+                requestHeaders(connection);
+            }
+            scheduleBlockDownloads();
+            break;
+        }
+        
+        case MessageType::GET_BLOCKS: {
+            if (nodeType != NodeType::FULL_NODE) {
+                break;
+            }
+            
+            BlockRange range = decodeBlockRange(message.data);
+            size_t chainSize = blockchain.getChainSize();
+            uint64_t count = 0;
+            if (range.firstBlock < chainSize) {
+                count = std::min<uint64_t>({range.count, ChainSync::MAX_BLOCKS_PER_MESSAGE, chainSize - range.firstBlock});
+            }
+            
+            BinaryWriter writer;
+            writer.writeVarint(count);
+            uint64_t written = 0;
+            if (count > 0) {
+                blockchain.getChainStore().forEach(range.firstBlock, [&](const Block& block) {
+                    encodeBlock(writer, block);
+                    return ++written < count;
+                });
+            }
+            
+            NetworkMessage response(MessageType::BLOCKS, nodeId, writer.release());
+            connection->send(response);
+            break;
+        }
+        
+        case MessageType::BLOCKS: {
+            std::vector<Block> blocks = decodeBlocks(message.data);
+            size_t connected = sync.addBlocks(message.sender, blocks);
+            if (connected > 0) {
+                std::cout << "Added " << connected << " synced blocks, chain height now "
+                          << blockchain.getChainSize() - 1 << std::endl;
+            }
+            scheduleBlockDownloads();
+            break;
+        }
+        
+        case MessageType::INV: {
+            // Ask for what we don't have and nobody else is sending us yet
+            std::vector<InventoryItem> wanted;
+            for (const auto& item : decodeInventory(message.data)) {
+                connection->knownInventory().insert(item.hash);
+                bool have = item.type == InventoryType::TRANSACTION
+                    ? blockchain.hasTransaction(item.hash)
+                    : blockchain.isKnownBlock(item.hash);
+                if (!have && markRequested(item.hash)) {
+                    wanted.push_back(item);
+                }
+            }
+            
+            if (!wanted.empty()) {
+                NetworkMessage request(MessageType::GET_DATA, nodeId, encodeInventory(wanted));
+                connection->send(request);
+            }
+            break;
+        }
+        
+        case MessageType::GET_DATA: {
+            // Items we no longer have are skipped; the peer's request times
+            // out and it asks someone else
+            for (const auto& item : decodeInventory(message.data)) {
+                if (item.type == InventoryType::TRANSACTION) {
+                    const Transaction* tx = blockchain.findMempoolTransaction(item.hash);
+                    if (tx) {
+                        connection->send(NetworkMessage(MessageType::TRANSACTION, nodeId, encodeTransaction(*tx)));
+                        connection->knownInventory().insert(item.hash);
+                    }
+                } else {
+                    std::shared_ptr<const Block> block = blockchain.findBlock(item.hash);
+                    if (block) {
+                        connection->send(NetworkMessage(MessageType::BLOCK, nodeId, encodeBlock(*block)));
+                        connection->knownInventory().insert(item.hash);
+                    }
+                }
+            }
+            break;
+        }
+        
+        case MessageType::CMPCT_BLOCK: {
+            CompactBlock compact = decodeCompactBlock(message.data);
+            const std::string hash = compact.header.hash;
+            connection->knownInventory().insert(hash);
+            if (blockchain.isKnownBlock(hash) || partialBlocks.count(hash)) {
+                break;
+            }
+            // Cheap to check, and keeps headers without work from taking a
+            // slot or costing a round trip
+            if (compact.header.difficulty < blockchain.getDifficulty() ||
+                !meetsDifficulty(hash, compact.header.difficulty)) {
+                std::cerr << "Compact block #" << compact.header.blockNumber << " from " << message.sender
+                          << " does not meet its difficulty" << std::endl;
                 break;
             }
             
-            int peerCount = std::stoi(parts[0]);
-            std::cout << "Received list of " << peerCount << " peers from " << message.sender << std::endl;
+            // Can't connect it yet; fetch the blocks leading up to it
+            if (!blockchain.isKnownBlock(compact.header.previousHash)) {
+                if (connection->protocolVersion() >= HEADERS_FIRST_VERSION) {
+                    requestHeaders(connection);
+                }
+                break;
+            }
             
-            size_t required_size = 1 + static_cast<size_t>(peerCount) * 4;
-            if (parts.size() < required_size) {
-                std::cerr << "Invalid peer list: missing peer data" << std::endl;
+            PartialBlock partial;
+            if (!partial.init(compact, blockchain.getMempoolTransactions())) {
+                requestFullBlock(connection, hash);
                 break;
             }
             
-            for (int i = 0; i < peerCount; ++i) {
-                int base_idx = 1 + i * 4;
-                
-                std::string peer_address = parts[base_idx];
-                int peer_port = std::stoi(parts[base_idx + 1]);
-                NodeType peer_type = (parts[base_idx + 2] == "FULL_NODE") ? NodeType::FULL_NODE : NodeType::WALLET_NODE;
-                std::string peer_id = parts[base_idx + 3];
+            std::vector<uint64_t> missing = partial.missing();
+            if (missing.empty()) {
+                std::shared_ptr<Block> block = partial.assemble();
+                if (block) {
+                    acceptBlock(connection, *block);
+                } else {
+                    requestFullBlock(connection, hash);
+                }
+                break;
+            }
+            
+            // Ask the sender for the rest
+            if (partialBlocks.size() >= MAX_PARTIAL_BLOCKS) {
+                partialBlocks.erase(partialOrder.front());
+                partialOrder.pop_front();
+            }
+            partialBlocks.emplace(hash, PendingCompactBlock{std::move(partial), connection});
+            partialOrder.push_back(hash);
+            std::cout << "Compact block #" << compact.header.blockNumber << " is missing "
+                      << missing.size() << " of " << compact.header.transactionCount << " transactions" << std::endl;
+            NetworkMessage request(MessageType::GET_BLOCK_TXN, nodeId,
+                                   encodeBlockTransactionsRequest(BlockTransactionsRequest{hash, missing}));
+            connection->send(request);
+            break;
+        }
+        
+        case MessageType::GET_BLOCK_TXN: {
+            BlockTransactionsRequest request = decodeBlockTransactionsRequest(message.data);
+            std::shared_ptr<const Block> block = blockchain.findBlock(request.blockHash);
+            if (!block) {
+                break;
+            }
+            
+            BlockTransactions response{request.blockHash, {}};
+            response.transactions.reserve(request.indexes.size());
+            for (uint64_t index : request.indexes) {
+                // Answering short makes the peer fall back to the full block
+                if (index >= block->transactions.size()) {
+                    std::cerr << "Peer " << message.sender << " asked for transaction " << index
+                              << " of block #" << block->blockNumber << std::endl;
+                    break;
+                }
+                response.transactions.push_back(block->transactions[index]);
+            }
+            
+            NetworkMessage reply(MessageType::BLOCK_TXN, nodeId, encodeBlockTransactions(response));
+            connection->send(reply);
+            break;
+        }
+        
+        case MessageType::BLOCK_TXN: {
+            BlockTransactions response = decodeBlockTransactions(message.data);
+            auto pending = partialBlocks.find(response.blockHash);
+            if (pending == partialBlocks.end()) {
+                break;
+            }
+            if (pending->second.peer.lock() != connection) {
+                std::cerr << "Unrequested transactions for block " << response.blockHash
+                          << " from " << message.sender << std::endl;
+                break;
+            }
+            PartialBlock partial = std::move(pending->second.partial);
+            partialBlocks.erase(pending);
+            partialOrder.erase(std::find(partialOrder.begin(), partialOrder.end(), response.blockHash));
+            
+            std::shared_ptr<Block> block;
+            if (partial.fill(response.transactions)) {
+                block = partial.assemble();
+            }
+            if (block) {
+                acceptBlock(connection, *block);
+            } else {
+                requestFullBlock(connection, response.blockHash);
+            }
+            break;
+        }
+        
+        case MessageType::PEER_LIST: {
+            // Parse the peer list
+            std::vector<PeerInfo> peerInfos = decodePeerList(message.data);
+            std::cout << "Received list of " << peerInfos.size() << " peers from " << message.sender << std::endl;
+            
+            for (const auto& info : peerInfos) {
+                const std::string& peer_address = info.address;
+                int peer_port = info.port;
+                NodeType peer_type = info.type;
+                const std::string& peer_id = info.id;
                 
                 // Don't connect to ourselves
                 if (peer_address == host && peer_port == port) {
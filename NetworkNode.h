@@ -17,22 +17,35 @@
 #include <boost/array.hpp>
 #include <boost/bind.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 #include <set>
 #include <mutex>
 #include <thread>
 #include "Blockchain.h"
+#include "ChainSync.h"
+#include "PartialBlock.h"
 #include "wallet.h"
 #include "Types.h"
+#include "WireProtocol.h"
 
 // Forward declarations
 class NetworkManager;
 class NetworkMessage;
 
-// Types of messages that can be sent over the network
-enum class MessageType {
+// Types of messages that can be sent over the network. The values are on
+// the wire, so new types go at the end.
+enum class MessageType : uint8_t {
     HANDSHAKE,        // Initial connection message
     TRANSACTION,      // New transaction
     BLOCK,            // New block mined
@@ -40,10 +53,20 @@ enum class MessageType {
     CHAIN_RESPONSE,   // Response with blockchain data
     PEER_LIST,        // List of known peers
     PING,             // Ping message to check if a node is alive
-    PONG              // Response to a ping
+    PONG,             // Response to a ping
+    GET_HEADERS,      // Block locator asking for the headers after it
+    HEADERS,          // Headers following the locator's fork point
+    GET_BLOCKS,       // Range of blocks by height
+    BLOCKS,           // Blocks for a GET_BLOCKS range
+    INV,              // Hashes of transactions and blocks we have
+    GET_DATA,         // Announced items the peer wants in full
+    CMPCT_BLOCK,      // New block as its header and short transaction ids
+    GET_BLOCK_TXN,    // Transactions of a compact block we couldn't find
+    BLOCK_TXN         // Transactions for a GET_BLOCK_TXN
 };
 
-// Class to represent a message sent over the network
+// Class to represent a message sent over the network. data holds the
+// binary body for the type, see WireProtocol.h.
 class NetworkMessage {
 public:
     MessageType type;
@@ -53,11 +76,11 @@ public:
     NetworkMessage(MessageType type, const std::string& sender, const std::string& data)
         : type(type), sender(sender), data(data) {}
     
-    // Serialize the message to a string
-    std::string serialize() const;
+    // Frame header plus payload, ready for the socket
+    std::string serialize(uint8_t protocolVersion) const;
     
-    // Deserialize a string to a NetworkMessage
-    static NetworkMessage deserialize(const std::string& serialized);
+    // Parse a frame payload whose header was already checked
+    static NetworkMessage deserialize(const FrameHeader& header, const std::string& payload);
 };
 
 // Represents a peer in the network
@@ -82,6 +105,27 @@ struct Peer {
     }
 };
 
+// Hashes a peer is known to have, because it sent or announced them to
+// us or we announced them to it. Bounded: the oldest are forgotten first.
+// Hashes are kept as 64-bit digests, so a collision at worst skips one
+// announcement to that peer.
+class KnownInventory {
+public:
+    explicit KnownInventory(size_t capacity = DEFAULT_CAPACITY) : capacity(capacity) {}
+    
+    bool contains(const std::string& hash) const;
+    // False if the hash was known already
+    bool insert(const std::string& hash);
+    
+    static const size_t DEFAULT_CAPACITY = 50000;
+    
+private:
+    size_t capacity;
+    mutable std::mutex mutex;
+    std::unordered_set<size_t> digests;
+    std::deque<size_t> order;  // Oldest first
+};
+
 // Class to handle a connection to a peer
 class Connection : public boost::enable_shared_from_this<Connection> {
 public:
@@ -96,18 +140,46 @@ public:
     }
     
     void start();
+    // Safe from any thread; frames go out one at a time in send order
     void send(const NetworkMessage& message);
+    void close();
+    
+    // Version agreed in the handshake; MIN_PROTOCOL_VERSION until then.
+    // Setting it completes the handshake, which lifts the frame size cap.
+    uint8_t protocolVersion() const { return protocol_version_; }
+    void setProtocolVersion(uint8_t version) {
+        protocol_version_ = version;
+        handshake_complete_ = true;
+    }
+    
+    // Node id from the peer's handshake; only used on the io thread
+    const std::string& peerId() const { return peer_id_; }
+    void setPeerId(const std::string& id) { peer_id_ = id; }
+    
+    // Safe from any thread
+    KnownInventory& knownInventory() { return known_inventory_; }
     
 private:
     Connection(boost::asio::io_context& io_context, NetworkManager* manager);
     
-    void handle_read(const boost::system::error_code& error, size_t bytes_transferred);
+    void read_header();
+    void handle_read_header(const boost::system::error_code& error, size_t bytes_transferred);
+    void handle_read_payload(const boost::system::error_code& error, size_t bytes_transferred);
+    void write_next();
     void handle_write(const boost::system::error_code& error);
     
     boost::asio::ip::tcp::socket socket_;
     NetworkManager* manager_;
-    boost::array<char, 1024> buffer_;
-    std::string message_buffer_;
+    std::array<char, FRAME_HEADER_SIZE> header_buffer_;
+    FrameHeader frame_;
+    std::string payload_;
+    // Only touched on the io thread; the front frame is being written and
+    // must stay alive until its write completes
+    std::deque<std::string> write_queue_;
+    std::atomic<uint8_t> protocol_version_;
+    std::atomic<bool> handshake_complete_;
+    std::string peer_id_;
+    KnownInventory known_inventory_;
 };
 
 // Class to manage the network functionality
@@ -132,7 +204,8 @@ public:
     // Broadcast a newly mined block to all peers
     void broadcastBlock(const Block& block);
     
-    // Request the blockchain from peers
+    // Catch up with peers from our tip: headers-first where the peer
+    // speaks it, the whole chain from older peers
     void requestBlockchain();
     
     // Handle an incoming message
@@ -172,7 +245,41 @@ private:
     // Handle a peer connection
     void handlePeerConnection(Connection::pointer connection);
     
+    // Our HANDSHAKE message
+    NetworkMessage makeHandshake() const;
+    
+    // Send our block locator to one peer
+    void requestHeaders(Connection::pointer connection);
+    
+    // Ask every peer that has blocks we need for its next ranges
+    void scheduleBlockDownloads();
+    
+    // Announce an item to the peers not known to have it, except one.
+    // Peers from before INV get the full message, and if there is a
+    // compact message, peers that take it get that pushed instead of an
+    // INV. Messages are built on first use. Returns the number of peers
+    // reached.
+    size_t relayInventory(const InventoryItem& item, const std::function<NetworkMessage()>& fullMessage,
+                          Connection::pointer except,
+                          const std::function<NetworkMessage()>& compactMessage = nullptr);
+    
+    // Relay a block we accepted, compact where the peer takes it
+    size_t relayBlock(const Block& block, Connection::pointer except);
+    
+    // Add a block a peer sent, in full or rebuilt from a compact block,
+    // and pass it on if it made it into our tree
+    void acceptBlock(Connection::pointer connection, const Block& block);
+    
+    // Fall back to GET_DATA for a compact block we couldn't rebuild
+    void requestFullBlock(Connection::pointer connection, const std::string& hash);
+    
+    // Records a GET_DATA for the hash; false if another peer was already
+    // asked for it and hasn't had time to answer
+    bool markRequested(const std::string& hash);
+    void clearRequested(const std::string& hash);
+    
     Blockchain& blockchain;
+    ChainSync sync;
     Wallet& wallet;          // Reference to an external wallet
     NodeType nodeType;
     std::string host;
@@ -185,8 +292,21 @@ private:
     std::set<Peer> peers;
     std::vector<Connection::pointer> connections;
     
+    // Announced items we asked a peer for, by hash, and when
+    std::map<std::string, std::chrono::steady_clock::time_point> requestedInventory;
+    // Compact blocks waiting for their BLOCK_TXN, by hash, and their hashes
+    // in arrival order so the oldest goes first when full; only touched on
+    // the io thread
+    struct PendingCompactBlock {
+        PartialBlock partial;
+        boost::weak_ptr<Connection> peer;  // The only one whose BLOCK_TXN counts
+    };
+    std::map<std::string, PendingCompactBlock> partialBlocks;
+    std::deque<std::string> partialOrder;
+    
     mutable std::mutex peers_mutex;
     mutable std::mutex connections_mutex;
+    std::mutex inventory_mutex;
     
     bool running;
     std::thread service_thread;
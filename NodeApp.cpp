@@ -12,6 +12,7 @@
 #include "Types.h"
 #include "balanceMapping.h"
 #include "explorer.h"
+#include "SignatureCache.h"
 #include "api/CelestialChainAPI.h" // Add API include
 #include <stdexcept>
 #include <direct.h> // For _mkdir on Windows
@@ -45,7 +46,7 @@ void printFullNodeMenu(const Blockchain& blockchain) {
     cout << "\n-------- Blockchain Node --------" << endl;
     cout << "1. View blockchain" << endl;
     cout << "2. View mempool" << endl;
-    cout << "3. Mine block (Current reward: " << blockchain.getCurrentMiningReward() << " $CLST)" << endl;
+    cout << "3. Mine block (Current reward: " << formatAmount(blockchain.getCurrentMiningReward()) << " $CLST)" << endl;
     cout << "4. Create transaction" << endl;
     cout << "5. View wallet" << endl;
     cout << "6. Connect to peer" << endl;
@@ -85,6 +86,11 @@ int main(int argc, char* argv[]) {
     int difficulty = 4;
     bool cleanStart = false;
     int apiPort = 8080; // Default API port
+    size_t maxBlockBytes = BlockTemplateBuilder::DEFAULT_MAX_BLOCK_BYTES;
+    size_t maxBlockTxs = BlockTemplateBuilder::DEFAULT_MAX_BLOCK_TRANSACTIONS;
+    size_t snapshotInterval = Blockchain::DEFAULT_SNAPSHOT_INTERVAL;
+    bool fullVerify = false;
+    size_t blockWindow = ChainStore::DEFAULT_WINDOW_SIZE;
 
     for (int i = 1; i < argc; ++i) {
         string arg = argv[i];
@@ -105,6 +111,16 @@ int main(int argc, char* argv[]) {
             cleanStart = true;
         } else if (arg == "--api-port" && i + 1 < argc) {
             apiPort = stoi(argv[++i]);
+        } else if (arg == "--max-block-bytes" && i + 1 < argc) {
+            maxBlockBytes = stoul(argv[++i]);
+        } else if (arg == "--max-block-txs" && i + 1 < argc) {
+            maxBlockTxs = stoul(argv[++i]);
+        } else if (arg == "--block-window" && i + 1 < argc) {
+            blockWindow = stoul(argv[++i]);
+        } else if (arg == "--full-verify") {
+            fullVerify = true;
+        } else if (arg == "--snapshot-interval" && i + 1 < argc) {
+            snapshotInterval = stoul(argv[++i]);
         } else if (arg == "--help") {
             cout << "Usage: " << argv[0] << " [OPTIONS]\n";
             cout << "  --host HOST       Set the host address\n";
@@ -112,13 +128,21 @@ int main(int argc, char* argv[]) {
             cout << "  --type TYPE       Set the node type (full or wallet)\n";
             cout << "  --difficulty DIFF Set the mining difficulty\n";
             cout << "  --api-port PORT   Set the API port (default: 8080)\n";
+            cout << "  --max-block-bytes N  Max size of a mined block's transactions (default: 1048576)\n";
+            cout << "  --max-block-txs N    Max transactions in a mined block (default: 2000)\n";
+            cout << "  --snapshot-interval N  Blocks between balance snapshots, 0 disables (default: 100)\n";
             cout << "  --clean           Start with a fresh blockchain (ignore existing database)\n";
+            cout << "  --full-verify     Re-validate every stored block at startup\n";
+            cout << "  --block-window N  Full blocks kept in memory, older ones are read from disk (default: 1024)\n";
             cout << "  --help            Display this help message\n";
             return 0;
         }
     }
 
     Blockchain blockchain(difficulty);
+    blockchain.setBlockLimits(maxBlockBytes, maxBlockTxs);
+    blockchain.setSnapshotInterval(snapshotInterval);
+    blockchain.setBlockWindow(blockWindow);
     
     string hostfilename = fileNameFromHost(host);
     string dbPath = "./Storage_" + hostfilename + "_" + to_string(port);
@@ -149,6 +173,11 @@ int main(int argc, char* argv[]) {
         cout << "Database opened successfully." << endl;
         dbPtr = &db;  // Set the pointer to the valid database
         
+        // One-time conversion of text records written by older versions
+        if (!db.migrateStorageFormat()) {
+            cout << "Storage format migration failed: " << db.getLastError() << endl;
+        }
+        
         cout << "Verifying database integrity..." << endl;
         bool dbIntegrity = db.verifyDatabaseIntegrity(true);
         if (!dbIntegrity) {
@@ -170,12 +199,8 @@ int main(int argc, char* argv[]) {
             // Load blockchain data from database
             cout << "Loading blockchain data from database..." << endl;
             try {
-                blockchain.loadFromDatabase();
+                blockchain.loadFromDatabase(fullVerify);
                 cout << "Blockchain loaded with " << blockchain.getChainSize() << " blocks." << endl;
-                
-                // Explicitly rebuild balances from transactions
-                cout << "Explicitly rebuilding balances from transaction history..." << endl;
-                blockchain.rebuildBalancesFromTransactions();
             } catch (const exception& e) {
                 cout << "Error loading blockchain from database: " << e.what() << endl;
                 cout << "Starting with fresh blockchain." << endl;
@@ -192,9 +217,9 @@ int main(int argc, char* argv[]) {
     
     // Synchronize wallet balance from database if available
     if (balanceMapPtr) {
-        double dbBalance = 0.0;
+        Amount dbBalance = 0;
         if (balanceMapPtr->getBalance(nodeWallet.getAddress(), dbBalance)) {
-            cout << "Synchronizing wallet balance: " << dbBalance << " $CLST" << endl;
+            cout << "Synchronizing wallet balance: " << formatAmount(dbBalance) << " $CLST" << endl;
             nodeWallet.synchronizeBalance(dbBalance);
         } else {
             cout << "No existing balance found for wallet in database" << endl;
@@ -202,17 +227,17 @@ int main(int argc, char* argv[]) {
         
         // Debug: Check the specific addresses mentioned by the user
         const string addressToCheck = "0x42957ede02fe8537b2833b5b7631c9b019e46295";
-        double specificBalance = 0.0;
+        Amount specificBalance = 0;
         if (balanceMapPtr->getBalance(addressToCheck, specificBalance)) {
-            cout << "DEBUG: Balance for " << addressToCheck << ": " << specificBalance << endl;
+            cout << "DEBUG: Balance for " << addressToCheck << ": " << formatAmount(specificBalance) << endl;
         } else {
             cout << "DEBUG: Failed to retrieve balance for " << addressToCheck << endl;
         }
         
         const string senderAddress = "0xa2843a4556c20f6e16a4ce3d89c4a9bf4248c3d1";
-        double senderBalance = 0.0;
+        Amount senderBalance = 0;
         if (balanceMapPtr->getBalance(senderAddress, senderBalance)) {
-            cout << "DEBUG: Balance for " << senderAddress << ": " << senderBalance << endl;
+            cout << "DEBUG: Balance for " << senderAddress << ": " << formatAmount(senderBalance) << endl;
         } else {
             cout << "DEBUG: Failed to retrieve balance for " << senderAddress << endl;
         }
@@ -313,9 +338,9 @@ int main(int argc, char* argv[]) {
                     clearScreen();
                     // Resynchronize wallet balance with database before transaction
                     if (balanceMapPtr) {
-                        double dbBalance = 0.0;
+                        Amount dbBalance = 0;
                         if (balanceMapPtr->getBalance(nodeWallet.getAddress(), dbBalance)) {
-                            cout << "Synchronizing wallet balance from database: " << dbBalance << " $CLST" << endl;
+                            cout << "Synchronizing wallet balance from database: " << formatAmount(dbBalance) << " $CLST" << endl;
                             nodeWallet.synchronizeBalance(dbBalance);
                         }
                     }
@@ -323,7 +348,7 @@ int main(int argc, char* argv[]) {
                     cout << "Enter amount: ";   cin >> amount;
                     Transaction tx("", "", 0);
                     cout << "Transaction is created" << endl;
-                    nodeWallet.sendMoney(amount, receiver, tx);
+                    nodeWallet.sendMoney(amountFromCoins(amount), receiver, tx);
                     blockchain.addTransaction(tx);
                     networkManager.broadcastTransaction(tx);
                 }
@@ -337,7 +362,7 @@ int main(int argc, char* argv[]) {
                     try {
                         Transaction tx("", "", 0);
                         cout << "Transaction is created" << endl;
-                        nodeWallet.sendMoney(amount, receiver, tx);
+                        nodeWallet.sendMoney(amountFromCoins(amount), receiver, tx);
                         cout << "Money is sent" << endl;
                         blockchain.addTransaction(tx);
                         cout << "Transaction is added" << endl;
@@ -351,7 +376,7 @@ int main(int argc, char* argv[]) {
                     if (nodeType == NodeType::FULL_NODE) {
                         cout << "Wallet Details (Full Node):" << endl;
                         cout << "Address: " << nodeWallet.getAddress() << endl;
-                        cout << "Balance: " << nodeWallet.getBalance() << " $CLST" << endl;
+                        cout << "Balance: " << formatAmount(nodeWallet.getBalance()) << " $CLST" << endl;
                         cout << "Press Enter to continue..." << endl;
                         getchar();
                     } else if (nodeType == NodeType::WALLET_NODE) {
@@ -371,7 +396,7 @@ int main(int argc, char* argv[]) {
                 if (nodeType == NodeType::FULL_NODE) {
                     clearScreen();
                     cout << "Address: " << nodeWallet.getAddress() << endl;
-                    cout << "Balance: " << nodeWallet.getBalance() << endl;
+                    cout << "Balance: " << formatAmount(nodeWallet.getBalance()) << endl;
                 } else {
                     clearScreen();
                     cout << "Peer address: "; cin >> peerAddress;
@@ -436,28 +461,36 @@ int main(int argc, char* argv[]) {
                         cout << "Total Blocks: " << explorer.getBlockCount() << endl;
                         cout << "Total Transactions: " << explorer.getTransactionCount() << endl;
                         cout << "Unique Addresses: " << balanceMapPtr->getAllBalances().size() << endl;
-                        cout << "Total Supply: " << blockchain.getTotalSupply() << " $CLST" << endl;
+                        cout << "Total Supply: " << formatAmount(blockchain.getTotalSupply()) << " $CLST" << endl;
+                        cout << "Signature Cache: " << SignatureCache::shared().getHits() << " hits, "
+                             << SignatureCache::shared().getMisses() << " misses" << endl;
+                        cout << "Balance Cache: " << balanceMapPtr->getCache().getHits() << " hits, "
+                             << balanceMapPtr->getCache().getMisses() << " misses, "
+                             << balanceMapPtr->getCache().size() << " entries" << endl;
+                        cout << "Block Window: " << blockchain.getChainStore().residentBlocks() << " blocks in memory, "
+                             << blockchain.getChainStore().getHits() << " hits, "
+                             << blockchain.getChainStore().getMisses() << " misses" << endl;
                         
                         cout << "\n-------- Your Wallet --------" << endl;
                         cout << "Address: " << nodeWallet.getAddress() << endl;
-                        cout << "Balance: " << explorer.getAddressBalance(nodeWallet.getAddress()) << endl;
+                        cout << "Balance: " << formatAmount(explorer.getAddressBalance(nodeWallet.getAddress())) << endl;
                         
                         // Display current mining reward and halving info
-                        double currentReward = blockchain.getCurrentMiningReward();
+                        Amount currentReward = blockchain.getCurrentMiningReward();
                         time_t currentTime = time(nullptr);
                         double secondsSinceGenesis = difftime(currentTime, Blockchain::GENESIS_TIMESTAMP);
                         int daysSinceGenesis = static_cast<int>(secondsSinceGenesis / (60 * 60 * 24));
                         int numberOfHalvings = daysSinceGenesis / 30; // 30 days per halving
                         int daysUntilNextHalving = 30 - (daysSinceGenesis % 30);
                         
-                        cout << "Current Mining Reward: " << currentReward << " $CLST" << endl;
+                        cout << "Current Mining Reward: " << formatAmount(currentReward) << " $CLST" << endl;
                         cout << "Halvings Occurred: " << numberOfHalvings << endl;
                         cout << "Days Until Next Halving: " << daysUntilNextHalving << endl;
                         
                         // Display top balances
                         auto balances = balanceMapPtr->getAllBalances();
                         // Convert to vector for sorting
-                        vector<pair<string, double>> balanceList(balances.begin(), balances.end());
+                        vector<pair<string, Amount>> balanceList(balances.begin(), balances.end());
                         // Sort by balance (highest first)
                         sort(balanceList.begin(), balanceList.end(), 
                             [](const auto& a, const auto& b) { return a.second > b.second; });
@@ -466,7 +499,7 @@ int main(int argc, char* argv[]) {
                         size_t count = min(balanceList.size(), size_t(5));
                         for (size_t i = 0; i < count; i++) {
                             cout << (i+1) << ". " << balanceList[i].first << ": " 
-                                 << balanceList[i].second << " $CLST" << endl;
+                                 << formatAmount(balanceList[i].second) << " $CLST" << endl;
                         }
                     } else {
                         cout << "Explorer requires database connection to display statistics." << endl;
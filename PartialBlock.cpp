@@ -0,0 +1,120 @@
+#include "PartialBlock.h"
+#include <set>
+#include <unordered_map>
+#include "sha.h"
+
+uint64_t shortTransactionId(uint64_t salt, const std::string& blockHash, const std::string& txHash) {
+    std::string input;
+    input.reserve(8 + blockHash.size() + txHash.size());
+    for (int i = 0; i < 8; i++) {
+        input.push_back(static_cast<char>(salt >> (8 * i)));
+    }
+    input += blockHash;
+    input += txHash;
+    SHA256Digest digest = computeSHA256Digest(input);
+
+    uint64_t id = 0;
+    for (size_t i = 0; i < SHORT_ID_SIZE; i++) {
+        id |= static_cast<uint64_t>(digest[i]) << (8 * i);
+    }
+    return id;
+}
+
+CompactBlock makeCompactBlock(const Block& block, uint64_t salt) {
+    CompactBlock compact;
+    compact.header = headerOf(block);
+    compact.salt = salt;
+    for (size_t i = 0; i < block.transactions.size(); i++) {
+        const Transaction& tx = block.transactions[i];
+        if (tx.sender == "Genesis") {
+            compact.prefilled.push_back(PrefilledTransaction{i, tx});
+        } else {
+            compact.shortIds.push_back(shortTransactionId(salt, block.hash, tx.hash));
+        }
+    }
+    return compact;
+}
+
+bool PartialBlock::init(const CompactBlock& compact, const std::vector<const Transaction*>& mempool) {
+    header = compact.header;
+    found.clear();
+
+    size_t count = compact.shortIds.size() + compact.prefilled.size();
+    if (header.transactionCount != count) {
+        return false;
+    }
+    for (const auto& prefilled : compact.prefilled) {
+        if (prefilled.index >= count) {
+            return false;
+        }
+        found.emplace(prefilled.index, prefilled.tx);
+    }
+
+    // Short ids fill the slots the prefilled transactions left, in order
+    std::unordered_map<uint64_t, uint64_t> slots;
+    slots.reserve(compact.shortIds.size());
+    uint64_t index = 0;
+    for (uint64_t id : compact.shortIds) {
+        while (found.count(index)) {
+            index++;
+        }
+        if (!slots.emplace(id, index).second) {
+            return false;
+        }
+        index++;
+    }
+
+    // A slot matched by two mempool transactions is left for the sender
+    std::set<uint64_t> ambiguous;
+    for (const Transaction* tx : mempool) {
+        auto slot = slots.find(shortTransactionId(compact.salt, header.hash, tx->hash));
+        if (slot == slots.end() || ambiguous.count(slot->second)) {
+            continue;
+        }
+        if (!found.emplace(slot->second, *tx).second) {
+            found.erase(slot->second);
+            ambiguous.insert(slot->second);
+        }
+    }
+    return true;
+}
+
+std::vector<uint64_t> PartialBlock::missing() const {
+    std::vector<uint64_t> indexes;
+    for (uint64_t index = 0; index < header.transactionCount; index++) {
+        if (!found.count(index)) {
+            indexes.push_back(index);
+        }
+    }
+    return indexes;
+}
+
+bool PartialBlock::fill(const std::vector<Transaction>& transactions) {
+    std::vector<uint64_t> indexes = missing();
+    if (indexes.size() != transactions.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < indexes.size(); i++) {
+        found.emplace(indexes[i], transactions[i]);
+    }
+    return true;
+}
+
+std::shared_ptr<Block> PartialBlock::assemble() const {
+    if (found.size() != header.transactionCount) {
+        return nullptr;
+    }
+    std::vector<Transaction> transactions;
+    transactions.reserve(found.size());
+    for (const auto& entry : found) {
+        transactions.push_back(entry.second);
+    }
+
+    auto block = std::make_shared<Block>(header.blockNumber, header.timestamp, std::move(transactions),
+                                         header.previousHash, header.hash, header.nonce,
+                                         header.difficulty, header.version);
+    if (block->calculateHash() != header.hash) {
+        return nullptr;
+    }
+    return block;
+}
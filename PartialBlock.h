@@ -0,0 +1,50 @@
+#ifndef PARTIALBLOCK_H
+#define PARTIALBLOCK_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Block.h"
+#include "ChainStore.h"
+#include "WireProtocol.h"
+
+// Short id of a transaction in one compact block: the first SHORT_ID_SIZE
+// bytes of SHA-256 over the salt, the block hash and the transaction hash.
+// Keying on the block and a random salt keeps collisions from being
+// precomputed.
+uint64_t shortTransactionId(uint64_t salt, const std::string& blockHash, const std::string& txHash);
+
+// Short ids for every transaction except the mining rewards, which no
+// mempool has and are sent in full
+CompactBlock makeCompactBlock(const Block& block, uint64_t salt);
+
+// A block being rebuilt from a compact block. Transactions are matched
+// against the mempool by short id; whatever isn't found there is asked of
+// the sender and filled in when it arrives.
+class PartialBlock {
+public:
+    // False if the compact block doesn't add up or two of its transactions
+    // share a short id; the full block has to be fetched then. Matched
+    // transactions are copied out of the mempool.
+    bool init(const CompactBlock& compact, const std::vector<const Transaction*>& mempool);
+
+    // Indexes still to be fetched, increasing
+    std::vector<uint64_t> missing() const;
+
+    // The transactions for missing(), in order. False if the count is off.
+    bool fill(const std::vector<Transaction>& transactions);
+
+    // The block once nothing is missing. Null if it doesn't hash to the
+    // header's hash, which a short id matching the wrong mempool
+    // transaction leads to.
+    std::shared_ptr<Block> assemble() const;
+
+    const BlockHeader& getHeader() const { return header; }
+
+private:
+    BlockHeader header;
+    std::map<uint64_t, Transaction> found;  // By index in the block
+};
+
+#endif // PARTIALBLOCK_H
@@ -0,0 +1,76 @@
+#include "SignatureCache.h"
+#include <cstring>
+
+SignatureCache::SignatureCache(size_t capacity)
+    : shardCapacity(capacity / SHARD_COUNT + 1), hits(0), misses(0) {
+}
+
+SignatureCache& SignatureCache::shared() {
+    static SignatureCache cache;
+    return cache;
+}
+
+size_t SignatureCache::DigestHasher::operator()(const SHA256Digest& digest) const {
+    // The key is already a uniform hash, any 8 bytes of it will do
+    size_t value;
+    std::memcpy(&value, digest.data(), sizeof(value));
+    return value;
+}
+
+SHA256Digest SignatureCache::makeKey(const std::string& hash, const std::string& publicKey,
+                                     const std::string& signature) {
+    // Length prefixes keep field boundaries unambiguous
+    std::string material;
+    material.reserve(hash.size() + publicKey.size() + signature.size() + 12);
+    material += std::to_string(hash.size()) + ":" + hash;
+    material += std::to_string(publicKey.size()) + ":" + publicKey;
+    material += std::to_string(signature.size()) + ":" + signature;
+    return computeSHA256Digest(material);
+}
+
+SignatureCache::Shard& SignatureCache::shardFor(const SHA256Digest& key) {
+    return shards[key[31] % SHARD_COUNT];
+}
+
+bool SignatureCache::lookup(const std::string& hash, const std::string& publicKey,
+                            const std::string& signature, bool& valid) {
+    SHA256Digest key = makeKey(hash, publicKey, signature);
+    Shard& shard = shardFor(key);
+    
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.results.find(key);
+    if (found == shard.results.end()) {
+        misses++;
+        return false;
+    }
+    hits++;
+    valid = found->second;
+    return true;
+}
+
+void SignatureCache::store(const std::string& hash, const std::string& publicKey,
+                           const std::string& signature, bool valid) {
+    SHA256Digest key = makeKey(hash, publicKey, signature);
+    Shard& shard = shardFor(key);
+    
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (!shard.results.emplace(key, valid).second) {
+        return;
+    }
+    shard.insertionOrder.push_back(key);
+    
+    // Drop the oldest entries once the shard is full
+    while (shard.insertionOrder.size() > shardCapacity) {
+        shard.results.erase(shard.insertionOrder.front());
+        shard.insertionOrder.pop_front();
+    }
+}
+
+size_t SignatureCache::size() const {
+    size_t total = 0;
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.results.size();
+    }
+    return total;
+}
@@ -0,0 +1,63 @@
+#ifndef SIGNATURECACHE_H
+#define SIGNATURECACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "sha.h"
+
+// Remembers the outcome of signature checks so a transaction that is seen
+// on relay, in a mined block, at startup and again in a peer's chain is only
+// verified once per process. Entries are keyed by a SHA-256 of
+// (tx hash, public key, signature), so a changed field is a different entry.
+// Bounded: the oldest entries are dropped once capacity is reached.
+class SignatureCache {
+public:
+    explicit SignatureCache(size_t capacity = DEFAULT_CAPACITY);
+
+    SignatureCache(const SignatureCache&) = delete;
+    SignatureCache& operator=(const SignatureCache&) = delete;
+
+    // Returns true and sets valid if the triple has been checked before
+    bool lookup(const std::string& hash, const std::string& publicKey,
+                const std::string& signature, bool& valid);
+    void store(const std::string& hash, const std::string& publicKey,
+               const std::string& signature, bool valid);
+
+    uint64_t getHits() const { return hits.load(); }
+    uint64_t getMisses() const { return misses.load(); }
+    size_t size() const;
+
+    // Instance shared by every validation path
+    static SignatureCache& shared();
+
+    static const size_t DEFAULT_CAPACITY = 200000;
+
+private:
+    struct DigestHasher {
+        size_t operator()(const SHA256Digest& digest) const;
+    };
+
+    // Split into shards so pool threads rarely contend on one lock
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<SHA256Digest, bool, DigestHasher> results;
+        std::deque<SHA256Digest> insertionOrder;
+    };
+
+    static const size_t SHARD_COUNT = 16;
+
+    static SHA256Digest makeKey(const std::string& hash, const std::string& publicKey,
+                                const std::string& signature);
+    Shard& shardFor(const SHA256Digest& key);
+
+    size_t shardCapacity;
+    Shard shards[SHARD_COUNT];
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+};
+
+#endif // SIGNATURECACHE_H
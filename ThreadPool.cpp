@@ -0,0 +1,86 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <exception>
+
+ThreadPool::ThreadPool(unsigned int threadCount) : stopping(false) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+    
+    workers.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCondition.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+    
+    // A few chunks per worker so one slow chunk doesn't leave cores idle
+    size_t chunkCount = std::min(count, static_cast<size_t>(getThreadCount()) * 4);
+    size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+    
+    std::vector<std::future<void>> pending;
+    pending.reserve(chunkCount);
+    for (size_t begin = 0; begin < count; begin += chunkSize) {
+        size_t end = std::min(count, begin + chunkSize);
+        pending.push_back(submit([&body, begin, end]() {
+            for (size_t i = begin; i < end; i++) {
+                body(i);
+            }
+        }));
+    }
+    
+    // Every chunk references body, so wait for all of them before
+    // rethrowing the first exception any chunk raised
+    std::exception_ptr firstError;
+    for (auto& result : pending) {
+        try {
+            result.get();
+        } catch (...) {
+            if (!firstError) {
+                firstError = std::current_exception();
+            }
+        }
+    }
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
@@ -0,0 +1,59 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that run queued tasks.
+// Used to spread CPU-heavy validation (signature checks, address
+// derivation) over all cores instead of running it on the caller.
+class ThreadPool {
+public:
+    // threadCount of 0 uses every available hardware thread
+    explicit ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Queue a task; the future carries its result or exception
+    template <typename F>
+    auto submit(F task) -> std::future<decltype(task())> {
+        using Result = decltype(task());
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+        std::future<Result> result = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            tasks.push([packaged]() { (*packaged)(); });
+        }
+        queueCondition.notify_one();
+        return result;
+    }
+
+    // Run body(i) for every i in [0, count) split into chunks across the
+    // workers, and wait for all of them. Must not be called from a task
+    // running on the same pool.
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    unsigned int getThreadCount() const { return static_cast<unsigned int>(workers.size()); }
+
+    // Process-wide pool shared by the validation paths
+    static ThreadPool& shared();
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    bool stopping;
+};
+
+#endif // THREADPOOL_H
@@ -1,27 +1,91 @@
 #include "Transaction.h"
+#include "BinaryCodec.h"
 #include "sha.h"
+#include "sha_multibuffer.h"
 #include "wallet.h"
 #include "crypto_utils.h"
+#include "ThreadPool.h"
+#include "SignatureCache.h"
 #include <iostream>
 #include <sstream>
 #include <ctime>
 
-Transaction::Transaction(std::string sender, std::string receiver, double amount)
-    : sender(sender), senderPublicKey(""), receiver(receiver), amount(amount), timestamp(time(nullptr)) {
+Transaction::Transaction(std::string sender, std::string receiver, Amount amount)
+    : sender(sender), senderPublicKey(""), receiver(receiver), amount(amount), timestamp(time(nullptr)),
+      version(CURRENT_VERSION) {
     // Calculate the hash but leave signature empty
     hash = calculateHash();
 }
 
 Transaction::Transaction(std::string sender, std::string senderPublicKey, std::string receiver, 
-                        double amount, std::string hash, std::string signature, unsigned long timestamp)
+                        Amount amount, std::string hash, std::string signature, unsigned long timestamp,
+                        int version)
     : sender(sender), senderPublicKey(senderPublicKey), receiver(receiver), 
-      amount(amount), hash(hash), signature(signature), timestamp(timestamp) {
+      amount(amount), hash(hash), signature(signature), timestamp(timestamp), version(version) {
     // Hash is provided, so we don't recalculate it
 }
 
+bool Transaction::isKnownVersion(int version) {
+    return version == VERSION_LEGACY || version == VERSION_FIXED_POINT;
+}
+
+bool Transaction::hasExactAmount() const {
+    return version != VERSION_LEGACY || amount % LEGACY_AMOUNT_STEP == 0;
+}
+
+std::string Transaction::amountEncoding() const {
+    if (version == VERSION_LEGACY) {
+        return std::to_string(amountToCoins(amount));
+    }
+    return formatAmount(amount);
+}
+
+std::string Transaction::hashPreimage() const {
+    std::string preimage = sender + senderPublicKey + receiver + amountEncoding() + std::to_string(timestamp);
+    if (version == VERSION_LEGACY) {
+        return preimage;
+    }
+    return "v" + std::to_string(version) + "|" + preimage;
+}
+
 std::string Transaction::calculateHash() const {
-    std::string data = sender + senderPublicKey + receiver + std::to_string(amount) + std::to_string(timestamp);
-    return "0x" + computeSHA256(data); // Add 0x prefix to transaction hash
+    return "0x" + computeSHA256(hashPreimage()); // Add 0x prefix to transaction hash
+}
+
+std::vector<std::string> Transaction::calculateHashes(const std::vector<const Transaction*>& transactions) {
+    std::vector<std::string> preimages;
+    preimages.reserve(transactions.size());
+    for (const Transaction* tx : transactions) {
+        preimages.push_back(tx->hashPreimage());
+    }
+    
+    std::vector<SHA256Digest> digests = SHA256MultiBuffer::hash(preimages);
+    
+    std::vector<std::string> hashes;
+    hashes.reserve(digests.size());
+    for (const auto& digest : digests) {
+        hashes.push_back("0x" + digestToHex(digest));
+    }
+    return hashes;
+}
+
+size_t Transaction::findInvalid(const std::vector<const Transaction*>& transactions) {
+    // Hashing is cheap and batched; the address and signature checks are the
+    // expensive part and are independent per transaction
+    std::vector<std::string> expectedHashes = calculateHashes(transactions);
+    std::vector<char> valid(transactions.size(), 0);
+    
+    ThreadPool::shared().parallelFor(transactions.size(), [&](size_t i) {
+        valid[i] = transactions[i]->isValid(expectedHashes[i]) ? 1 : 0;
+    });
+    
+    // Scan in order so the reported failure doesn't depend on scheduling
+    for (size_t i = 0; i < valid.size(); i++) {
+        if (!valid[i]) {
+            return i;
+        }
+    }
+    return transactions.size();
 }
 
 bool Transaction::verifyAddress() const {
@@ -69,25 +133,45 @@ bool Transaction::verifySignature() const {
         return false;
     }
     
-    // Debug output for transaction verification
-    std::cout << "\n===== Transaction Signature Verification =====" << std::endl;
-    std::cout << "  Sender Address: " << sender << std::endl;
-    std::cout << "  Sender Public Key: " << (senderPublicKey.length() > 20 ? senderPublicKey.substr(0, 20) + "..." : senderPublicKey) << std::endl;
-    std::cout << "  Hash: " << hash << std::endl;
-    std::cout << "  Signature: " << (signature.length() > 20 ? signature.substr(0, 20) + "..." : signature) << std::endl;
+    // Each (hash, public key, signature) is only verified once per process
+    bool result;
+    if (SignatureCache::shared().lookup(hash, senderPublicKey, signature, result)) {
+        return result;
+    }
     
-    // Verify using the public key (not the address)
-    bool result = Wallet::verifySignature(hash, signature, senderPublicKey);
-    std::cout << "===== Signature Verification " << (result ? "PASSED" : "FAILED") << " =====" << std::endl;
+    // Verify using the public key (not the address). This runs on pool
+    // threads during block validation, so only failures are logged.
+    result = Wallet::verifySignature(hash, signature, senderPublicKey);
+    SignatureCache::shared().store(hash, senderPublicKey, signature, result);
+    if (!result) {
+        std::cerr << "ERROR: Signature verification failed" << std::endl;
+        std::cerr << "  Sender Address: " << sender << std::endl;
+        std::cerr << "  Hash: " << hash << std::endl;
+        std::cerr << "  Signature: " << (signature.length() > 20 ? signature.substr(0, 20) + "..." : signature) << std::endl;
+    }
     return result;
 }
 
 bool Transaction::isValid() const {
+    // Genesis transaction is accepted without looking at the hash
+    if (sender == "Genesis" && receiver == "Genesis") {
+        return true;
+    }
+    return isValid(calculateHash());
+}
+
+bool Transaction::isValid(const std::string& expectedHash) const {
     // Special case for genesis block's genesis transaction 
     if (sender == "Genesis" && receiver == "Genesis") {
         return true;
     }
     
+    // Any other version would still hash, but under rules nobody defined
+    if (!isKnownVersion(version)) {
+        std::cerr << "ERROR: Transaction has unknown version " << version << std::endl;
+        return false;
+    }
+    
     // Special case for coinbase/mining reward transactions
     if (sender == "Genesis" && receiver != "Genesis") {
         // For coinbase transactions, we only need to verify some basic properties
@@ -97,12 +181,11 @@ bool Transaction::isValid() const {
         }
         
         if (amount <= 0) {
-            std::cerr << "ERROR: Coinbase transaction has non-positive amount: " << amount << std::endl;
+            std::cerr << "ERROR: Coinbase transaction has non-positive amount: " << formatAmount(amount) << std::endl;
             return false;
         }
         
         // Verify the hash matches
-        std::string expectedHash = calculateHash();
         if (hash != expectedHash) {
             std::cerr << "ERROR: Coinbase transaction hash mismatch." << std::endl;
             std::cerr << "  Expected: " << expectedHash << std::endl;
@@ -125,12 +208,11 @@ bool Transaction::isValid() const {
     }
     
     if (amount <= 0) {
-        std::cerr << "ERROR: Transaction has non-positive amount: " << amount << std::endl;
+        std::cerr << "ERROR: Transaction has non-positive amount: " << formatAmount(amount) << std::endl;
         return false;
     }
     
     // Verify the hash matches
-    std::string expectedHash = calculateHash();
     if (hash != expectedHash) {
         std::cerr << "ERROR: Transaction hash mismatch." << std::endl;
         std::cerr << "  Expected: " << expectedHash << std::endl;
@@ -164,7 +246,7 @@ void Transaction::print() const {
         std::cout << "  Sender Public Key: <none>" << std::endl;
     }
     std::cout << "  Receiver: " << receiver << std::endl;
-    std::cout << "  Amount: " << amount << std::endl;
+    std::cout << "  Amount: " << formatAmount(amount) << std::endl;
     std::cout << "  Hash: " << hash << std::endl;
     std::cout << "  Signature: " << (signature.empty() ? "unsigned" : 
                                   (signature.length() > 20 ? signature.substr(0, 20) + "..." : signature)) << std::endl;
@@ -182,4 +264,27 @@ void Transaction::sign(const Wallet& wallet) {
     // Sign the transaction using the wallet's private key
     signature = wallet.signMessage(hash);
     std::cout << "Transaction signed with wallet " << wallet.getAddress() << std::endl;
-}
\ No newline at end of file
+}
+
+void encodeTransaction(BinaryWriter& writer, const Transaction& tx) {
+    writer.writeHexString(tx.sender);
+    writer.writeHexString(tx.senderPublicKey);
+    writer.writeHexString(tx.receiver);
+    writer.writeSignedVarint(tx.amount);
+    writer.writeVarint(tx.timestamp);
+    writer.writeHexString(tx.hash);
+    writer.writeHexString(tx.signature);
+    writer.writeVarint(static_cast<uint64_t>(tx.version));
+}
+
+Transaction decodeTransaction(BinaryReader& reader) {
+    std::string sender = reader.readHexString();
+    std::string senderPublicKey = reader.readHexString();
+    std::string receiver = reader.readHexString();
+    Amount amount = reader.readSignedVarint();
+    unsigned long timestamp = static_cast<unsigned long>(reader.readVarint());
+    std::string hash = reader.readHexString();
+    std::string signature = reader.readHexString();
+    int version = static_cast<int>(reader.readVarint());
+    return Transaction(sender, senderPublicKey, receiver, amount, hash, signature, timestamp, version);
+}
@@ -2,32 +2,65 @@
 #define TRANSACTION_H
 
 #include <string>
+#include <vector>
+#include "Amount.h"
 
 class Wallet;
+class BinaryWriter;
+class BinaryReader;
 
 class Transaction {
 public:
     std::string sender;         // Sender's address (0x...) 
     std::string senderPublicKey; // Sender's public key (0x04...)
     std::string receiver;        // Receiver's address
-    double amount;
+    Amount amount;               // In base units
     std::string hash;
     std::string signature;
     unsigned long timestamp;
+    int version;                 // How the amount is encoded for hashing
+    
+    // Legacy transactions hash the amount as std::to_string of the value in
+    // coins, which keeps six decimals. Fixed-point transactions hash the
+    // exact amount and tag the preimage with the version.
+    static const int VERSION_LEGACY = 1;
+    static const int VERSION_FIXED_POINT = 2;
+    static const int CURRENT_VERSION = VERSION_FIXED_POINT;
+    // Six decimals of coins leave the last two digits of a legacy amount out
+    // of its hash, so only amounts in whole steps of this are pinned down
+    static const Amount LEGACY_AMOUNT_STEP = 100;
+    
+    static bool isKnownVersion(int version);
     
     // Constructor for creating new transactions
-    Transaction(std::string sender, std::string receiver, double amount);
+    Transaction(std::string sender, std::string receiver, Amount amount);
     
     // Constructor for recreating transactions from network/storage
     Transaction(std::string sender, std::string senderPublicKey, std::string receiver, 
-                double amount, std::string hash, std::string signature, unsigned long timestamp);
+                Amount amount, std::string hash, std::string signature, unsigned long timestamp,
+                int version = VERSION_LEGACY);
     
     std::string calculateHash() const;
+    std::string hashPreimage() const; // The bytes calculateHash digests
+    std::string amountEncoding() const; // The amount as it goes into transaction and block hashes
+    bool hasExactAmount() const; // Whether the hash commits to every unit of the amount
+    // Hashes a whole batch at once through the multi-buffer SHA-256 kernel
+    static std::vector<std::string> calculateHashes(const std::vector<const Transaction*>& transactions);
     bool verifySignature() const;
     bool verifyAddress() const; // Verify the public key matches the claimed address
     bool isValid() const;
+    bool isValid(const std::string& expectedHash) const; // With a precomputed calculateHash()
+    // Runs isValid on a batch spread over the shared thread pool. Returns the
+    // index of the first invalid transaction, or transactions.size() if all pass.
+    static size_t findInvalid(const std::vector<const Transaction*>& transactions);
     void print() const;
     void sign(const Wallet& wallet);
 };
 
+// Binary layout of a transaction, shared by storage records and peer
+// messages so the two can't drift apart. decodeTransaction throws
+// std::runtime_error on truncated input.
+void encodeTransaction(BinaryWriter& writer, const Transaction& tx);
+Transaction decodeTransaction(BinaryReader& reader);
+
 #endif 
\ No newline at end of file
@@ -0,0 +1,429 @@
+#include "WireProtocol.h"
+#include <stdexcept>
+#include "sha.h"
+
+namespace {
+
+void writeUint32(std::string& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xff));
+    }
+}
+
+uint32_t readUint32(const char* data) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value = (value << 8) | static_cast<uint8_t>(data[i]);
+    }
+    return value;
+}
+
+void writeNodeType(BinaryWriter& writer, NodeType type) {
+    writer.writeByte(type == NodeType::FULL_NODE ? 0 : 1);
+}
+
+NodeType readNodeType(BinaryReader& reader) {
+    return reader.readByte() == 0 ? NodeType::FULL_NODE : NodeType::WALLET_NODE;
+}
+
+void requireEnd(const BinaryReader& reader, const char* what) {
+    if (!reader.atEnd()) {
+        throw std::runtime_error(std::string("Trailing bytes after ") + what);
+    }
+}
+
+// Element counts can't exceed the bytes left, which bounds what a bad
+// count makes us reserve
+uint64_t readCount(BinaryReader& reader, size_t minElementSize, const char* what) {
+    uint64_t count = reader.readVarint();
+    if (count > reader.remaining() / minElementSize) {
+        throw std::runtime_error(std::string("Invalid ") + what + " count: " + std::to_string(count));
+    }
+    return count;
+}
+
+// Increasing indexes are written as the gap to the previous one
+void writeIndex(BinaryWriter& writer, uint64_t index, uint64_t& next) {
+    writer.writeVarint(index - next);
+    next = index + 1;
+}
+
+uint64_t readIndex(BinaryReader& reader, uint64_t& next) {
+    uint64_t index = next + reader.readVarint();
+    if (index < next) {
+        throw std::runtime_error("Transaction index overflows");
+    }
+    next = index + 1;
+    return index;
+}
+
+} // namespace
+
+std::string encodeFrameHeader(const FrameHeader& header) {
+    std::string out;
+    out.reserve(FRAME_HEADER_SIZE);
+    writeUint32(out, WIRE_MAGIC);
+    out.push_back(static_cast<char>(header.version));
+    out.push_back(static_cast<char>(header.type));
+    writeUint32(out, header.length);
+    writeUint32(out, header.checksum);
+    return out;
+}
+
+FrameHeader decodeFrameHeader(const char* data) {
+    if (readUint32(data) != WIRE_MAGIC) {
+        throw std::runtime_error("Bad frame magic");
+    }
+    FrameHeader header;
+    header.version = static_cast<uint8_t>(data[4]);
+    header.type = static_cast<uint8_t>(data[5]);
+    header.length = readUint32(data + 6);
+    header.checksum = readUint32(data + 10);
+    if (header.length > MAX_FRAME_PAYLOAD) {
+        throw std::runtime_error("Frame payload of " + std::to_string(header.length) + " bytes is too large");
+    }
+    return header;
+}
+
+uint32_t payloadChecksum(const char* data, size_t size) {
+    SHA256Digest digest = computeSHA256Digest(reinterpret_cast<const unsigned char*>(data), size);
+    return readUint32(reinterpret_cast<const char*>(digest.data()));
+}
+
+std::string encodeHandshake(const HandshakePayload& handshake) {
+    BinaryWriter writer;
+    writer.writeByte(handshake.minVersion);
+    writer.writeByte(handshake.maxVersion);
+    writeNodeType(writer, handshake.nodeType);
+    writer.writeVarint(static_cast<uint64_t>(handshake.listenPort));
+    return writer.release();
+}
+
+HandshakePayload decodeHandshake(const std::string& data) {
+    BinaryReader reader(data);
+    HandshakePayload handshake;
+    handshake.minVersion = reader.readByte();
+    handshake.maxVersion = reader.readByte();
+    handshake.nodeType = readNodeType(reader);
+    handshake.listenPort = static_cast<int>(reader.readVarint());
+    // Later versions may append fields
+    return handshake;
+}
+
+std::string encodePeerList(const std::vector<PeerInfo>& peers) {
+    BinaryWriter writer;
+    writer.writeVarint(peers.size());
+    for (const auto& peer : peers) {
+        writer.writeString(peer.address);
+        writer.writeVarint(static_cast<uint64_t>(peer.port));
+        writeNodeType(writer, peer.type);
+        writer.writeString(peer.id);
+    }
+    return writer.release();
+}
+
+std::vector<PeerInfo> decodePeerList(const std::string& data) {
+    BinaryReader reader(data);
+    uint64_t count = reader.readVarint();
+    if (count > reader.remaining()) {
+        throw std::runtime_error("Invalid peer count: " + std::to_string(count));
+    }
+    std::vector<PeerInfo> peers;
+    peers.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+        PeerInfo peer;
+        peer.address = reader.readString();
+        peer.port = static_cast<int>(reader.readVarint());
+        peer.type = readNodeType(reader);
+        peer.id = reader.readString();
+        peers.push_back(std::move(peer));
+    }
+    requireEnd(reader, "peer list");
+    return peers;
+}
+
+std::string encodeTransaction(const Transaction& tx) {
+    BinaryWriter writer;
+    encodeTransaction(writer, tx);
+    return writer.release();
+}
+
+Transaction decodeTransaction(const std::string& data) {
+    BinaryReader reader(data);
+    Transaction tx = decodeTransaction(reader);
+    requireEnd(reader, "transaction");
+    return tx;
+}
+
+void encodeBlock(BinaryWriter& writer, const Block& block) {
+    writer.writeSignedVarint(block.blockNumber);
+    writer.writeSignedVarint(block.timestamp);
+    writer.writeHexString(block.previousHash);
+    writer.writeHexString(block.hash);
+    writer.writeSignedVarint(block.nonce);
+    writer.writeSignedVarint(block.difficulty);
+    writer.writeSignedVarint(block.version);
+    writer.writeVarint(block.transactions.size());
+    for (const auto& tx : block.transactions) {
+        encodeTransaction(writer, tx);
+    }
+}
+
+Block decodeBlock(BinaryReader& reader) {
+    int blockNumber = static_cast<int>(reader.readSignedVarint());
+    time_t timestamp = static_cast<time_t>(reader.readSignedVarint());
+    std::string previousHash = reader.readHexString();
+    std::string hash = reader.readHexString();
+    int nonce = static_cast<int>(reader.readSignedVarint());
+    int difficulty = static_cast<int>(reader.readSignedVarint());
+    int version = static_cast<int>(reader.readSignedVarint());
+
+    uint64_t txCount = reader.readVarint();
+    // Every transaction takes well over one byte
+    if (txCount > reader.remaining()) {
+        throw std::runtime_error("Invalid transaction count: " + std::to_string(txCount));
+    }
+    std::vector<Transaction> transactions;
+    transactions.reserve(txCount);
+    for (uint64_t i = 0; i < txCount; i++) {
+        transactions.push_back(decodeTransaction(reader));
+    }
+    return Block(blockNumber, timestamp, std::move(transactions), previousHash, hash, nonce, difficulty, version);
+}
+
+std::string encodeBlock(const Block& block) {
+    BinaryWriter writer;
+    encodeBlock(writer, block);
+    return writer.release();
+}
+
+Block decodeBlock(const std::string& data) {
+    BinaryReader reader(data);
+    Block block = decodeBlock(reader);
+    requireEnd(reader, "block");
+    return block;
+}
+
+std::vector<Block> decodeBlocks(const std::string& data) {
+    BinaryReader reader(data);
+    uint64_t count = reader.readVarint();
+    if (count > reader.remaining()) {
+        throw std::runtime_error("Invalid block count: " + std::to_string(count));
+    }
+    std::vector<Block> blocks;
+    blocks.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+        blocks.push_back(decodeBlock(reader));
+    }
+    requireEnd(reader, "block list");
+    return blocks;
+}
+
+void encodeBlockHeader(BinaryWriter& writer, const BlockHeader& header) {
+    writer.writeSignedVarint(header.blockNumber);
+    writer.writeSignedVarint(header.timestamp);
+    writer.writeHexString(header.previousHash);
+    writer.writeHexString(header.hash);
+    writer.writeSignedVarint(header.nonce);
+    writer.writeSignedVarint(header.difficulty);
+    writer.writeSignedVarint(header.version);
+    writer.writeVarint(header.transactionCount);
+}
+
+BlockHeader decodeBlockHeader(BinaryReader& reader) {
+    BlockHeader header;
+    header.blockNumber = static_cast<int>(reader.readSignedVarint());
+    header.timestamp = static_cast<time_t>(reader.readSignedVarint());
+    header.previousHash = reader.readHexString();
+    header.hash = reader.readHexString();
+    header.nonce = static_cast<int>(reader.readSignedVarint());
+    header.difficulty = static_cast<int>(reader.readSignedVarint());
+    header.version = static_cast<int>(reader.readSignedVarint());
+    header.transactionCount = static_cast<size_t>(reader.readVarint());
+    return header;
+}
+
+std::string encodeHeaders(const std::vector<BlockHeader>& headers) {
+    BinaryWriter writer;
+    writer.writeVarint(headers.size());
+    for (const auto& header : headers) {
+        encodeBlockHeader(writer, header);
+    }
+    return writer.release();
+}
+
+std::vector<BlockHeader> decodeHeaders(const std::string& data) {
+    BinaryReader reader(data);
+    uint64_t count = reader.readVarint();
+    if (count > reader.remaining()) {
+        throw std::runtime_error("Invalid header count: " + std::to_string(count));
+    }
+    std::vector<BlockHeader> headers;
+    headers.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+        headers.push_back(decodeBlockHeader(reader));
+    }
+    requireEnd(reader, "headers");
+    return headers;
+}
+
+std::string encodeLocator(const std::vector<std::string>& hashes) {
+    BinaryWriter writer;
+    writer.writeVarint(hashes.size());
+    for (const auto& hash : hashes) {
+        writer.writeHexString(hash);
+    }
+    return writer.release();
+}
+
+std::vector<std::string> decodeLocator(const std::string& data) {
+    BinaryReader reader(data);
+    uint64_t count = reader.readVarint();
+    if (count > MAX_LOCATOR_HASHES) {
+        throw std::runtime_error("Block locator with " + std::to_string(count) + " hashes is too long");
+    }
+    std::vector<std::string> hashes;
+    hashes.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+        hashes.push_back(reader.readHexString());
+    }
+    requireEnd(reader, "block locator");
+    return hashes;
+}
+
+std::string encodeBlockRange(const BlockRange& range) {
+    BinaryWriter writer;
+    writer.writeVarint(range.firstBlock);
+    writer.writeVarint(range.count);
+    return writer.release();
+}
+
+BlockRange decodeBlockRange(const std::string& data) {
+    BinaryReader reader(data);
+    BlockRange range;
+    range.firstBlock = reader.readVarint();
+    range.count = reader.readVarint();
+    requireEnd(reader, "block range");
+    return range;
+}
+
+std::string encodeInventory(const std::vector<InventoryItem>& items) {
+    BinaryWriter writer;
+    writer.writeVarint(items.size());
+    for (const auto& item : items) {
+        writer.writeByte(static_cast<uint8_t>(item.type));
+        writer.writeHexString(item.hash);
+    }
+    return writer.release();
+}
+
+std::vector<InventoryItem> decodeInventory(const std::string& data) {
+    BinaryReader reader(data);
+    uint64_t count = reader.readVarint();
+    if (count > MAX_INVENTORY_ITEMS) {
+        throw std::runtime_error("Inventory with " + std::to_string(count) + " items is too large");
+    }
+    std::vector<InventoryItem> items;
+    items.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+        uint8_t type = reader.readByte();
+        if (type != static_cast<uint8_t>(InventoryType::TRANSACTION) && type != static_cast<uint8_t>(InventoryType::BLOCK)) {
+            throw std::runtime_error("Unknown inventory type: " + std::to_string(type));
+        }
+        items.push_back(InventoryItem{static_cast<InventoryType>(type), reader.readHexString()});
+    }
+    requireEnd(reader, "inventory");
+    return items;
+}
+
+std::string encodeCompactBlock(const CompactBlock& compact) {
+    BinaryWriter writer;
+    encodeBlockHeader(writer, compact.header);
+    writer.writeVarint(compact.salt);
+    writer.writeVarint(compact.shortIds.size());
+    for (uint64_t id : compact.shortIds) {
+        for (size_t i = 0; i < SHORT_ID_SIZE; i++) {
+            writer.writeByte(static_cast<uint8_t>(id >> (8 * i)));
+        }
+    }
+    writer.writeVarint(compact.prefilled.size());
+    uint64_t next = 0;
+    for (const auto& prefilled : compact.prefilled) {
+        writeIndex(writer, prefilled.index, next);
+        encodeTransaction(writer, prefilled.tx);
+    }
+    return writer.release();
+}
+
+CompactBlock decodeCompactBlock(const std::string& data) {
+    BinaryReader reader(data);
+    CompactBlock compact;
+    compact.header = decodeBlockHeader(reader);
+    compact.salt = reader.readVarint();
+    uint64_t idCount = readCount(reader, SHORT_ID_SIZE, "short id");
+    compact.shortIds.reserve(idCount);
+    for (uint64_t i = 0; i < idCount; i++) {
+        uint64_t id = 0;
+        for (size_t b = 0; b < SHORT_ID_SIZE; b++) {
+            id |= static_cast<uint64_t>(reader.readByte()) << (8 * b);
+        }
+        compact.shortIds.push_back(id);
+    }
+    uint64_t prefilledCount = readCount(reader, 1, "prefilled transaction");
+    compact.prefilled.reserve(prefilledCount);
+    uint64_t next = 0;
+    for (uint64_t i = 0; i < prefilledCount; i++) {
+        uint64_t index = readIndex(reader, next);
+        compact.prefilled.push_back(PrefilledTransaction{index, decodeTransaction(reader)});
+    }
+    requireEnd(reader, "compact block");
+    return compact;
+}
+
+std::string encodeBlockTransactionsRequest(const BlockTransactionsRequest& request) {
+    BinaryWriter writer;
+    writer.writeHexString(request.blockHash);
+    writer.writeVarint(request.indexes.size());
+    uint64_t next = 0;
+    for (uint64_t index : request.indexes) {
+        writeIndex(writer, index, next);
+    }
+    return writer.release();
+}
+
+BlockTransactionsRequest decodeBlockTransactionsRequest(const std::string& data) {
+    BinaryReader reader(data);
+    BlockTransactionsRequest request;
+    request.blockHash = reader.readHexString();
+    uint64_t count = readCount(reader, 1, "transaction index");
+    request.indexes.reserve(count);
+    uint64_t next = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        request.indexes.push_back(readIndex(reader, next));
+    }
+    requireEnd(reader, "block transactions request");
+    return request;
+}
+
+std::string encodeBlockTransactions(const BlockTransactions& transactions) {
+    BinaryWriter writer;
+    writer.writeHexString(transactions.blockHash);
+    writer.writeVarint(transactions.transactions.size());
+    for (const auto& tx : transactions.transactions) {
+        encodeTransaction(writer, tx);
+    }
+    return writer.release();
+}
+
+BlockTransactions decodeBlockTransactions(const std::string& data) {
+    BinaryReader reader(data);
+    BlockTransactions transactions;
+    transactions.blockHash = reader.readHexString();
+    uint64_t count = readCount(reader, 1, "transaction");
+    transactions.transactions.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+        transactions.transactions.push_back(decodeTransaction(reader));
+    }
+    requireEnd(reader, "block transactions");
+    return transactions;
+}
@@ -0,0 +1,165 @@
+#ifndef WIREPROTOCOL_H
+#define WIREPROTOCOL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "BinaryCodec.h"
+#include "Block.h"
+#include "ChainStore.h"
+#include "Transaction.h"
+#include "Types.h"
+
+// Binary framing and payloads for peer messages.
+//
+// Every message is a fixed 14 byte header followed by the payload:
+//   magic    4 bytes  "CLST"
+//   version  1 byte   protocol version the frame was written with
+//   type     1 byte   MessageType
+//   length   4 bytes  payload size, big-endian
+//   checksum 4 bytes  first 4 bytes of SHA-256(payload)
+// The payload starts with the sender's node id, followed by the body for
+// the message type, written with BinaryWriter.
+
+const uint32_t WIRE_MAGIC = 0x434c5354;
+const size_t FRAME_HEADER_SIZE = 14;
+const uint32_t MAX_FRAME_PAYLOAD = 64 * 1024 * 1024;
+// The payload buffer is sized from an unauthenticated header, so each frame
+// is held to the cap for its type: small until the handshake is done, and
+// MAX_FRAME_PAYLOAD only for bulk sync replies
+const uint32_t MAX_HANDSHAKE_PAYLOAD = 4 * 1024;
+const uint32_t MAX_CONTROL_PAYLOAD = 128 * 1024;   // Requests, pings, inventory, transactions
+const uint32_t MAX_HEADERS_PAYLOAD = 1024 * 1024;  // HEADERS and GET_BLOCK_TXN
+const uint32_t MAX_BLOCK_PAYLOAD = 8 * 1024 * 1024; // One block, compact or in full
+
+// Versions this node speaks. Peers agree on the highest version both
+// support during the handshake; frames before that use the minimum.
+const uint8_t MIN_PROTOCOL_VERSION = 1;
+//   1  whole-chain CHAIN_REQUEST/CHAIN_RESPONSE sync
+//   2  headers-first sync with GET_HEADERS/HEADERS and GET_BLOCKS/BLOCKS
+//   3  transactions and blocks announced by hash with INV/GET_DATA
+//   4  new blocks pushed as CMPCT_BLOCK, missing transactions fetched
+//      with GET_BLOCK_TXN/BLOCK_TXN
+const uint8_t PROTOCOL_VERSION = 4;
+const uint8_t HEADERS_FIRST_VERSION = 2;
+const uint8_t INVENTORY_VERSION = 3;
+const uint8_t COMPACT_BLOCKS_VERSION = 4;
+
+// Longest block locator we accept; locators grow with log2 of the height
+const size_t MAX_LOCATOR_HASHES = 101;
+const size_t MAX_INVENTORY_ITEMS = 1000;  // Fits MAX_CONTROL_PAYLOAD
+// Bytes of a short transaction id in a compact block
+const size_t SHORT_ID_SIZE = 6;
+
+struct FrameHeader {
+    uint8_t version;
+    uint8_t type;
+    uint32_t length;
+    uint32_t checksum;
+};
+
+std::string encodeFrameHeader(const FrameHeader& header);
+// Throws std::runtime_error if the magic is wrong or the payload too large
+FrameHeader decodeFrameHeader(const char* data);
+uint32_t payloadChecksum(const char* data, size_t size);
+
+struct HandshakePayload {
+    uint8_t minVersion;
+    uint8_t maxVersion;
+    NodeType nodeType;
+    int listenPort;
+};
+
+struct PeerInfo {
+    std::string address;
+    int port;
+    NodeType type;
+    std::string id;
+};
+
+// An item announced in INV or asked for in GET_DATA
+enum class InventoryType : uint8_t {
+    TRANSACTION = 1,
+    BLOCK = 2
+};
+
+struct InventoryItem {
+    InventoryType type;
+    std::string hash;
+};
+
+// Blocks wanted in a GET_BLOCKS message, by height
+struct BlockRange {
+    uint64_t firstBlock;
+    uint64_t count;
+};
+
+// A transaction sent in full inside a compact block
+struct PrefilledTransaction {
+    uint64_t index;  // Position in the block
+    Transaction tx;
+};
+
+// A block as its header plus a short id for each transaction, for peers
+// that have most of them in their mempool already
+struct CompactBlock {
+    BlockHeader header;
+    uint64_t salt;                                // Keys the short ids
+    std::vector<uint64_t> shortIds;               // Transactions not prefilled, in block order
+    std::vector<PrefilledTransaction> prefilled;  // By increasing index
+};
+
+// Transactions of a compact block the receiver couldn't find
+struct BlockTransactionsRequest {
+    std::string blockHash;
+    std::vector<uint64_t> indexes;  // Increasing
+};
+
+struct BlockTransactions {
+    std::string blockHash;
+    std::vector<Transaction> transactions;  // In the order they were asked for
+};
+
+// Message bodies. The decoders throw std::runtime_error on malformed input.
+std::string encodeHandshake(const HandshakePayload& handshake);
+HandshakePayload decodeHandshake(const std::string& data);
+
+std::string encodePeerList(const std::vector<PeerInfo>& peers);
+std::vector<PeerInfo> decodePeerList(const std::string& data);
+
+// The writer/reader overloads are declared in Transaction.h
+std::string encodeTransaction(const Transaction& tx);
+Transaction decodeTransaction(const std::string& data);
+
+void encodeBlock(BinaryWriter& writer, const Block& block);
+Block decodeBlock(BinaryReader& reader);
+std::string encodeBlock(const Block& block);
+Block decodeBlock(const std::string& data);
+
+// Varint count followed by that many blocks, as in BLOCKS and CHAIN_RESPONSE
+std::vector<Block> decodeBlocks(const std::string& data);
+
+void encodeBlockHeader(BinaryWriter& writer, const BlockHeader& header);
+BlockHeader decodeBlockHeader(BinaryReader& reader);
+std::string encodeHeaders(const std::vector<BlockHeader>& headers);
+std::vector<BlockHeader> decodeHeaders(const std::string& data);
+
+std::string encodeLocator(const std::vector<std::string>& hashes);
+std::vector<std::string> decodeLocator(const std::string& data);
+
+std::string encodeInventory(const std::vector<InventoryItem>& items);
+std::vector<InventoryItem> decodeInventory(const std::string& data);
+
+std::string encodeCompactBlock(const CompactBlock& compact);
+CompactBlock decodeCompactBlock(const std::string& data);
+
+std::string encodeBlockTransactionsRequest(const BlockTransactionsRequest& request);
+BlockTransactionsRequest decodeBlockTransactionsRequest(const std::string& data);
+
+std::string encodeBlockTransactions(const BlockTransactions& transactions);
+BlockTransactions decodeBlockTransactions(const std::string& data);
+
+std::string encodeBlockRange(const BlockRange& range);
+BlockRange decodeBlockRange(const std::string& data);
+
+#endif // WIREPROTOCOL_H
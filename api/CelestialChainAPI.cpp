@@ -123,7 +123,7 @@ void CelestialChainAPI::setupEndpoints() {
                 ss << "      \"hash\": \"" << tx.hash << "\",\n";
                 ss << "      \"sender\": \"" << tx.sender << "\",\n";
                 ss << "      \"receiver\": \"" << tx.receiver << "\",\n";
-                ss << "      \"amount\": " << tx.amount << "\n";
+                ss << "      \"amount\": " << formatAmount(tx.amount) << "\n";
                 ss << "    }";
                 if (i < mempool.size() - 1) ss << ",";
                 ss << "\n";
@@ -156,7 +156,7 @@ void CelestialChainAPI::setupEndpoints() {
         crow::response res;
         try {
             std::vector<Wallet*> wallets = { &wallet };
-            Block& minedBlock = blockchain.mineBlock(wallets, nodeType);
+            const Block& minedBlock = blockchain.mineBlock(wallets, nodeType);
             networkManager.broadcastBlock(minedBlock);
             
             std::stringstream ss;
@@ -201,7 +201,7 @@ void CelestialChainAPI::setupEndpoints() {
             }
             
             std::string receiver = json["receiver"].s();
-            double amount = json["amount"].d();
+            Amount amount = amountFromCoins(json["amount"].d());
             
             Transaction tx("", "", 0);
             wallet.sendMoney(amount, receiver, tx);
@@ -214,7 +214,7 @@ void CelestialChainAPI::setupEndpoints() {
             ss << "  \"hash\": \"" << tx.hash << "\",\n";
             ss << "  \"sender\": \"" << tx.sender << "\",\n";
             ss << "  \"receiver\": \"" << tx.receiver << "\",\n";
-            ss << "  \"amount\": " << tx.amount << "\n";
+            ss << "  \"amount\": " << formatAmount(tx.amount) << "\n";
             ss << "}";
             
             res.body = ss.str();
@@ -235,7 +235,7 @@ void CelestialChainAPI::setupEndpoints() {
             std::stringstream ss;
             ss << "{\n";
             ss << "  \"address\": \"" << wallet.getAddress() << "\",\n";
-            ss << "  \"balance\": " << wallet.getBalance() << "\n";
+            ss << "  \"balance\": " << formatAmount(wallet.getBalance()) << "\n";
             ss << "}";
             
             res.body = ss.str();
@@ -353,8 +353,8 @@ void CelestialChainAPI::setupEndpoints() {
             
             if (dbPtr && balanceMapPtr) {
                 Explorer explorer(&blockchain, dbPtr, balanceMapPtr);
-                double totalSupply = blockchain.getTotalSupply();
-                double currentReward = blockchain.getCurrentMiningReward();
+                Amount totalSupply = blockchain.getTotalSupply();
+                Amount currentReward = blockchain.getCurrentMiningReward();
                 size_t blockCount = explorer.getBlockCount();
                 size_t txCount = explorer.getTransactionCount();
                 
@@ -369,8 +369,8 @@ void CelestialChainAPI::setupEndpoints() {
                 ss << "  \"blockCount\": " << blockCount << ",\n";
                 ss << "  \"transactionCount\": " << txCount << ",\n";
                 ss << "  \"uniqueAddresses\": " << balanceMapPtr->getAllBalances().size() << ",\n";
-                ss << "  \"totalSupply\": " << totalSupply << ",\n";
-                ss << "  \"currentReward\": " << currentReward << ",\n";
+                ss << "  \"totalSupply\": " << formatAmount(totalSupply) << ",\n";
+                ss << "  \"currentReward\": " << formatAmount(currentReward) << ",\n";
                 ss << "  \"halving\": {\n";
                 ss << "    \"halvingsOccurred\": " << numberOfHalvings << ",\n";
                 ss << "    \"daysUntilNextHalving\": " << daysUntilNextHalving << "\n";
@@ -404,7 +404,8 @@ void CelestialChainAPI::setupEndpoints() {
                 return res;
             }
             
-            const Block& block = blockchain.getBlock(blockIndex);
+            auto blockPtr = blockchain.getBlock(blockIndex);
+            const Block& block = *blockPtr;
             
             std::stringstream ss;
             ss << "{\n";
@@ -423,7 +424,7 @@ void CelestialChainAPI::setupEndpoints() {
                 ss << "      \"hash\": \"" << tx.hash << "\",\n";
                 ss << "      \"sender\": \"" << tx.sender << "\",\n";
                 ss << "      \"receiver\": \"" << tx.receiver << "\",\n";
-                ss << "      \"amount\": " << tx.amount << "\n";
+                ss << "      \"amount\": " << formatAmount(tx.amount) << "\n";
                 ss << "    }";
                 if (i < block.transactions.size() - 1) ss << ",";
                 ss << "\n";
@@ -454,13 +455,13 @@ void CelestialChainAPI::setupEndpoints() {
                 return res;
             }
             
-            double balance = 0.0;
+            Amount balance = 0;
             balanceMapPtr->getBalance(address, balance);
             
             std::stringstream ss;
             ss << "{\n";
             ss << "  \"address\": \"" << address << "\",\n";
-            ss << "  \"balance\": " << balance << "\n";
+            ss << "  \"balance\": " << formatAmount(balance) << "\n";
             ss << "}";
             
             res.body = ss.str();
@@ -555,37 +556,35 @@ void CelestialChainAPI::setupEndpoints() {
             ss << "{\n";
             
             // Check mempool first
-            for (const auto& tx : blockchain.getMempool()) {
-                if (tx.hash == txHash) {
-                    ss << "  \"hash\": \"" << tx.hash << "\",\n";
-                    ss << "  \"sender\": \"" << tx.sender << "\",\n";
-                    ss << "  \"receiver\": \"" << tx.receiver << "\",\n";
-                    ss << "  \"amount\": " << tx.amount << ",\n";
-                    ss << "  \"status\": \"Pending\",\n";
-                    ss << "  \"blockNumber\": null\n";
-                    found = true;
-                    break;
-                }
+            if (const Transaction* pending = blockchain.findMempoolTransaction(txHash)) {
+                const auto& tx = *pending;
+                ss << "  \"hash\": \"" << tx.hash << "\",\n";
+                ss << "  \"sender\": \"" << tx.sender << "\",\n";
+                ss << "  \"receiver\": \"" << tx.receiver << "\",\n";
+                ss << "  \"amount\": " << formatAmount(tx.amount) << ",\n";
+                ss << "  \"status\": \"Pending\",\n";
+                ss << "  \"blockNumber\": null\n";
+                found = true;
             }
             
-            // Then check the blockchain
+            // Then check the blockchain in one ordered scan, which reads
+            // stored blocks in batches without churning the block window
             if (!found) {
-                for (size_t i = 0; i < blockchain.getChainSize(); i++) {
-                    const Block& block = blockchain.getBlock(i);
+                blockchain.getChainStore().forEach(0, [&](const Block& block) {
                     for (const auto& tx : block.transactions) {
                         if (tx.hash == txHash) {
                             ss << "  \"hash\": \"" << tx.hash << "\",\n";
                             ss << "  \"sender\": \"" << tx.sender << "\",\n";
                             ss << "  \"receiver\": \"" << tx.receiver << "\",\n";
-                            ss << "  \"amount\": " << tx.amount << ",\n";
+                            ss << "  \"amount\": " << formatAmount(tx.amount) << ",\n";
                             ss << "  \"status\": \"Confirmed\",\n";
                             ss << "  \"blockNumber\": " << block.blockNumber << "\n";
                             found = true;
                             break;
                         }
                     }
-                    if (found) break;
-                }
+                    return !found;
+                });
             }
             
             ss << "}";
@@ -630,7 +629,7 @@ void CelestialChainAPI::setupEndpoints() {
             if (balanceMapPtr) {
                 auto balances = balanceMapPtr->getAllBalances();
                 // Convert to vector for sorting
-                std::vector<std::pair<std::string, double>> balanceList(balances.begin(), balances.end());
+                std::vector<std::pair<std::string, Amount>> balanceList(balances.begin(), balances.end());
                 // Sort by balance (highest first)
                 std::sort(balanceList.begin(), balanceList.end(), 
                     [](const auto& a, const auto& b) { return a.second > b.second; });
@@ -643,7 +642,7 @@ void CelestialChainAPI::setupEndpoints() {
                 for (size_t i = 0; i < count; i++) {
                     ss << "    {\n";
                     ss << "      \"address\": \"" << balanceList[i].first << "\",\n";
-                    ss << "      \"balance\": " << balanceList[i].second << "\n";
+                    ss << "      \"balance\": " << formatAmount(balanceList[i].second) << "\n";
                     ss << "    }";
                     if (i < count - 1) ss << ",";
                     ss << "\n";
@@ -696,12 +695,27 @@ void CelestialChainAPI::setupEndpoints() {
                 transactions.push_back({tx, {0, true}});
             }
             
-            // Add confirmed transactions from blocks (newest first)
+            // Add confirmed transactions from blocks (newest first). The
+            // headers tell how far back `limit` transactions go, so only
+            // those blocks are read, oldest first in one ordered scan.
+            size_t chainSize = blockchain.getChainSize();
+            size_t firstBlock = chainSize;
+            size_t available = 0;
+            while (firstBlock > 0 && available < static_cast<size_t>(limit)) {
+                firstBlock--;
+                available += blockchain.getBlockHeader(firstBlock).transactionCount;
+            }
+            std::vector<Block> recentBlocks;
+            if (firstBlock < chainSize) {
+                blockchain.getChainStore().forEach(firstBlock, [&](const Block& block) {
+                    recentBlocks.push_back(block);
+                    return true;
+                });
+            }
             size_t txCollected = 0;
-            for (int i = blockchain.getChainSize() - 1; i >= 0 && txCollected < limit; i--) {
-                const Block& block = blockchain.getBlock(i);
-                for (const auto& tx : block.transactions) {
-                    transactions.push_back({tx, {block.blockNumber, false}});
+            for (auto block = recentBlocks.rbegin(); block != recentBlocks.rend() && txCollected < limit; ++block) {
+                for (const auto& tx : block->transactions) {
+                    transactions.push_back({tx, {block->blockNumber, false}});
                     txCollected++;
                     if (txCollected >= limit) break;
                 }
@@ -722,7 +736,7 @@ void CelestialChainAPI::setupEndpoints() {
                 ss << "      \"hash\": \"" << tx.hash << "\",\n";
                 ss << "      \"sender\": \"" << tx.sender << "\",\n";
                 ss << "      \"receiver\": \"" << tx.receiver << "\",\n";
-                ss << "      \"amount\": " << tx.amount << ",\n";
+                ss << "      \"amount\": " << formatAmount(tx.amount) << ",\n";
                 ss << "      \"status\": \"" << (isPending ? "Pending" : "Confirmed") << "\"";
                 
                 if (!isPending) {
@@ -777,7 +791,8 @@ void CelestialChainAPI::setupEndpoints() {
             // Start from the newest block and go backwards
             for (size_t i = 0; i < count; i++) {
                 size_t blockIndex = chainSize - 1 - i;
-                const Block& block = blockchain.getBlock(blockIndex);
+                // The listing only needs headers, so nothing is paged in
+                const BlockHeader& block = blockchain.getBlockHeader(blockIndex);
                 
                 ss << "    {\n";
                 ss << "      \"blockNumber\": " << block.blockNumber << ",\n";
@@ -786,7 +801,7 @@ void CelestialChainAPI::setupEndpoints() {
                 ss << "      \"timestamp\": " << block.timestamp << ",\n";
                 ss << "      \"nonce\": " << block.nonce << ",\n";
                 ss << "      \"difficulty\": " << block.difficulty << ",\n";
-                ss << "      \"transactionCount\": " << block.transactions.size() << "\n";
+                ss << "      \"transactionCount\": " << block.transactionCount << "\n";
                 ss << "    }";
                 if (i < count - 1) ss << ",";
                 ss << "\n";
@@ -7,156 +7,145 @@ BalanceMapping::BalanceMapping(BlockchainDB* database) : db(database) {
     }
 }
 
-bool BalanceMapping::updateBalance(const std::string& address, double newBalance) {
+bool BalanceMapping::getBalance(const std::string& address, Amount& balance) const {
     if (!db) return false;
     
-    std::string key = "balance:" + address;
-    return db->put(key, std::to_string(newBalance));
-}
-
-bool BalanceMapping::getBalance(const std::string& address, double& balance) const {
-    if (!db) return false;
+    if (cache.lookup(address, balance)) {
+        return true;
+    }
     
     std::string key = "balance:" + address;
     std::string value;
     
     if (!db->get(key, value)) {
         // Not finding a balance isn't an error - it's a new address
-        balance = 0.0;
+        balance = 0;
+        cache.fill(address, balance);
         return true;
     }
     
-    try {
-        balance = std::stod(value);
-        return true;
-    } catch (const std::exception& e) {
-        std::cerr << "Error parsing balance: " << e.what() << std::endl;
+    if (!parseAmount(value, balance)) {
+        std::cerr << "Error parsing balance: " << value << std::endl;
         return false;
     }
+    cache.fill(address, balance);
+    return true;
 }
 
-bool BalanceMapping::processTransaction(const std::string& sender, const std::string& receiver, double amount) {
+bool BalanceMapping::applyBlock(const Block& block, BlockStateChanges& changes, int& applied, bool recordJournal) const {
+    applied = 0;
     if (!db) {
-        std::cerr << "ERROR: Database not available for processing transaction" << std::endl;
-        return false;
-    }
-    
-    // Special case: Skip the Genesis block's genesis transaction
-    if (sender == "Genesis" && receiver == "Genesis") {
-        std::cout << "Skipping Genesis-to-Genesis transaction" << std::endl;
-        return true;  // Consider it processed successfully, but we don't change any balances
-    }
-    
-    // Handle mining rewards (Genesis sender)
-    if (sender == "Genesis") {
-        std::cout << "Processing mining reward of " << amount << " to " << receiver << std::endl;
-        return processCoinGeneration(receiver, amount);
-    }
-    
-    // Get sender balance
-    double senderBalance = 0.0;
-    if (!getBalance(sender, senderBalance)) {
-        std::cerr << "ERROR: Failed to retrieve sender balance" << std::endl;
+        std::cerr << "ERROR: Database not available for applying block" << std::endl;
         return false;
     }
     
-    // Verify sender has enough funds
-    if (senderBalance < amount) {
-        std::cerr << "Insufficient funds: " << sender << " has " << senderBalance 
-                  << " $CLST but attempted to send " << amount << " $CLST" << std::endl;
-        return false;
-    }
-    
-    // Get receiver balance
-    double receiverBalance = 0.0;
-    if (!getBalance(receiver, receiverBalance)) {
-        std::cerr << "ERROR: Failed to retrieve receiver balance" << std::endl;
-        return false;
-    }
-    
-    // Calculate new balances
-    double newSenderBalance = senderBalance - amount;
-    double newReceiverBalance = receiverBalance + amount;
-    
-    // Create a batch update to ensure atomicity
-    std::vector<std::pair<std::string, std::string>> operations;
-    
-    // Update sender balance
-    operations.push_back(std::make_pair(
-        "balance:" + sender, 
-        std::to_string(newSenderBalance)
-    ));
-    
-    // Update receiver balance
-    operations.push_back(std::make_pair(
-        "balance:" + receiver, 
-        std::to_string(newReceiverBalance)
-    ));
-    
-    // Execute the batch update
-    bool success = db->writeBatch(operations);
-    
-    if (success) {
-        std::cout << "Transaction processed successfully:" << std::endl;
-        std::cout << "- " << sender << ": " << senderBalance << " $CLST -> " << newSenderBalance << " $CLST" << std::endl;
-        std::cout << "- " << receiver << ": " << receiverBalance << " $CLST -> " << newReceiverBalance << " $CLST" << std::endl;
-    } else {
-        std::cerr << "ERROR: Failed to write transaction to database" << std::endl;
+    // Working balance of an address: what this block (or an earlier one in
+    // the same changes) left behind, else what's on disk
+    auto balanceOf = [&](const std::string& address) -> Amount* {
+        auto it = changes.balances.find(address);
+        if (it == changes.balances.end()) {
+            Amount stored = 0;
+            if (!getBalance(address, stored)) {
+                return nullptr;
+            }
+            it = changes.balances.emplace(address, stored).first;
+            changes.previousBalances.emplace(address, stored);
+        }
+        return &it->second;
+    };
+    
+    auto journal = [&](const std::string& address, const Transaction& tx, bool isCredit) {
+        if (!recordJournal) return;
+        BalanceJournalEntry entry;
+        entry.address = address;
+        entry.txHash = tx.hash;
+        entry.amount = tx.amount;
+        entry.isCredit = isCredit;
+        entry.blockHeight = block.blockNumber;
+        entry.timestamp = block.timestamp;
+        changes.journal.push_back(std::move(entry));
+    };
+    
+    bool allApplied = true;
+    for (const auto& tx : block.transactions) {
+        // Genesis-to-Genesis moves nothing
+        if (tx.sender == "Genesis" && tx.receiver == "Genesis") {
+            continue;
+        }
+        
+        // Mining rewards only credit the receiver
+        if (tx.sender == "Genesis") {
+            Amount* receiverBalance = balanceOf(tx.receiver);
+            if (!receiverBalance) {
+                std::cerr << "ERROR: Failed to retrieve receiver balance for coin generation" << std::endl;
+                allApplied = false;
+                continue;
+            }
+            *receiverBalance += tx.amount;
+            journal(tx.receiver, tx, true);
+            applied++;
+            continue;
+        }
+        
+        Amount* senderBalance = balanceOf(tx.sender);
+        if (!senderBalance) {
+            std::cerr << "ERROR: Failed to retrieve sender balance" << std::endl;
+            allApplied = false;
+            continue;
+        }
+        if (*senderBalance < tx.amount) {
+            std::cerr << "Insufficient funds: " << tx.sender << " has " << formatAmount(*senderBalance) 
+                      << " $CLST but attempted to send " << formatAmount(tx.amount) << " $CLST" << std::endl;
+            allApplied = false;
+            continue;
+        }
+        *senderBalance -= tx.amount;
+        
+        // Map nodes don't move, so senderBalance stays valid here
+        Amount* receiverBalance = balanceOf(tx.receiver);
+        if (!receiverBalance) {
+            std::cerr << "ERROR: Failed to retrieve receiver balance" << std::endl;
+            *senderBalance += tx.amount;
+            allApplied = false;
+            continue;
+        }
+        *receiverBalance += tx.amount;
+        
+        // A self-transfer nets out, and both entries would share one key
+        if (tx.sender != tx.receiver) {
+            journal(tx.sender, tx, false);
+            journal(tx.receiver, tx, true);
+        }
+        applied++;
     }
     
-    return success;
+    return allApplied;
 }
 
-bool BalanceMapping::processCoinGeneration(const std::string& receiver, double amount) {
-    if (!db) {
-        std::cerr << "ERROR: Database not available for processing coin generation" << std::endl;
-        return false;
-    }
+bool BalanceMapping::commitBalances(const std::map<std::string, Amount>& balances) {
+    if (!db) return false;
     
-    // For coin generation, we only need to credit the receiver
-    double receiverBalance = 0.0;
-    if (!getBalance(receiver, receiverBalance)) {
-        std::cerr << "ERROR: Failed to retrieve receiver balance for coin generation" << std::endl;
-        return false;
+    std::vector<std::pair<std::string, std::string>> operations;
+    operations.reserve(balances.size());
+    for (const auto& [address, balance] : balances) {
+        operations.emplace_back("balance:" + address, formatAmount(balance));
     }
-    
-    // Calculate new balance
-    double newBalance = receiverBalance + amount;
-    
-    // Update receiver balance
-    bool success = updateBalance(receiver, newBalance);
-    
-    if (success) {
-        std::cout << "Mining reward processed:" << std::endl;
-        std::cout << "- " << receiver << ": " << receiverBalance << " $CLST -> " << newBalance << " $CLST" << std::endl;
-    } else {
-        std::cerr << "ERROR: Failed to update balance for mining reward" << std::endl;
+    if (!db->writeBatch(operations)) {
+        return false;
     }
-    
-    return success;
+    cache.markCommitted(balances);
+    return true;
 }
 
-std::map<std::string, double> BalanceMapping::getAllBalances() const {
-    std::map<std::string, double> balances;
-    if (!db) return balances;
-    
-    std::string prefix = "balance:";
-    auto keys = db->getAllKeys(prefix);
-    
-    for (const auto& key : keys) {
-        std::string value;
-        if (db->get(key, value)) {
-            std::string address = key.substr(prefix.length());
-            try {
-                double balance = std::stod(value);
-                balances[address] = balance;
-            } catch (const std::exception& e) {
-                // Skip invalid balance values
-            }
-        }
-    }
-    
-    return balances;
+void BalanceMapping::markCommitted(const std::map<std::string, Amount>& balances) {
+    cache.markCommitted(balances);
 }
 
+void BalanceMapping::clearCache() {
+    cache.clear();
+}
 
+std::map<std::string, Amount> BalanceMapping::getAllBalances() const {
+    if (!db) return {};
+    return db->getAllBalances();
+}
@@ -4,27 +4,41 @@
 #include <string>
 #include <map>
 #include "BlockchainDB.h"
+#include "BalanceCache.h"
 
 class BalanceMapping {
 private:
     BlockchainDB* db; // Database connection
+    mutable BalanceCache cache; // Read-through; updated as blocks commit
 
 public:
     // Constructor takes a connection to the database
     BalanceMapping(BlockchainDB* database);
     
-    // Core balance operations
-    bool updateBalance(const std::string& address, double newBalance);
-    bool getBalance(const std::string& address, double& balance) const;
+    // Reads go through the cache. Balances only change by committing a
+    // block's changes, which keeps every write paired with its undo data.
+    bool getBalance(const std::string& address, Amount& balance) const;
     
-    // Process a transaction by updating sender and receiver balances
-    bool processTransaction(const std::string& sender, const std::string& receiver, double amount);
+    // Apply a block's transactions to the balances in changes: mining rewards
+    // credit the receiver, transfers need the sender to cover them. Each address is read from the database at
+    // most once; later transactions see earlier ones through changes.balances,
+    // and the value read goes into changes.previousBalances.
+    // Rejected transactions are skipped and the rest still applied, as replays
+    // of stored history need; applied counts the ones that went through.
+    // Returns false if any transaction was rejected.
+    bool applyBlock(const Block& block, BlockStateChanges& changes, int& applied, bool recordJournal = true) const;
     
-    // Special method for genesis/coin generation transactions
-    bool processCoinGeneration(const std::string& receiver, double amount);
+    // Write a set of final balances in one batch
+    bool commitBalances(const std::map<std::string, Amount>& balances);
     
-    // Get all balances for reporting/display
-    std::map<std::string, double> getAllBalances() const;
+    // Record that a commit reached the disk
+    void markCommitted(const std::map<std::string, Amount>& balances);
+    void clearCache();
+    const BalanceCache& getCache() const { return cache; }
+    
+    // Consistent snapshot of all balances as of the last block commit, for
+    // reporting/display
+    std::map<std::string, Amount> getAllBalances() const;
 };
 
 #endif
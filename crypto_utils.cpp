@@ -166,23 +166,12 @@ std::string signMessage(const EC_KEY* key, const std::string& message) {
 bool verifySignature(const std::string& message, 
                     const std::string& signature,
                     const std::string& publicKeyOrAddress) {
-    std::cout << "DEBUG - verifySignature called with:" << std::endl;
-    std::cout << "  Message: " << message << std::endl;
-    std::cout << "  Signature: " << (signature.length() > 20 ? signature.substr(0, 20) + "..." : signature) << std::endl;
-    std::cout << "  Public Key/Address: " << publicKeyOrAddress << std::endl;
-    
     // Check if the input is empty
     if (signature.empty()) {
         std::cerr << "ERROR: Empty signature provided" << std::endl;
         return false;
     }
     
-    // Strip 0x prefix from signature if present
-    std::string sigNoPrefix = signature;
-    if (sigNoPrefix.substr(0, 2) == "0x") {
-        sigNoPrefix = sigNoPrefix.substr(2);
-    }
-    
     // Check what kind of input we have - public key or address
     bool isPublicKey = false;
     bool isAddress = false;
@@ -216,88 +205,172 @@ bool verifySignature(const std::string& message,
     
     // If we have a public key, do the real verification
     if (isPublicKey) {
-        // Strip 0x prefix from public key if present
-        std::string pubKeyNoPrefix = publicKeyOrAddress;
-        if (pubKeyNoPrefix.substr(0, 2) == "0x") {
-            pubKeyNoPrefix = pubKeyNoPrefix.substr(2);
-        }
-        
-        // Create EC_KEY from public key hex
-        EC_KEY* key = EC_KEY_new_by_curve_name(NID_secp256k1);
-        if (!key) {
-            std::cerr << "ERROR: Failed to create EC_KEY" << std::endl;
-            return false;
-        }
-        
-        // Convert hex public key to EC_POINT
-        EC_GROUP* group = EC_GROUP_new_by_curve_name(NID_secp256k1);
-        if (!group) {
-            std::cerr << "ERROR: Failed to create EC_GROUP" << std::endl;
-            EC_KEY_free(key);
-            return false;
+        return SignatureVerifier::shared().verify(message, signature, publicKeyOrAddress);
+    }
+    
+    // We should never reach this point given the conditions above
+    return false;
+}
+
+namespace {
+
+// Value of each hex digit, -1 for anything else
+struct HexTable {
+    signed char values[256];
+    HexTable() {
+        for (int i = 0; i < 256; i++) {
+            values[i] = -1;
         }
-        
-        EC_POINT* pub_point = EC_POINT_hex2point(group, pubKeyNoPrefix.c_str(), nullptr, nullptr);
-        if (!pub_point) {
-            std::cerr << "ERROR: Failed to convert hex to EC_POINT: " << pubKeyNoPrefix.substr(0, 20) << "..." << std::endl;
-            EC_KEY_free(key);
-            EC_GROUP_free(group);
-            return false;
+        for (int i = 0; i < 10; i++) {
+            values['0' + i] = static_cast<signed char>(i);
         }
-        
-        if (!EC_KEY_set_public_key(key, pub_point)) {
-            std::cerr << "ERROR: Failed to set public key" << std::endl;
-            EC_POINT_free(pub_point);
-            EC_KEY_free(key);
-            EC_GROUP_free(group);
-            return false;
+        for (int i = 0; i < 6; i++) {
+            values['a' + i] = static_cast<signed char>(10 + i);
+            values['A' + i] = static_cast<signed char>(10 + i);
         }
-        
-        // Hash the message
-        unsigned char hash[SHA256_DIGEST_LENGTH];
-        SHA256_CTX sha256;
-        SHA256_Init(&sha256);
-        SHA256_Update(&sha256, message.c_str(), message.length());
-        SHA256_Final(hash, &sha256);
-        
-        // Convert hex signature to DER format
-        std::vector<unsigned char> der;
-        for (size_t i = 0; i < sigNoPrefix.length(); i += 2) {
-            unsigned int byte;
-            std::stringstream ss;
-            ss << std::hex << sigNoPrefix.substr(i, 2);
-            ss >> byte;
-            der.push_back(static_cast<unsigned char>(byte));
-        }
-        
-        // Convert DER to ECDSA_SIG
-        const unsigned char* der_ptr = der.data();
-        ECDSA_SIG* sig = d2i_ECDSA_SIG(nullptr, &der_ptr, der.size());
-        if (!sig) {
-            std::cerr << "ERROR: Failed to parse DER signature" << std::endl;
-            EC_POINT_free(pub_point);
-            EC_KEY_free(key);
-            EC_GROUP_free(group);
+    }
+};
+
+const HexTable hexTable;
+
+} // namespace
+
+bool decodeHex(const std::string& hex, std::vector<unsigned char>& out) {
+    size_t start = (hex.compare(0, 2, "0x") == 0) ? 2 : 0;
+    size_t length = hex.size() - start;
+    if (length % 2 != 0) {
+        return false;
+    }
+    
+    out.resize(length / 2);
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(hex.data()) + start;
+    for (size_t i = 0; i < out.size(); i++) {
+        int high = hexTable.values[in[2 * i]];
+        int low = hexTable.values[in[2 * i + 1]];
+        if (high < 0 || low < 0) {
             return false;
         }
-        
-        // Verify the signature
-        int result = ECDSA_do_verify(hash, SHA256_DIGEST_LENGTH, sig, key);
-        
-        // Debug output
-        std::cout << "Signature verification result: " << result << " (1=success, 0=failure, -1=error)" << std::endl;
-        
-        // Cleanup
-        ECDSA_SIG_free(sig);
-        EC_POINT_free(pub_point);
+        out[i] = static_cast<unsigned char>((high << 4) | low);
+    }
+    return true;
+}
+
+SignatureVerifier::SignatureVerifier(size_t keyCacheCapacity)
+    : group(EC_GROUP_new_by_curve_name(NID_secp256k1)), capacity(keyCacheCapacity) {
+    if (!group) {
+        std::cerr << "ERROR: Failed to create EC_GROUP" << std::endl;
+    }
+}
+
+SignatureVerifier::~SignatureVerifier() {
+    EC_GROUP_free(group);
+}
+
+SignatureVerifier& SignatureVerifier::shared() {
+    static SignatureVerifier verifier;
+    return verifier;
+}
+
+size_t SignatureVerifier::cachedKeyCount() const {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return keys.size();
+}
+
+EC_KEY* SignatureVerifier::parsePublicKey(const std::string& publicKeyHex) const {
+    EC_POINT* point = EC_POINT_new(group);
+    if (!point) {
+        return nullptr;
+    }
+    
+    // Decode straight to the octet form; anything that isn't a clean byte
+    // string goes through OpenSSL's own hex parser as before
+    std::vector<unsigned char> octets;
+    bool parsed = decodeHex(publicKeyHex, octets) &&
+                  EC_POINT_oct2point(group, point, octets.data(), octets.size(), nullptr) == 1;
+    if (!parsed) {
+        std::string hexNoPrefix = publicKeyHex.compare(0, 2, "0x") == 0 ? publicKeyHex.substr(2) : publicKeyHex;
+        parsed = EC_POINT_hex2point(group, hexNoPrefix.c_str(), point, nullptr) != nullptr;
+    }
+    if (!parsed) {
+        std::cerr << "ERROR: Failed to convert hex to EC_POINT: " << publicKeyHex.substr(0, 20) << "..." << std::endl;
+        EC_POINT_free(point);
+        return nullptr;
+    }
+    
+    EC_KEY* key = EC_KEY_new();
+    if (!key || !EC_KEY_set_group(key, group) || !EC_KEY_set_public_key(key, point)) {
+        std::cerr << "ERROR: Failed to set public key" << std::endl;
         EC_KEY_free(key);
-        EC_GROUP_free(group);
-        
-        return result == 1;
+        EC_POINT_free(point);
+        return nullptr;
     }
     
-    // We should never reach this point given the conditions above
-    return false;
+    EC_POINT_free(point);
+    return key;
+}
+
+std::shared_ptr<EC_KEY> SignatureVerifier::publicKey(const std::string& publicKeyHex) {
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto found = keyIndex.find(publicKeyHex);
+        if (found != keyIndex.end()) {
+            keys.splice(keys.begin(), keys, found->second);
+            return found->second->second;
+        }
+    }
+    
+    // Parse outside the lock; two threads racing on the same new key both
+    // parse it and the second insert is dropped
+    EC_KEY* parsed = parsePublicKey(publicKeyHex);
+    if (!parsed) {
+        return nullptr;
+    }
+    std::shared_ptr<EC_KEY> key(parsed, EC_KEY_free);
+    
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (capacity == 0 || keyIndex.count(publicKeyHex)) {
+        return key;
+    }
+    keys.emplace_front(publicKeyHex, key);
+    keyIndex[publicKeyHex] = keys.begin();
+    if (keys.size() > capacity) {
+        keyIndex.erase(keys.back().first);
+        keys.pop_back();
+    }
+    return key;
+}
+
+bool SignatureVerifier::verify(const std::string& message, const std::string& signature, const std::string& publicKeyHex) {
+    if (!group) {
+        return false;
+    }
+    
+    std::shared_ptr<EC_KEY> key = publicKey(publicKeyHex);
+    if (!key) {
+        return false;
+    }
+    
+    // Convert hex signature to DER format
+    std::vector<unsigned char> der;
+    if (!decodeHex(signature, der)) {
+        std::cerr << "ERROR: Signature is not valid hex" << std::endl;
+        return false;
+    }
+    
+    // Convert DER to ECDSA_SIG
+    const unsigned char* derPtr = der.data();
+    ECDSA_SIG* sig = d2i_ECDSA_SIG(nullptr, &derPtr, der.size());
+    if (!sig) {
+        std::cerr << "ERROR: Failed to parse DER signature" << std::endl;
+        return false;
+    }
+    
+    // Hash the message and verify
+    SHA256Digest hash = computeSHA256Digest(message);
+    int result = ECDSA_do_verify(hash.data(), static_cast<int>(hash.size()), sig, key.get());
+    ECDSA_SIG_free(sig);
+    
+    return result == 1;
 }
 
 std::string bytesToHex(const unsigned char* data, size_t length) {
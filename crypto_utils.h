@@ -3,6 +3,10 @@
 
 #include <string>
 #include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <openssl/ec.h>
 #include <openssl/ecdsa.h>
 #include <openssl/obj_mac.h>
@@ -34,6 +38,44 @@ bool verifySignature(const std::string& message,
                     const std::string& signature,
                     const std::string& publicKeyHex);
 
+// Verifies ECDSA signatures over secp256k1 while keeping the expensive
+// setup around between calls: one curve group for the process and an LRU
+// cache of parsed public keys keyed by the hex string they came from.
+// Safe to use from several threads at once.
+class SignatureVerifier {
+public:
+    explicit SignatureVerifier(size_t keyCacheCapacity = DEFAULT_KEY_CACHE_SIZE);
+    ~SignatureVerifier();
+
+    SignatureVerifier(const SignatureVerifier&) = delete;
+    SignatureVerifier& operator=(const SignatureVerifier&) = delete;
+
+    // publicKeyHex is an uncompressed 0x04... key; signature is 0x-prefixed DER hex
+    bool verify(const std::string& message, const std::string& signature, const std::string& publicKeyHex);
+
+    size_t cachedKeyCount() const;
+
+    // Instance used by verifySignature
+    static SignatureVerifier& shared();
+
+    static const size_t DEFAULT_KEY_CACHE_SIZE = 4096;
+
+private:
+    std::shared_ptr<EC_KEY> publicKey(const std::string& publicKeyHex);
+    EC_KEY* parsePublicKey(const std::string& publicKeyHex) const;
+
+    EC_GROUP* group;
+    size_t capacity;
+    mutable std::mutex cacheMutex;
+    // Most recently used key at the front
+    std::list<std::pair<std::string, std::shared_ptr<EC_KEY>>> keys;
+    std::unordered_map<std::string, std::list<std::pair<std::string, std::shared_ptr<EC_KEY>>>::iterator> keyIndex;
+};
+
+// Table driven hex decoding; an optional 0x prefix is skipped. Returns false
+// on odd length or a non-hex character.
+bool decodeHex(const std::string& hex, std::vector<unsigned char>& out);
+
 // Hex conversion utilities
 std::string bytesToHex(const unsigned char* data, size_t length);
 std::vector<unsigned char> hexToBytes(const std::string& hex);
@@ -2,9 +2,13 @@
 #include <iostream>
 #include <iomanip>
 #include <limits>
+#include "BlockView.h"
 
 using namespace std;
 
+// Blocks read per backwards step when scanning history newest first
+const size_t HISTORY_SCAN_CHUNK = 256;
+
 // Clear screen function for better UI
 void explorerClearScreen() {
     #ifdef _WIN32
@@ -55,8 +59,8 @@ void Explorer::showExplorerMenu(const std::string& currentWalletAddress) const {
                 std::cout << "\n---------- Blockchain Summary ----------" << std::endl;
                 std::cout << "Blockchain Height: " << getBlockCount() << " blocks" << std::endl;
                 std::cout << "Total Transactions: " << getTransactionCount() << std::endl;
-                std::cout << "Total Supply: " << blockchain->getTotalSupply() << " coins" << std::endl;
-                std::cout << "Current Mining Reward: " << blockchain->getCurrentMiningReward() << " coins" << std::endl;
+                std::cout << "Total Supply: " << formatAmount(blockchain->getTotalSupply()) << " coins" << std::endl;
+                std::cout << "Current Mining Reward: " << formatAmount(blockchain->getCurrentMiningReward()) << " coins" << std::endl;
                 std::cout << "Number of Unique Addresses: " << balanceMap->getAllBalances().size() << std::endl;
                 
                 // Display latest block info
@@ -132,8 +136,8 @@ void Explorer::showExplorerMenu(const std::string& currentWalletAddress) const {
 }
 
 // Get balance for an address
-double Explorer::getAddressBalance(const std::string& address) const {
-    double balance = 0.0;
+Amount Explorer::getAddressBalance(const std::string& address) const {
+    Amount balance = 0;
     if (balanceMap) {
         balanceMap->getBalance(address, balance);
     }
@@ -145,7 +149,7 @@ Block Explorer::getBlockByNumber(size_t blockNumber) const {
     if (blockNumber >= blockchain->getChainSize()) {
         throw std::runtime_error("Block number out of range");
     }
-    return blockchain->getBlock(blockNumber);
+    return *blockchain->getBlock(blockNumber);
 }
 
 // Get the total number of blocks
@@ -157,13 +161,13 @@ size_t Explorer::getBlockCount() const {
 size_t Explorer::getTransactionCount() const {
     size_t count = 0;
     
-    // Count confirmed transactions
+    // Count confirmed transactions; the headers carry the counts
     for (size_t i = 0; i < blockchain->getChainSize(); i++) {
-        count += blockchain->getBlock(i).transactions.size();
+        count += blockchain->getBlockHeader(i).transactionCount;
     }
     
     // Add pending transactions
-    count += blockchain->getMempool().size();
+    count += blockchain->getMempoolSize();
     
     return count;
 }
@@ -172,7 +176,7 @@ size_t Explorer::getTransactionCount() const {
 void Explorer::displayAddressDetails(const std::string& address) const {
     cout << "===== Address Information =====" << endl;
     cout << "Address: " << address << endl;
-    cout << "Balance: " << getAddressBalance(address) << " $CLST" << endl;
+    cout << "Balance: " << formatAmount(getAddressBalance(address)) << " $CLST" << endl;
     
     // Display transactions
     cout << "\nRecent Transactions:" << endl;
@@ -186,7 +190,7 @@ void Explorer::displayAddressDetails(const std::string& address) const {
             cout << "Hash: " << tx.hash.substr(0, 10) << "..." << endl;
             cout << "  " << (tx.sender == address ? "Sent to: " : "Received from: ")
                  << (tx.sender == address ? tx.receiver : tx.sender) << endl;
-            cout << "  Amount: " << tx.amount << endl;
+            cout << "  Amount: " << formatAmount(tx.amount) << endl;
             cout << "  Status: Pending" << endl;
             foundTransactions = true;
         }
@@ -197,18 +201,38 @@ void Explorer::displayAddressDetails(const std::string& address) const {
     size_t displayCount = 0;
     const size_t MAX_DISPLAY = 10;
     
-    // Scan the blockchain from newest to oldest
-    for (int i = blockchain->getChainSize() - 1; i >= 0 && displayCount < MAX_DISPLAY; i--) {
-        const Block& block = blockchain->getBlock(i);
+    // Scan the blockchain from newest to oldest. Stored block views are
+    // read oldest first, so each chunk's matches are collected per block
+    // and printed newest block first; only matching transactions are copied.
+    size_t end = blockchain->getChainSize();
+    while (end > 0 && displayCount < MAX_DISPLAY) {
+        size_t begin = end > HISTORY_SCAN_CHUNK ? end - HISTORY_SCAN_CHUNK : 0;
+        std::vector<std::pair<int, std::vector<Transaction>>> matches;
+        bool read = db->forEachBlockView(begin, end - 1, [&](const BlockView& block) {
+            std::vector<Transaction> blockMatches;
+            for (const auto& tx : block.transactions) {
+                if (tx.sender.equals(address) || tx.receiver.equals(address)) {
+                    blockMatches.push_back(tx.toTransaction());
+                }
+            }
+            if (!blockMatches.empty()) {
+                matches.emplace_back(block.blockNumber, std::move(blockMatches));
+            }
+            return true;
+        });
+        if (!read) {
+            cout << "Error reading blocks: " << db->getLastError() << endl;
+            break;
+        }
         
-        for (const auto& tx : block.transactions) {
-            if (tx.sender == address || tx.receiver == address) {
+        for (auto match = matches.rbegin(); match != matches.rend() && displayCount < MAX_DISPLAY; ++match) {
+            for (const auto& tx : match->second) {
                 cout << "----------------------------" << endl;
                 cout << "Hash: " << tx.hash.substr(0, 10) << "..." << endl;
                 cout << "  " << (tx.sender == address ? "Sent to: " : "Received from: ")
                      << (tx.sender == address ? tx.receiver : tx.sender) << endl;
-                cout << "  Amount: " << tx.amount << endl;
-                cout << "  Status: Confirmed (Block #" << block.blockNumber << ")" << endl;
+                cout << "  Amount: " << formatAmount(tx.amount) << endl;
+                cout << "  Status: Confirmed (Block #" << match->first << ")" << endl;
                 
                 displayCount++;
                 foundTransactions = true;
@@ -216,6 +240,7 @@ void Explorer::displayAddressDetails(const std::string& address) const {
                 if (displayCount >= MAX_DISPLAY) break;
             }
         }
+        end = begin;
     }
     
     if (!foundTransactions) {
@@ -228,38 +253,38 @@ void Explorer::displayTransactionDetails(const std::string& txHash) const {
     bool found = false;
     
     // Check mempool first
-    for (const auto& tx : blockchain->getMempool()) {
-        if (tx.hash == txHash) {
-            cout << "===== Transaction Information =====" << endl;
-            cout << "Hash: " << tx.hash << endl;
-            cout << "Sender: " << tx.sender << endl;
-            cout << "Receiver: " << tx.receiver << endl;
-            cout << "Amount: " << tx.amount << endl;
-            cout << "Status: Pending" << endl;
-            found = true;
-            break;
-        }
+    if (const Transaction* pending = blockchain->findMempoolTransaction(txHash)) {
+        const auto& tx = *pending;
+        cout << "===== Transaction Information =====" << endl;
+        cout << "Hash: " << tx.hash << endl;
+        cout << "Sender: " << tx.sender << endl;
+        cout << "Receiver: " << tx.receiver << endl;
+        cout << "Amount: " << formatAmount(tx.amount) << endl;
+        cout << "Status: Pending" << endl;
+        found = true;
     }
     
     // Then check the blockchain
-    if (!found) {
-        for (size_t i = 0; i < blockchain->getChainSize(); i++) {
-            const Block& block = blockchain->getBlock(i);
-            for (const auto& tx : block.transactions) {
-                if (tx.hash == txHash) {
+    // Then check the blockchain, comparing hashes in the stored views
+    size_t chainSize = blockchain->getChainSize();
+    if (!found && chainSize > 0) {
+        db->forEachBlockView(0, chainSize - 1, [&](const BlockView& block) {
+            for (const auto& view : block.transactions) {
+                if (view.hash.equals(txHash)) {
+                    Transaction tx = view.toTransaction();
                     cout << "===== Transaction Information =====" << endl;
                     cout << "Hash: " << tx.hash << endl;
                     cout << "Sender: " << tx.sender << endl;
                     cout << "Receiver: " << tx.receiver << endl;
-                    cout << "Amount: " << tx.amount << endl;
+                    cout << "Amount: " << formatAmount(tx.amount) << endl;
                     cout << "Status: Confirmed" << endl;
                     cout << "Block: #" << block.blockNumber << endl;
                     found = true;
                     break;
                 }
             }
-            if (found) break;
-        }
+            return !found;
+        });
     }
     
     if (!found) {
@@ -287,7 +312,7 @@ void Explorer::displayBlockDetails(size_t blockNumber) const {
                 cout << "  " << tx.hash.substr(0, 10) << "... | " 
                      << tx.sender.substr(0, 10) << "... -> " 
                      << tx.receiver.substr(0, 10) << "... | " 
-                     << tx.amount << endl;
+                     << formatAmount(tx.amount) << endl;
             }
         }
     } catch (const std::exception& e) {
@@ -303,9 +328,9 @@ void Explorer::displayLatestBlocks(size_t count) const {
     size_t start = (chainSize > count) ? chainSize - count : 0;
     
     for (size_t i = chainSize - 1; i >= start; i--) {
-        const Block& block = blockchain->getBlock(i);
+        const BlockHeader& block = blockchain->getBlockHeader(i);
         cout << "Block #" << block.blockNumber << " | Hash: " << block.hash.substr(0, 15) << "..." << endl;
-        cout << "  Transactions: " << block.transactions.size() << " | Timestamp: " << block.timestamp << endl;
+        cout << "  Transactions: " << block.transactionCount << " | Timestamp: " << block.timestamp << endl;
         cout << "----------------------------" << endl;
         
         if (i == 0) break; // Avoid underflow
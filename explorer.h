@@ -22,7 +22,7 @@ public:
     void showExplorerMenu(const std::string& currentWalletAddress = "") const;
     
     // Simple data retrieval methods
-    double getAddressBalance(const std::string& address) const;
+    Amount getAddressBalance(const std::string& address) const;
     Block getBlockByNumber(size_t blockNumber) const;
     size_t getBlockCount() const;
     size_t getTransactionCount() const;
@@ -1,44 +1,263 @@
 #include "sha.h"
-#include <sstream>
-#include <iomanip>
+#include <algorithm>
 #include <cstring>
 #include <openssl/sha.h>
 #include <openssl/evp.h>
 
+const uint32_t SHA256::INITIAL_STATE[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+const uint32_t SHA256::ROUND_CONSTANTS[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
 SHA256::SHA256() {
     // Initialize OpenSSL
     OpenSSL_add_all_digests();
+    reset();
 }
-// Wrapper function for easier hashing
-std::string computeSHA256(const std::string& message) {
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256_CTX sha256;
-    SHA256_Init(&sha256);
-    SHA256_Update(&sha256, message.c_str(), message.length());
-    SHA256_Final(hash, &sha256);
+
+void SHA256::reset() {
+    for (int i = 0; i < 8; i++) {
+        h[i] = INITIAL_STATE[i];
+    }
+    buffer.clear();
+    totalLength = 0;
+    finalized = false;
+}
+
+void SHA256::update(const std::vector<uint8_t>& data) {
+    if (finalized) {
+        reset();
+    }
+    totalLength += data.size();
+    buffer.insert(buffer.end(), data.begin(), data.end());
+    
+    // Absorb every complete block, keep the remainder for later
+    size_t offset = 0;
+    while (buffer.size() - offset >= 64) {
+        processBlock(buffer.data() + offset);
+        offset += 64;
+    }
+    buffer.erase(buffer.begin(), buffer.begin() + offset);
+}
+
+void SHA256::update(const std::string& data) {
+    update(std::vector<uint8_t>(data.begin(), data.end()));
+}
+
+void SHA256::pad() {
+    uint64_t bitLength = totalLength * 8;
+    buffer.push_back(0x80);
+    while (buffer.size() % 64 != 56) {
+        buffer.push_back(0x00);
+    }
+    for (int i = 7; i >= 0; i--) {
+        buffer.push_back(static_cast<uint8_t>(bitLength >> (i * 8)));
+    }
+}
+
+std::vector<uint8_t> SHA256::finalize() {
+    if (!finalized) {
+        pad();
+        for (size_t offset = 0; offset < buffer.size(); offset += 64) {
+            processBlock(buffer.data() + offset);
+        }
+        buffer.clear();
+        finalized = true;
+    }
+    
+    std::vector<uint8_t> digest(32);
+    for (int i = 0; i < 8; i++) {
+        digest[4 * i] = static_cast<uint8_t>(h[i] >> 24);
+        digest[4 * i + 1] = static_cast<uint8_t>(h[i] >> 16);
+        digest[4 * i + 2] = static_cast<uint8_t>(h[i] >> 8);
+        digest[4 * i + 3] = static_cast<uint8_t>(h[i]);
+    }
+    return digest;
+}
+
+std::string SHA256::finalizeHex() {
+    std::vector<uint8_t> bytes = finalize();
+    SHA256Digest digest{};
+    std::copy(bytes.begin(), bytes.end(), digest.begin());
+    return digestToHex(digest);
+}
+
+std::string SHA256::hash(const std::string& data) {
+    SHA256 sha;
+    sha.update(data);
+    return sha.finalizeHex();
+}
+
+std::string SHA256::hash(const std::vector<uint8_t>& data) {
+    SHA256 sha;
+    sha.update(data);
+    return sha.finalizeHex();
+}
+
+void SHA256::processBlock(const uint8_t* block) {
+    compress(h, block);
+}
+
+void SHA256::compress(uint32_t state[8], const uint8_t* block) {
+    uint32_t w[64];
+    for (int t = 0; t < 16; t++) {
+        w[t] = (static_cast<uint32_t>(block[4 * t]) << 24) |
+               (static_cast<uint32_t>(block[4 * t + 1]) << 16) |
+               (static_cast<uint32_t>(block[4 * t + 2]) << 8) |
+               static_cast<uint32_t>(block[4 * t + 3]);
+    }
+    for (int t = 16; t < 64; t++) {
+        w[t] = sigma1(w[t - 2]) + w[t - 7] + sigma0(w[t - 15]) + w[t - 16];
+    }
     
-    // Convert to hex string
-    std::stringstream ss;
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], hh = state[7];
+    for (int t = 0; t < 64; t++) {
+        uint32_t t1 = hh + Sigma1(e) + ch(e, f, g) + ROUND_CONSTANTS[t] + w[t];
+        uint32_t t2 = Sigma0(a) + maj(a, b, c);
+        hh = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
     }
     
-    return ss.str();
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += hh;
+}
+
+uint32_t SHA256::rightRotate(uint32_t value, uint32_t count) {
+    return (value >> count) | (value << (32 - count));
+}
+
+uint32_t SHA256::ch(uint32_t x, uint32_t y, uint32_t z) {
+    return (x & y) ^ (~x & z);
+}
+
+uint32_t SHA256::maj(uint32_t x, uint32_t y, uint32_t z) {
+    return (x & y) ^ (x & z) ^ (y & z);
+}
+
+uint32_t SHA256::sigma0(uint32_t x) {
+    return rightRotate(x, 7) ^ rightRotate(x, 18) ^ (x >> 3);
+}
+
+uint32_t SHA256::sigma1(uint32_t x) {
+    return rightRotate(x, 17) ^ rightRotate(x, 19) ^ (x >> 10);
+}
+
+uint32_t SHA256::Sigma0(uint32_t x) {
+    return rightRotate(x, 2) ^ rightRotate(x, 13) ^ rightRotate(x, 22);
+}
+
+uint32_t SHA256::Sigma1(uint32_t x) {
+    return rightRotate(x, 6) ^ rightRotate(x, 11) ^ rightRotate(x, 25);
+}
+
+SHA256Midstate::SHA256Midstate(const std::string& prefix)
+    : pendingSize(0), totalLength(prefix.size()) {
+    std::copy(SHA256::INITIAL_STATE, SHA256::INITIAL_STATE + 8, state);
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(prefix.data());
+    size_t offset = 0;
+    for (; prefix.size() - offset >= 64; offset += 64) {
+        SHA256::compress(state, bytes + offset);
+    }
+    pendingSize = prefix.size() - offset;
+    std::memcpy(pending, bytes + offset, pendingSize);
+}
+
+SHA256Digest SHA256Midstate::finalize(const char* suffix, size_t length) const {
+    // Work on a copy so the midstate can be reused for the next suffix
+    uint32_t words[8];
+    std::copy(state, state + 8, words);
+    
+    std::string tail(reinterpret_cast<const char*>(pending), pendingSize);
+    tail.append(suffix, length);
+    uint64_t bitLength = (totalLength + length) * 8;
+    tail.push_back(static_cast<char>(0x80));
+    tail.append((120 - tail.size() % 64) % 64, '\0');
+    for (int i = 7; i >= 0; i--) {
+        tail.push_back(static_cast<char>(bitLength >> (i * 8)));
+    }
+    for (size_t offset = 0; offset < tail.size(); offset += 64) {
+        SHA256::compress(words, reinterpret_cast<const uint8_t*>(tail.data()) + offset);
+    }
+    
+    SHA256Digest digest{};
+    for (int i = 0; i < 8; i++) {
+        digest[4 * i] = static_cast<uint8_t>(words[i] >> 24);
+        digest[4 * i + 1] = static_cast<uint8_t>(words[i] >> 16);
+        digest[4 * i + 2] = static_cast<uint8_t>(words[i] >> 8);
+        digest[4 * i + 3] = static_cast<uint8_t>(words[i]);
+    }
+    return digest;
+}
+
+std::string SHA256Midstate::finalizeHex(const std::string& suffix) const {
+    return digestToHex(finalize(suffix.c_str(), suffix.length()));
+}
+
+// Wrapper function for easier hashing
+std::string computeSHA256(const std::string& message) {
+    return digestToHex(computeSHA256Digest(message));
 }
 
 // Hash binary data directly
 std::string computeSHA256(const unsigned char* data, size_t length) {
-    unsigned char hash[SHA256_DIGEST_LENGTH];
+    return digestToHex(computeSHA256Digest(data, length));
+}
+
+SHA256Digest computeSHA256Digest(const std::string& message) {
+    return computeSHA256Digest(reinterpret_cast<const unsigned char*>(message.c_str()), message.length());
+}
+
+SHA256Digest computeSHA256Digest(const unsigned char* data, size_t length) {
+    SHA256Digest digest{};
     SHA256_CTX sha256;
     SHA256_Init(&sha256);
     SHA256_Update(&sha256, data, length);
-    SHA256_Final(hash, &sha256);
-    
-    // Convert to hex string
-    std::stringstream ss;
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
+    SHA256_Final(digest.data(), &sha256);
+    return digest;
+}
+
+std::string digestToHex(const SHA256Digest& digest) {
+    static const char hexDigits[] = "0123456789abcdef";
+    std::string hex(digest.size() * 2, '0');
+    for (size_t i = 0; i < digest.size(); i++) {
+        hex[2 * i] = hexDigits[digest[i] >> 4];
+        hex[2 * i + 1] = hexDigits[digest[i] & 0x0f];
+    }
+    return hex;
+}
+
+bool hasLeadingZeroNibbles(const SHA256Digest& digest, int nibbles) {
+    if (nibbles > static_cast<int>(digest.size() * 2)) {
+        return false;
     }
     
-    return ss.str();
-}
\ No newline at end of file
+    // Whole zero bytes first, then the high nibble of the next byte
+    int fullBytes = nibbles / 2;
+    for (int i = 0; i < fullBytes; i++) {
+        if (digest[i] != 0) {
+            return false;
+        }
+    }
+    if (nibbles % 2 != 0 && (digest[fullBytes] >> 4) != 0) {
+        return false;
+    }
+    return true;
+}
@@ -4,6 +4,11 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <array>
+#include <openssl/sha.h>
+
+// Raw SHA-256 digest
+typedef std::array<uint8_t, 32> SHA256Digest;
 
 class SHA256 {
 public:
@@ -14,6 +19,13 @@ public:
     std::string finalizeHex();
     static std::string hash(const std::string& data);
     static std::string hash(const std::vector<uint8_t>& data);
+    
+    // Portable compression function: absorb one 64-byte block into state.
+    // This is the scalar kernel of the multi-buffer hasher.
+    static void compress(uint32_t state[8], const uint8_t* block);
+    
+    static const uint32_t INITIAL_STATE[8];
+    static const uint32_t ROUND_CONSTANTS[64];
 
 private:
     uint32_t h[8];
@@ -35,8 +47,45 @@ private:
     static uint32_t Sigma1(uint32_t x);
 };
 
+// SHA-256 state after absorbing a fixed prefix. Finishing a copy of it with
+// different suffixes only costs the compression of the suffix bytes, which
+// is what the miner needs when only the nonce at the end changes. The state
+// is kept here rather than in OpenSSL's context, whose fields aren't public.
+class SHA256Midstate {
+public:
+    explicit SHA256Midstate(const std::string& prefix);
+    
+    // Raw view of the state, used by the multi-buffer kernels to start every
+    // lane from this midstate
+    const uint32_t* stateWords() const { return state; }
+    const unsigned char* pendingBytes() const { return pending; }
+    size_t pendingLength() const { return pendingSize; }
+    uint64_t prefixLength() const { return totalLength; }
+    
+    // Digest of prefix + suffix
+    SHA256Digest finalize(const char* suffix, size_t length) const;
+    std::string finalizeHex(const std::string& suffix) const;
+
+private:
+    uint32_t state[8];
+    unsigned char pending[64]; // Tail of the prefix that didn't fill a block
+    size_t pendingSize;
+    uint64_t totalLength;
+};
+
 // Standalone functions for hashing
 std::string computeSHA256(const std::string& message);
 std::string computeSHA256(const unsigned char* data, size_t length);
 
+// Raw digest variants, for callers that compare hashes rather than print them
+SHA256Digest computeSHA256Digest(const std::string& message);
+SHA256Digest computeSHA256Digest(const unsigned char* data, size_t length);
+
+// Lowercase hex encoding of a digest (no 0x prefix)
+std::string digestToHex(const SHA256Digest& digest);
+
+// Check the difficulty target on the raw bytes: true if the hex form of the
+// digest would start with at least `nibbles` '0' characters
+bool hasLeadingZeroNibbles(const SHA256Digest& digest, int nibbles);
+
 #endif // SHA256_H
@@ -0,0 +1,293 @@
+#include "sha_multibuffer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Widest kernel (AVX2)
+const size_t MAX_LANES = 8;
+
+// State is stored word-major across lanes: state[word * lanes + lane]
+typedef void (*CompressFunction)(uint32_t* state, const uint8_t* const* blocks);
+
+struct Kernel {
+    const char* name;
+    size_t lanes;
+    CompressFunction compress;
+};
+
+void compressScalar(uint32_t* state, const uint8_t* const* blocks) {
+    SHA256::compress(state, blocks[0]);
+}
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SHA_MULTIBUFFER_X86 1
+#include <cpuid.h>
+
+// GCC vector extensions; the target attribute on the kernels below decides
+// whether these lower to SSE or AVX2 instructions
+typedef uint32_t Vec4 __attribute__((vector_size(16)));
+typedef uint32_t Vec8 __attribute__((vector_size(32)));
+
+#define MB_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define MB_SIGMA0(x) (MB_ROTR(x, 7) ^ MB_ROTR(x, 18) ^ ((x) >> 3))
+#define MB_SIGMA1(x) (MB_ROTR(x, 17) ^ MB_ROTR(x, 19) ^ ((x) >> 10))
+#define MB_BIG_SIGMA0(x) (MB_ROTR(x, 2) ^ MB_ROTR(x, 13) ^ MB_ROTR(x, 22))
+#define MB_BIG_SIGMA1(x) (MB_ROTR(x, 6) ^ MB_ROTR(x, 11) ^ MB_ROTR(x, 25))
+
+template <typename Vec, size_t LANES>
+inline __attribute__((always_inline)) void compressLanes(uint32_t* state, const uint8_t* const* blocks) {
+    // Transpose the big-endian message words so each vector holds one word
+    // from every lane
+    Vec w[16];
+    for (int t = 0; t < 16; t++) {
+        uint32_t words[LANES];
+        for (size_t lane = 0; lane < LANES; lane++) {
+            const uint8_t* p = blocks[lane] + 4 * t;
+            words[lane] = (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+                          (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+        }
+        std::memcpy(&w[t], words, sizeof(Vec));
+    }
+
+    Vec v[8];
+    std::memcpy(v, state, sizeof(v));
+    Vec a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5], g = v[6], h = v[7];
+
+    for (int t = 0; t < 64; t++) {
+        Vec wt;
+        if (t < 16) {
+            wt = w[t];
+        } else {
+            wt = MB_SIGMA1(w[(t - 2) & 15]) + w[(t - 7) & 15] + MB_SIGMA0(w[(t - 15) & 15]) + w[t & 15];
+            w[t & 15] = wt;
+        }
+        Vec t1 = h + MB_BIG_SIGMA1(e) + ((e & f) ^ (~e & g)) + SHA256::ROUND_CONSTANTS[t] + wt;
+        Vec t2 = MB_BIG_SIGMA0(a) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    v[0] += a; v[1] += b; v[2] += c; v[3] += d;
+    v[4] += e; v[5] += f; v[6] += g; v[7] += h;
+    std::memcpy(state, v, sizeof(v));
+}
+
+__attribute__((target("avx2"))) void compressAVX2(uint32_t* state, const uint8_t* const* blocks) {
+    compressLanes<Vec8, 8>(state, blocks);
+}
+
+__attribute__((target("sse4.1"))) void compressSSE41(uint32_t* state, const uint8_t* const* blocks) {
+    compressLanes<Vec4, 4>(state, blocks);
+}
+#endif
+
+// Standard SHA-256 padding for a message of messageBytes total bytes
+void appendPadding(std::string& buffer, uint64_t messageBytes) {
+    buffer.push_back(static_cast<char>(0x80));
+    size_t zeros = (120 - buffer.size() % 64) % 64;
+    buffer.append(zeros, '\0');
+    uint64_t bitLength = messageBytes * 8;
+    for (int i = 7; i >= 0; i--) {
+        buffer.push_back(static_cast<char>(bitLength >> (i * 8)));
+    }
+}
+
+// Hash up to kernel.lanes padded messages that all start from `initial`.
+// Lanes finish independently; a finished lane keeps compressing an idle
+// block but its digest has already been taken.
+void runLanes(const Kernel& kernel, const uint32_t* initial, const std::string* padded,
+              size_t count, SHA256Digest* digests) {
+    static const uint8_t idleBlock[64] = {0};
+    alignas(32) uint32_t state[8 * MAX_LANES];
+    const uint8_t* blocks[MAX_LANES];
+    size_t blockCount[MAX_LANES];
+    size_t maxBlocks = 0;
+
+    for (size_t lane = 0; lane < kernel.lanes; lane++) {
+        for (int word = 0; word < 8; word++) {
+            state[word * kernel.lanes + lane] = initial[word];
+        }
+        blockCount[lane] = lane < count ? padded[lane].size() / 64 : 0;
+        if (blockCount[lane] > maxBlocks) {
+            maxBlocks = blockCount[lane];
+        }
+    }
+
+    for (size_t block = 0; block < maxBlocks; block++) {
+        for (size_t lane = 0; lane < kernel.lanes; lane++) {
+            blocks[lane] = block < blockCount[lane]
+                ? reinterpret_cast<const uint8_t*>(padded[lane].data()) + 64 * block
+                : idleBlock;
+        }
+        kernel.compress(state, blocks);
+
+        for (size_t lane = 0; lane < count; lane++) {
+            if (blockCount[lane] != block + 1) {
+                continue;
+            }
+            for (int word = 0; word < 8; word++) {
+                uint32_t value = state[word * kernel.lanes + lane];
+                digests[lane][4 * word] = static_cast<uint8_t>(value >> 24);
+                digests[lane][4 * word + 1] = static_cast<uint8_t>(value >> 16);
+                digests[lane][4 * word + 2] = static_cast<uint8_t>(value >> 8);
+                digests[lane][4 * word + 3] = static_cast<uint8_t>(value);
+            }
+        }
+    }
+}
+
+void hashWithKernel(const Kernel& kernel, const std::string* messages, size_t count, SHA256Digest* digests) {
+    thread_local std::string padded[MAX_LANES];
+    for (size_t first = 0; first < count; first += kernel.lanes) {
+        size_t group = std::min(kernel.lanes, count - first);
+        for (size_t lane = 0; lane < group; lane++) {
+            padded[lane].assign(messages[first + lane]);
+            appendPadding(padded[lane], messages[first + lane].size());
+        }
+        runLanes(kernel, SHA256::INITIAL_STATE, padded, group, digests + first);
+    }
+}
+
+// Every kernel this CPU can run, widest first. The scalar kernel runs
+// anywhere and comes last.
+std::vector<Kernel> supportedKernelList() {
+    std::vector<Kernel> kernels;
+#ifdef SHA_MULTIBUFFER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.push_back({"avx2", 8, compressAVX2});
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        kernels.push_back({"sse4.1", 4, compressSSE41});
+    }
+#endif
+    kernels.push_back({"scalar", 1, compressScalar});
+    return kernels;
+}
+
+// The widest kernel wins. sha_test checks every kernel against OpenSSL and
+// reports their throughput.
+Kernel selectKernel() {
+    return supportedKernelList().front();
+}
+
+// With the SHA extensions OpenSSL hashes one message faster than the
+// vector kernels hash eight, but it can't resume from a midstate
+bool hasSHAExtensions() {
+#ifdef SHA_MULTIBUFFER_X86
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return (ebx & bit_SHA) != 0;
+    }
+#endif
+    return false;
+}
+
+bool findKernel(const std::string& name, Kernel& kernel) {
+    for (const auto& candidate : supportedKernelList()) {
+        if (name == candidate.name) {
+            kernel = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void hashSuffixesWithKernel(const Kernel& kernel, const SHA256Midstate& midstate, const std::string* suffixes,
+                            size_t count, SHA256Digest* digests) {
+    if (kernel.lanes == 1) {
+        for (size_t i = 0; i < count; i++) {
+            digests[i] = midstate.finalize(suffixes[i].c_str(), suffixes[i].size());
+        }
+        return;
+    }
+    
+    thread_local std::string padded[MAX_LANES];
+    for (size_t first = 0; first < count; first += kernel.lanes) {
+        size_t group = std::min(kernel.lanes, count - first);
+        for (size_t lane = 0; lane < group; lane++) {
+            // Bytes of the prefix that did not fill a whole block yet come
+            // first, then the suffix, padded for the full message length
+            const std::string& suffix = suffixes[first + lane];
+            padded[lane].assign(reinterpret_cast<const char*>(midstate.pendingBytes()), midstate.pendingLength());
+            padded[lane] += suffix;
+            appendPadding(padded[lane], midstate.prefixLength() + suffix.size());
+        }
+        runLanes(kernel, midstate.stateWords(), padded, group, digests + first);
+    }
+}
+
+const Kernel& activeKernel() {
+    static const Kernel kernel = selectKernel();
+    return kernel;
+}
+
+} // namespace
+
+size_t SHA256MultiBuffer::laneCount() {
+    return activeKernel().lanes;
+}
+
+const char* SHA256MultiBuffer::kernelName() {
+    return activeKernel().name;
+}
+
+std::vector<std::string> SHA256MultiBuffer::supportedKernels() {
+    std::vector<std::string> names;
+    for (const auto& kernel : supportedKernelList()) {
+        names.push_back(kernel.name);
+    }
+    return names;
+}
+
+void SHA256MultiBuffer::hash(const std::string* messages, size_t count, SHA256Digest* digests) {
+    static const bool useOpenSSL = hasSHAExtensions();
+    const Kernel& kernel = activeKernel();
+    if (useOpenSSL || kernel.lanes == 1) {
+        // OpenSSL's single-lane code beats the portable kernel everywhere
+        // and the vector ones with SHA extensions; no padding copy either
+        for (size_t i = 0; i < count; i++) {
+            digests[i] = computeSHA256Digest(messages[i]);
+        }
+        return;
+    }
+    hashWithKernel(kernel, messages, count, digests);
+}
+
+std::vector<SHA256Digest> SHA256MultiBuffer::hash(const std::vector<std::string>& messages) {
+    std::vector<SHA256Digest> digests(messages.size());
+    hash(messages.data(), messages.size(), digests.data());
+    return digests;
+}
+
+void SHA256MultiBuffer::hashSuffixes(const SHA256Midstate& midstate, const std::string* suffixes,
+                                     size_t count, SHA256Digest* digests) {
+    hashSuffixesWithKernel(activeKernel(), midstate, suffixes, count, digests);
+}
+
+bool SHA256MultiBuffer::hashWith(const std::string& kernelName, const std::string* messages, size_t count,
+                                 SHA256Digest* digests) {
+    Kernel kernel;
+    if (!findKernel(kernelName, kernel)) {
+        return false;
+    }
+    hashWithKernel(kernel, messages, count, digests);
+    return true;
+}
+
+bool SHA256MultiBuffer::hashSuffixesWith(const std::string& kernelName, const SHA256Midstate& midstate,
+                                         const std::string* suffixes, size_t count, SHA256Digest* digests) {
+    Kernel kernel;
+    if (!findKernel(kernelName, kernel)) {
+        return false;
+    }
+    hashSuffixesWithKernel(kernel, midstate, suffixes, count, digests);
+    return true;
+}
@@ -0,0 +1,41 @@
+#ifndef SHA_MULTIBUFFER_H
+#define SHA_MULTIBUFFER_H
+
+#include <string>
+#include <vector>
+#include "sha.h"
+
+// Multi-buffer SHA-256: hashes several independent messages at once, one
+// message per SIMD lane (8 lanes with AVX2, 4 with SSE4.1). The widest
+// kernel the CPU supports is picked on first use, with the portable
+// SHA256::compress as the fallback. Whole messages go through OpenSSL
+// instead on CPUs with SHA extensions or without a vector kernel.
+// sha_test checks every kernel against OpenSSL and benchmarks them.
+class SHA256MultiBuffer {
+public:
+    // Messages hashed per kernel pass (1 for the scalar fallback)
+    static size_t laneCount();
+    
+    // Name of the selected kernel: "avx2", "sse4.1" or "scalar"
+    static const char* kernelName();
+    // Every kernel this CPU can run, selected one first
+    static std::vector<std::string> supportedKernels();
+    
+    // digests[i] = SHA-256(messages[i])
+    static void hash(const std::string* messages, size_t count, SHA256Digest* digests);
+    static std::vector<SHA256Digest> hash(const std::vector<std::string>& messages);
+    
+    // digests[i] = SHA-256(prefix + suffixes[i]), continuing from the
+    // midstate of the shared prefix
+    static void hashSuffixes(const SHA256Midstate& midstate, const std::string* suffixes,
+                             size_t count, SHA256Digest* digests);
+    
+    // The same through a named kernel instead of the selected one, for tests
+    // and benchmarks. Return false if this CPU can't run it.
+    static bool hashWith(const std::string& kernelName, const std::string* messages, size_t count,
+                         SHA256Digest* digests);
+    static bool hashSuffixesWith(const std::string& kernelName, const SHA256Midstate& midstate,
+                                 const std::string* suffixes, size_t count, SHA256Digest* digests);
+};
+
+#endif // SHA_MULTIBUFFER_H
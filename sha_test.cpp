@@ -0,0 +1,142 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "sha.h"
+#include "sha_multibuffer.h"
+
+// Checks every SHA-256 kernel this CPU can run byte-for-byte against
+// OpenSSL, then reports the throughput of each. Exits non-zero on a mismatch.
+
+namespace {
+
+// Deterministic filler so failures reproduce
+std::string makeMessage(size_t length, size_t seed) {
+    std::string message(length, '\0');
+    for (size_t i = 0; i < length; i++) {
+        message[i] = static_cast<char>((seed * 31 + i * 7) & 0xff);
+    }
+    return message;
+}
+
+// Lengths 0..192 cover every padding boundary up to three blocks; the
+// longer ones run many blocks through lanes of different lengths
+std::vector<std::string> testMessages() {
+    std::vector<std::string> messages;
+    for (size_t length = 0; length <= 192; length++) {
+        messages.push_back(makeMessage(length, length));
+    }
+    for (size_t length : {255, 256, 257, 1000, 4096}) {
+        messages.push_back(makeMessage(length, length));
+    }
+    return messages;
+}
+
+bool checkMessages(const std::string& kernel) {
+    std::vector<std::string> messages = testMessages();
+    std::vector<SHA256Digest> digests(messages.size());
+    SHA256MultiBuffer::hashWith(kernel, messages.data(), messages.size(), digests.data());
+    for (size_t i = 0; i < messages.size(); i++) {
+        if (digests[i] != computeSHA256Digest(messages[i])) {
+            std::cerr << "FAIL: " << kernel << " kernel, " << messages[i].size() << " byte message" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Prefixes around the block boundary with suffixes of every nonce length and
+// beyond, as the miner's midstate layout produces them
+bool checkSuffixes(const std::string& kernel) {
+    for (size_t prefixLength : {0, 1, 55, 56, 63, 64, 65, 119, 128, 300}) {
+        std::string prefix = makeMessage(prefixLength, prefixLength + 1);
+        SHA256Midstate midstate(prefix);
+        std::vector<std::string> suffixes;
+        for (size_t length = 0; length <= 80; length++) {
+            suffixes.push_back(makeMessage(length, length + 3));
+        }
+        
+        std::vector<SHA256Digest> digests(suffixes.size());
+        SHA256MultiBuffer::hashSuffixesWith(kernel, midstate, suffixes.data(), suffixes.size(), digests.data());
+        for (size_t i = 0; i < suffixes.size(); i++) {
+            SHA256Digest expected = computeSHA256Digest(prefix + suffixes[i]);
+            if (digests[i] != expected || midstate.finalize(suffixes[i].c_str(), suffixes[i].size()) != expected) {
+                std::cerr << "FAIL: " << kernel << " kernel, " << prefixLength << " byte prefix with "
+                          << suffixes[i].size() << " byte suffix" << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Megabytes per second hashing block-header sized messages for about
+// half a second
+template <typename HashBatch>
+double measureThroughput(const std::vector<std::string>& messages, HashBatch hashBatch) {
+    std::vector<SHA256Digest> digests(messages.size());
+    // One untimed pass so page faults and cold caches don't count
+    hashBatch(digests.data());
+    
+    size_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::steady_clock::duration::zero();
+    while (elapsed < std::chrono::milliseconds(500)) {
+        hashBatch(digests.data());
+        bytes += messages.size() * messages[0].size();
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    return bytes / std::chrono::duration<double>(elapsed).count() / (1024 * 1024);
+}
+
+} // namespace
+
+int main() {
+    std::vector<std::string> kernels = SHA256MultiBuffer::supportedKernels();
+    std::cout << "Selected kernel: " << SHA256MultiBuffer::kernelName() << std::endl;
+    
+    bool passed = true;
+    for (const auto& kernel : kernels) {
+        bool ok = checkMessages(kernel) && checkSuffixes(kernel);
+        std::cout << (ok ? "PASS: " : "FAIL: ") << kernel << " kernel matches OpenSSL" << std::endl;
+        passed = passed && ok;
+    }
+    if (!passed) {
+        return 1;
+    }
+    
+    std::vector<std::string> messages(1024, std::string(100, 'x'));
+    std::vector<std::string> nonces;
+    for (size_t i = 0; i < 1024; i++) {
+        nonces.push_back(std::to_string(1000000 + i));
+    }
+    SHA256Midstate midstate(std::string(300, 'x'));
+    
+    std::cout << "\nThroughput on " << messages[0].size() << " byte messages:" << std::endl;
+    double openssl = measureThroughput(messages, [&](SHA256Digest* digests) {
+        for (size_t i = 0; i < messages.size(); i++) {
+            digests[i] = computeSHA256Digest(messages[i]);
+        }
+    });
+    std::cout << "  openssl (one at a time): " << static_cast<int>(openssl) << " MB/s" << std::endl;
+    for (const auto& kernel : kernels) {
+        double throughput = measureThroughput(messages, [&](SHA256Digest* digests) {
+            SHA256MultiBuffer::hashWith(kernel, messages.data(), messages.size(), digests);
+        });
+        std::cout << "  " << kernel << ": " << static_cast<int>(throughput) << " MB/s" << std::endl;
+    }
+    
+    std::cout << "\nNonce suffixes after a 300 byte midstate:" << std::endl;
+    for (const auto& kernel : kernels) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<SHA256Digest> digests(nonces.size());
+        size_t hashed = 0;
+        while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500)) {
+            SHA256MultiBuffer::hashSuffixesWith(kernel, midstate, nonces.data(), nonces.size(), digests.data());
+            hashed += nonces.size();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "  " << kernel << ": " << static_cast<long long>(hashed / seconds / 1000) << "k hashes/s" << std::endl;
+    }
+    return 0;
+}
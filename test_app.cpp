@@ -65,7 +65,7 @@ int main(int argc, char* argv[]) {
         blockchain.setDatabase(db.get());
         try {
             blockchain.loadFromDatabase();
-            std::cout << "Loaded " << blockchain.getChain().size() << " blocks from database." << std::endl;
+            std::cout << "Loaded " << blockchain.getChainSize() << " blocks from database." << std::endl;
         } catch (const std::exception& e) {
             std::cerr << "Error loading blockchain from database: " << e.what() << std::endl;
             return 1;
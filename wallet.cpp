@@ -18,19 +18,6 @@
 #include <fstream>
 #include <filesystem>
 
-// Helper function to split string by delimiter (local to wallet.cpp)
-namespace wallet_internal {
-    std::vector<std::string> splitString(const std::string& str, char delim) {
-        std::vector<std::string> parts;
-        std::stringstream ss(str);
-        std::string part;
-        while (std::getline(ss, part, delim)) {
-            parts.push_back(part);
-        }
-        return parts;
-    }
-}
-
 // Add helper to sanitize host:port for filename
 std::string sanitizeForFilename(const std::string& input) {
     std::string result = input;
@@ -42,18 +29,18 @@ std::string sanitizeForFilename(const std::string& input) {
     return result;
 }
 
-Wallet::Wallet() : balance(0.0), db(nullptr), nodeHost(""), nodePort(0) {
+Wallet::Wallet() : balance(0), db(nullptr), nodeHost(""), nodePort(0) {
     generateKeyPair();
     saveToIniFile();
 }
 
-Wallet::Wallet(BlockchainDB* database) : balance(0.0), db(database), nodeHost(""), nodePort(0) {
+Wallet::Wallet(BlockchainDB* database) : balance(0), db(database), nodeHost(""), nodePort(0) {
     generateKeyPair();
     saveToIniFile();
 }
 
 Wallet::Wallet(const std::string& host, int port, BlockchainDB* database) 
-    : balance(0.0), db(database), nodeHost(host), nodePort(port) {
+    : balance(0), db(database), nodeHost(host), nodePort(port) {
     
     std::string walletFilePath = getNodeWalletFilePath();
     std::cout << "Looking for wallet file: " << walletFilePath << std::endl;
@@ -92,10 +79,10 @@ std::string Wallet::getAddress() const {
     return address;
 }
 
-double Wallet::getBalance() const {
+Amount Wallet::getBalance() const {
     // If we have a database connection, synchronize balance first
     if (db) {
-        double dbBalance = 0.0;
+        Amount dbBalance = 0;
         // Note: const_cast needed because this method is const but we need to update balance
         if (db->getBalance(address, dbBalance)) {
             const_cast<Wallet*>(this)->synchronizeBalance(dbBalance);
@@ -120,32 +107,26 @@ std::string Wallet::signMessage(const std::string& message) const {
 }
 
 bool Wallet::verifySignature(const std::string& message, const std::string& signature, const std::string& publicKeyOrAddress) {
-    std::cout << "DEBUG - Static verify signature called with:" << std::endl;
-    std::cout << "  Message: " << message << std::endl;
-    std::cout << "  Signature: " << (signature.length() > 20 ? signature.substr(0, 20) + "..." : signature) << std::endl;
-    std::cout << "  Public Key/Address: " << publicKeyOrAddress << std::endl;
-
-    // Call the global verification function
-    bool result = ::verifySignature(message, signature, publicKeyOrAddress);
-    std::cout << "Signature verification result: " << (result ? "SUCCESS" : "FAILED") << std::endl;
-    return result;
+    // Call the global verification function; it runs on the validation
+    // thread pool, so failures are logged by the caller instead of here
+    return ::verifySignature(message, signature, publicKeyOrAddress);
 }
 
-bool Wallet::sendMoney(double amount, const std::string& receiverAddress, Transaction& transaction) {
+bool Wallet::sendMoney(Amount amount, const std::string& receiverAddress, Transaction& transaction) {
     if (amount <= 0) {
         std::cerr << "ERROR: Cannot send non-positive amount" << std::endl;
         return false;
     }
     
     if (balance < amount) {
-        std::cerr << "ERROR: Insufficient funds. Balance: " << balance << " $CLST, Trying to send: " << amount << " $CLST" << std::endl;
+        std::cerr << "ERROR: Insufficient funds. Balance: " << formatAmount(balance) << " $CLST, Trying to send: " << formatAmount(amount) << " $CLST" << std::endl;
         return false;
     }
     
     std::cout << "\n===== Creating Transaction =====" << std::endl;
     std::cout << "  Sender address: " << address << std::endl;
     std::cout << "  Receiver address: " << receiverAddress << std::endl;
-    std::cout << "  Amount: " << amount << std::endl;
+    std::cout << "  Amount: " << formatAmount(amount) << std::endl;
     
     transaction = Transaction(address, receiverAddress, amount);
     std::cout << "  Transaction hash: " << transaction.hash << std::endl;
@@ -157,20 +138,20 @@ bool Wallet::sendMoney(double amount, const std::string& receiverAddress, Transa
     saveToIniFile();
     
     std::cout << "Transaction successful!" << std::endl;
-    std::cout << "  Sent: " << amount << " $CLST to " << receiverAddress << std::endl;
-    std::cout << "  New balance: " << balance << " $CLST" << std::endl;
+    std::cout << "  Sent: " << formatAmount(amount) << " $CLST to " << receiverAddress << std::endl;
+    std::cout << "  New balance: " << formatAmount(balance) << " $CLST" << std::endl;
     
     return true;
 }
 
-void Wallet::receiveMoney(double amount) {
+void Wallet::receiveMoney(Amount amount) {
     if (amount <= 0) {
         std::cerr << "ERROR: Cannot receive non-positive amount" << std::endl;
         return;
     }
     
     balance += amount;
-    std::cout << "Received " << amount << " $CLST. New balance: " << balance << " $CLST" << std::endl;
+    std::cout << "Received " << formatAmount(amount) << " $CLST. New balance: " << formatAmount(balance) << " $CLST" << std::endl;
     saveToIniFile();
 }
 
@@ -264,7 +245,7 @@ bool Wallet::saveToIniFile() const {
     file << "private_key=" << privKey;  // Note: privKey already includes a newline
     file << "public_key=" << publicKey << std::endl;
     file << "address=" << address << std::endl;
-    file << "balance=" << balance << std::endl;
+    file << "balance=" << formatAmount(balance) << std::endl;
 
     file.close();
     std::cout << "Wallet saved to " << getIniFilePath() << std::endl;
@@ -307,7 +288,9 @@ bool Wallet::loadFromIniFile(const std::string& walletAddress) {
                 } else if (key == "address") {
                     address = value;
                 } else if (key == "balance") {
-                    balance = std::stod(value);
+                    if (!parseAmount(value, balance)) {
+                        balance = 0;
+                    }
                 }
             }
         }
@@ -356,41 +339,21 @@ std::vector<Transaction> Wallet::getTransactionHistory() const {
     std::vector<Transaction> history;
     if (!db) return history;
     
-    // Get all transaction keys for this wallet
-    auto keys = db->getAllKeys("tx:");
-    
-    for (const auto& key : keys) {
-        std::string txData;
-        if (db->get(key, txData)) {
-            // Parse transaction data
-            std::vector<std::string> parts = wallet_internal::splitString(txData, '|');
-            
-            if (parts.size() >= 7) {
-                Transaction tx(
-                    parts[0], // sender
-                    parts[1], // senderPublicKey
-                    parts[2], // receiver
-                    std::stod(parts[3]), // amount
-                    parts[5], // hash
-                    parts[6], // signature
-                    std::stoull(parts[4]) // timestamp
-                );
-                
-                // Only add transactions where this wallet is sender or receiver
-                if (tx.sender == address || tx.receiver == address) {
-                    history.push_back(tx);
-                }
-            }
+    // Filter on the stored bytes; only matching transactions are copied out
+    db->forEachTransactionView([&](const TransactionView& tx) {
+        if (tx.sender.equals(address) || tx.receiver.equals(address)) {
+            history.push_back(tx.toTransaction());
         }
-    }
+        return true;
+    });
     
     return history;
 }
 
-void Wallet::synchronizeBalance(double newBalance) {
+void Wallet::synchronizeBalance(Amount newBalance) {
     // Update the in-memory balance to match database value
     balance = newBalance;
-    std::cout << "Wallet " << address << " balance synchronized to " << balance << std::endl;
+    std::cout << "Wallet " << address << " balance synchronized to " << formatAmount(balance) << std::endl;
 }
 
 // Get wallet file path based on node info
@@ -471,11 +434,9 @@ bool Wallet::loadFromHostPort() {
                 // Handle balance line 
                 else if (line.find("balance=") == 0) {
                     inPrivateKey = false;
-                    try {
-                        balance = std::stod(line.substr(8)); // Skip "balance="
-                    } catch (const std::exception& e) {
-                        std::cerr << "Error parsing balance: " << e.what() << std::endl;
-                        balance = 0.0;
+                    if (!parseAmount(line.substr(8), balance)) { // Skip "balance="
+                        std::cerr << "Error parsing balance: " << line.substr(8) << std::endl;
+                        balance = 0;
                     }
                 }
                 // Still in private key block
@@ -491,11 +452,9 @@ bool Wallet::loadFromHostPort() {
                 address = line.substr(8);
             }
             else if (line.find("balance=") == 0) {
-                try {
-                    balance = std::stod(line.substr(8));
-                } catch (const std::exception& e) {
-                    std::cerr << "Error parsing balance: " << e.what() << std::endl;
-                    balance = 0.0;
+                if (!parseAmount(line.substr(8), balance)) {
+                    std::cerr << "Error parsing balance: " << line.substr(8) << std::endl;
+                    balance = 0;
                 }
             }
         }
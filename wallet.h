@@ -14,7 +14,7 @@ private:
     EC_KEY* key_pair;
     std::string address;
     std::string publicKey;
-    double balance;
+    Amount balance;       // In base units
     BlockchainDB* db;  // Database connection for transactions
     std::string nodeHost;  // Host address for this wallet's node
     int nodePort;          // Port for this wallet's node
@@ -37,13 +37,13 @@ public:
     
     std::string getPublicKeyHex() const;
     std::string getAddress() const;
-    double getBalance() const;
+    Amount getBalance() const;
     
     std::string signMessage(const std::string& message) const;
     static bool verifySignature(const std::string& message, const std::string& signature, const std::string& publicKeyOrAddress);
     
-    bool sendMoney(double amount, const std::string& receiverAddress, Transaction& transaction);
-    void receiveMoney(double amount);
+    bool sendMoney(Amount amount, const std::string& receiverAddress, Transaction& transaction);
+    void receiveMoney(Amount amount);
 
     // Database operations (for transactions only)
     void setDatabase(BlockchainDB* database);
@@ -51,7 +51,7 @@ public:
     std::vector<Transaction> getTransactionHistory() const;
 
     // Method to synchronize wallet balance with the database
-    void synchronizeBalance(double newBalance);
+    void synchronizeBalance(Amount newBalance);
     
     // Set node information and try to load wallet based on host:port
     void setNodeInfo(const std::string& host, int port);